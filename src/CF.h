@@ -28,6 +28,64 @@ lora_txpower=23
 
 # Valid entries are 433, 866, 915
 lora_freq=915
+
+# When the in memory observation queue is full
+# 0 = Move only the oldest observation to the N2S file (default)
+# 1 = Move all observations and LoRa relay messages to the N2S file
+obs_overflow=0
+
+# Publish observations as batched FSB events instead of one FS event per minute
+# 0 = FS events (default), 1 = FSB events
+obs_batch=0
+
+# Observation encoding sent to Particle and saved to the N2S file. The SD log is always JSON
+# 0 = JSON FS/FSB events (default), 1 = base64 binary FSX events (batched when obs_batch=1)
+obs_format=0
+
+# Seconds between observations, made on UTC boundaries that are a multiple of this
+# Must divide 3600 evenly, 0 = 60 (default)
+obs_interval=0
+
+# Wind speed and direction samples per second, 1, 2 or 4
+# 0 = 1 (default)
+wind_hz=0
+
+# Seconds averaged for wind gust, the highest average over any window of
+# this many seconds between observations. 0 = 3 (default)
+# WMO gust is wind_gust_secs=3 with wind_hz=4
+wind_gust_secs=0
+
+# Distance gauge outlier rejection, a reading more than this many deviations (MAD based)
+# from the running median is dropped. 0 = Off (default), 3 is typical
+dg_mad=0
+
+# A4/A5 background readings a second, each a burst of 8 readings. Decimated to one value a second
+# 1, 2, 4, 5, 8, 10 or 20, 0 = 10 (default)
+adc_hz=0
+
+# N2S backlog drain order when the network returns
+# 0 = Oldest first (default), 1 = Newest first
+n2s_lifo=0
+
+# N2S lines and seconds spent sending per transmit window, 0 = no limit
+n2s_max_recs=0
+n2s_max_secs=0
+
+# Compress N2S segments older than the one being added to, so more fits in the same space
+# 0 = Text (default), 1 = Compressed
+n2s_compress=0
+
+# N2S lines acked between saves of the send position, at most this many are resent after a reset
+# 0 = 8 (default)
+n2s_journal=0
+
+# QC limit overrides, one line per observation tag, default limits are in QC.h
+# qc_<tag>=min,max[,roc[,stuck]]
+# roc   = max change per minute from the last good value, 0 = off
+# stuck = flag after this many identical readings in a row, 0 = off
+# Example high altitude station
+# qc_bp1=500,1100,2
+# qc_bt1=-60,60,5,120
 * ======================================================================================================================
 */
 
@@ -40,4 +98,17 @@ char *cf_aes_pkey=NULL;
 long cf_aes_myiv=0;
 int cf_lora_unitid=1;
 int cf_lora_txpower=13;
-int cf_lora_freq=915;
\ No newline at end of file
+int cf_lora_freq=915;
+int cf_obs_overflow=0;
+int cf_obs_batch=0;
+int cf_obs_format=0;
+int cf_obs_interval=0;
+int cf_wind_hz=0;
+int cf_wind_gust_secs=0;
+int cf_dg_mad=0;
+int cf_adc_hz=0;
+int cf_n2s_lifo=0;
+int cf_n2s_max_recs=0;
+int cf_n2s_max_secs=0;
+int cf_n2s_compress=0;
+int cf_n2s_journal=0;
\ No newline at end of file
@@ -15,13 +15,29 @@ typedef struct {
     float    rgt2;       // rain gauge 2 total today
     float    rgp2;       // rain gauge 2 total prior
     time32_t rgts;       // rain gauge timestamp of last modification
-    unsigned long n2sfp; // sd need 2 send file position
+    unsigned long n2sfp; // sd need 2 send read position in the head N2S segment, see N2S.h Cursor journal
     unsigned long checksum;
 } EEPROM_NVM;
 EEPROM_NVM eeprom;
 int eeprom_address = 0;
 bool eeprom_valid = false;
 
+/*
+ * ======================================================================================================================
+ *  EEPROM Rain Tips - daily rain intensity and tip times from the tip rings (WRD.h). Kept in its own block with
+ *  its own checksum so adding it did not invalidate the rain totals above. Reset at 0600 UTC with them.
+ * ======================================================================================================================
+ */
+typedef struct {
+    time32_t day;        // 0600 UTC the values are for
+    float    rgi[2];     // rain gauge 1 and 2 peak 1 minute intensity today, mm/h
+    time32_t rgf[2];     // rain gauge 1 and 2 time of first tip today, 0 = none
+    time32_t rgl[2];     // rain gauge 1 and 2 time of last tip today
+    unsigned long checksum;
+} EEPROM_RAIN;
+EEPROM_RAIN eeprom_rain;
+int eeprom_rain_address = 64;   // Past EEPROM_NVM with room for it to grow
+
 /* 
  *=======================================================================================================================
  * EEPROM_ChecksumCompute()
@@ -64,6 +80,91 @@ bool EEPROM_ChecksumValid() {
   }
 }
 
+/* 
+ *=======================================================================================================================
+ * EEPROM_RainChecksumCompute()
+ *=======================================================================================================================
+ */
+unsigned long EEPROM_RainChecksumCompute() {
+  unsigned long checksum=0;
+
+  checksum += (unsigned long) eeprom_rain.day;
+  for (int g=0; g<2; g++) {
+    checksum += (unsigned long) (eeprom_rain.rgi[g] * 10);
+    checksum += (unsigned long) eeprom_rain.rgf[g];
+    checksum += (unsigned long) eeprom_rain.rgl[g];
+  }
+  return (checksum);
+}
+
+/* 
+ *=======================================================================================================================
+ * EEPROM_RainDay() - 0600 UTC that starts the rain day current_time is in
+ *=======================================================================================================================
+ */
+time32_t EEPROM_RainDay(time32_t current_time) {
+  return (current_time - ((current_time - 21600) % 86400));
+}
+
+/* 
+ *=======================================================================================================================
+ * EEPROM_RainClear() - Clear the daily rain tip values of gauge g, -1 for both
+ *=======================================================================================================================
+ */
+void EEPROM_RainClear(int g, time32_t current_time) {
+  for (int i=0; i<2; i++) {
+    if ((g == -1) || (g == i)) {
+      eeprom_rain.rgi[i] = 0.0;
+      eeprom_rain.rgf[i] = 0;
+      eeprom_rain.rgl[i] = 0;
+    }
+  }
+  eeprom_rain.day = EEPROM_RainDay(current_time);
+  eeprom_rain.checksum = EEPROM_RainChecksumCompute();
+  EEPROM.put(eeprom_rain_address, eeprom_rain);
+}
+
+/* 
+ *=======================================================================================================================
+ * EEPROM_RainInitialize() - Load the daily rain tip values, clear them if not valid or not for today
+ *=======================================================================================================================
+ */
+void EEPROM_RainInitialize(time32_t current_time) {
+  EEPROM.get(eeprom_rain_address, eeprom_rain);
+
+  if ((eeprom_rain.checksum != EEPROM_RainChecksumCompute()) || (eeprom_rain.day != EEPROM_RainDay(current_time))) {
+    Output("EEPROM RI Clear");
+    EEPROM_RainClear(-1, current_time);
+  }
+}
+
+/* 
+ *=======================================================================================================================
+ * EEPROM_RainUpdate() - Add an observation's peak intensity and first/last tip times to today's for gauge g
+ *=======================================================================================================================
+ */
+void EEPROM_RainUpdate(int g, float intensity, time32_t first, time32_t last) {
+  if (eeprom_valid) {
+    time32_t current_time = Time.now();
+
+    if (eeprom_rain.day != EEPROM_RainDay(current_time)) {
+      EEPROM_RainClear(-1, current_time);  // New rain day
+    }
+    if (first == 0) {
+      return; // No tips
+    }
+    if (intensity > eeprom_rain.rgi[g]) {
+      eeprom_rain.rgi[g] = intensity;
+    }
+    if (eeprom_rain.rgf[g] == 0) {
+      eeprom_rain.rgf[g] = first;
+    }
+    eeprom_rain.rgl[g] = last;
+    eeprom_rain.checksum = EEPROM_RainChecksumCompute();
+    EEPROM.put(eeprom_rain_address, eeprom_rain);
+  }
+}
+
 /* 
  *=======================================================================================================================
  * EEPROM_Reset() - Reset to default values
@@ -80,6 +181,7 @@ void EEPROM_Reset(time32_t current_time) {
     eeprom.n2sfp = 0;
     EEPROM_ChecksumUpdate();
     EEPROM.put(eeprom_address, eeprom);
+    EEPROM_RainClear(-1, current_time);
   }
   else {
     Output("EEPROM RESET ERROR");
@@ -102,6 +204,7 @@ void EEPROM_ClearRainTotals(time32_t current_time) {
     eeprom.n2sfp = 0;
     EEPROM_ChecksumUpdate();
     EEPROM.put(eeprom_address, eeprom);
+    EEPROM_RainClear(-1, current_time);
   }
   else {
     Output("EEPROM CLEAR ERROR");
@@ -119,6 +222,9 @@ void EEPROM_ClearRain2Totals() {
   eeprom.rgp2 = 0.0;
   EEPROM_ChecksumUpdate();
   EEPROM.put(eeprom_address, eeprom);
+  if (Time.isValid()) {
+    EEPROM_RainClear(1, Time.now());
+  }
 }
 
 /* 
@@ -194,6 +300,7 @@ void EEPROM_Initialize() {
         }
       }
     }
+    EEPROM_RainInitialize(current_time);
     eeprom_valid = true;
   }
   else {
@@ -244,18 +351,18 @@ void EEPROM_UpdateRainTotals(float rgt1, float rgt2) {
  */
 void EEPROM_SaveUnreportedRain() {
   if (raingauge1_interrupt_count || ((A4_State == A4_STATE_RAIN) && raingauge2_interrupt_count)) {
-    unsigned long rgds;     // rain gauge delta seconds, seconds since last rain gauge observation logged
-    unsigned long rg2ds = 0;     // rain gauge delta seconds, seconds since last rain gauge observation logged
+    uint64_t rgms;          // rain gauge delta ms, since last rain gauge observation logged
+    uint64_t rg2ms = 0;     // rain gauge delta ms, since last rain gauge observation logged
     float rain2 = 0.0;
 
     float rain = raingauge1_interrupt_count * 0.2;
-    rgds = (System.millis()-raingauge1_interrupt_stime)/1000;  // seconds since last rain gauge observation logged
-    rain = (isnan(rain) || (rain < QC_MIN_RG) || (rain > ((rgds / 60) * QC_MAX_RG)) ) ? QC_ERR_RG : rain;
+    rgms = System.millis()-raingauge1_interrupt_stime;  // ms since last rain gauge observation logged
+    rain = (isnan(rain) || (rain < QC_MIN_RG) || (rain > QC_MAX_RG_MS(rgms)) ) ? QC_ERR_RG : rain;
     
     if (A4_State == A4_STATE_RAIN) {
       rain2 = raingauge2_interrupt_count * 0.2;
-      rg2ds = (System.millis()-raingauge2_interrupt_stime)/1000;  // seconds since last rain gauge observation logged
-      rain2 = (isnan(rain2) || (rain2 < QC_MIN_RG) || (rain2 > ((rg2ds / 60) * QC_MAX_RG)) ) ? QC_ERR_RG : rain2;
+      rg2ms = System.millis()-raingauge2_interrupt_stime;  // ms since last rain gauge observation logged
+      rain2 = (isnan(rain2) || (rain2 < QC_MIN_RG) || (rain2 > QC_MAX_RG_MS(rg2ms)) ) ? QC_ERR_RG : rain2;
     }
 
     EEPROM_UpdateRainTotals(rain, rain2);
@@ -320,4 +427,16 @@ void EEPROM_Dump() {
 
   sprintf (Buffer32Bytes, " CSC:%lu", checksum);
   Output (Buffer32Bytes);
+
+  EEPROM.get(eeprom_rain_address, eeprom_rain);
+  for (int g=0; g<2; g++) {
+    sprintf (Buffer32Bytes, " RI%d:%d.%d", g+1, (int)eeprom_rain.rgi[g], (int)(eeprom_rain.rgi[g]*10)%10);
+    Output (Buffer32Bytes);
+    sprintf (Buffer32Bytes, " RF%d:%lu", g+1, (unsigned long) eeprom_rain.rgf[g]);
+    Output (Buffer32Bytes);
+    sprintf (Buffer32Bytes, " RL%d:%lu", g+1, (unsigned long) eeprom_rain.rgl[g]);
+    Output (Buffer32Bytes);
+  }
+  sprintf (Buffer32Bytes, " RCS:%lu/%lu", eeprom_rain.checksum, EEPROM_RainChecksumCompute());
+  Output (Buffer32Bytes);
 }
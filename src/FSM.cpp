@@ -411,6 +411,23 @@ PRODUCT_VERSION(1);
  *  tmsms3  Tinovi Multi Level Soil Moisture Soil Sensor 3 vwc
  *  tmsms4  Tinovi Multi Level Soil Moisture Soil Sensor 4 vwc
  * 
+ * Publish to Particle - Batched observations when obs_batch=1 in CONFIG.TXT
+ *  Event Name: FSB
+ *  Event Variables:
+ *  at      timestamp of the first observation in the batch
+ *  hth     health of the first observation in the batch
+ *  obs     array of observations, each has the FS event variables except at, plus
+ *    to    seconds from at to this observation's timestamp
+ *    hth   only included when it differs from the batch hth
+ *  To get back FS records: at = batch at + to, hth = entry hth or batch hth
+ * 
+ * Publish to Particle - Binary observations when obs_format=1 in CONFIG.TXT
+ *  Event Name: FSX
+ *  Event Data: base64 of one or more binary records, more than one when obs_batch=1
+ *  Record layout and value scaling are documented in OBS.h (Binary observations)
+ *  Sensors are identified by their obs_schema[] index, the record starts with OBS_SCHEMA_ID
+ *  N2S file lines are the base64 data followed by ",FSX"
+ * 
  * State of Health - Variables included with transmitted sensor readings
  *  bcs  = Battery Charger Status
  *  bpc  = Battery Percent Charge
@@ -530,15 +547,20 @@ PRODUCT_VERSION(1);
  * ========================================================
  * Collecting Wind Data
  * ========================================================
- * Wind_SampleSpeed() - Return a wind speed based on how many interrupts and duration between calls to this function
- * Wind_SampleDirection() - Talk i2c to the AS5600 sensor and get direction
- * Wind_TakeReading() - Call this function every second. It calls wind direction and wind speed functions. Then saves samples in a circular buffer of 60 buckets.
+ * Wind_SampleSpeed() - Return a wind speed based on the time between anemometer interrupts since the last call to this function
+ * Wind_SampleRaw() - Talk i2c to the AS5600 sensor and get the raw angle count 0-4095
+ * Wind_SampleDirection() - Wind_SampleRaw() in degrees
+ * Wind_TakeReading() - Called wind_hz times a second by the sampler thread, SMP_Thread(). It calls wind direction and wind speed functions.
+ *   Each sub sample feeds the gust tracker, each second the sub samples are averaged in to a circular buffer of 60 buckets.
+ *   Sub samples the sampler missed are left out, seconds with none are saved as invalid buckets and skipped by the functions below.
  *
  * Creating the Wind Oobservations
  * Wind_DirectionVector() - Uses the 60 sample buckets of wind direction where speed is greater than zero to compute and return a wind vector.
+ *   The NS and EW vector sums are kept up to date by Wind_BucketSet() as each bucket is replaced, using the Wind_Sin() table.
  * Wind_SpeedAverage() - Use the 60 sample buckets of wind speed to return a wind speed average.
- * Wind_GustUpdate() - Uses the most current highest 3 consecutive samples of wind speed from the 60 samples. The 3 samples are then averaged for wind gust. 
- *   Variables wind.gust and wind.gust_directionare set by this function. 
+ * Wind_GustUpdate() - Takes the peak gust since the last observation. The gust tracker averages each rolling window of gust.n sub samples
+ *   (wind_gust_secs * wind_hz) as they arrive and keeps the highest, with the vector direction of that window.
+ *   Variables wind.gust, wind.gust_direction and wind.gust_ts are set by this function. 
  *   Call this function before calling Wind_Gust() and Wind_GustDirection()
  * Wind_Gust() - Returns wind.gust
  * Wind_GustDirection() - Returns wind.gust_direction
@@ -578,7 +600,7 @@ PRODUCT_VERSION(1);
  * ======================================================================================================================
  */
 #define DELAY_NO_RTC               60000    // Loop delay when we have no valided RTC
-#define OBSERVATION_INTERVAL       60000    // 60000 = 1 minute
+#define OBSERVATION_INTERVAL       60000    // 60000 = 1 minute, default for CONFIG.TXT obs_interval
 #define DEFAULT_OBS_TRANSMIT_INTERVAL 15    // Transmit observations every N minutes Set to 15 for 15min Transmits
 
 /*
@@ -659,7 +681,6 @@ unsigned long SystemStatusBits = SSB_PWRON; // Set bit 1 to 1 for initial value
 bool JustPoweredOn = true;    // Used to clear SystemStatusBits set during power on device discovery
 bool SendSystemInformation = true; // Send System Information to Particle Cloud. True means we will send at boot.
 
-uint64_t lastOBS = 0;         // time of next observation
 int countdown = 600;          // Exit station monitor/mode - when countdown reaches 0
                               // Protects against burnt out pin or forgotten jumper
 
@@ -684,8 +705,8 @@ SdFat SD;                               // File system object.
 File SD_fp;
 char SD_obsdir[] = "/OBS";              // Store our observations in this directory. At Poewer on it is created if not exist
 bool SD_exists = false;                 // Set to true if SD card found at boot
-char SD_n2s_file[] = "N2SOBS.TXT";      // Need To Send Observation file
-uint32_t SD_n2s_max_filesz = 512 * 60 * 48;  // Keep a little over 2 days. When it fills, it is deleted and we start over.
+char SD_n2s_file[] = "N2SOBS.TXT";      // Need To Send Observation file before N2S segments, moved in to /N2S at power on
+uint32_t SD_n2s_max_filesz = 512 * 60 * 48;  // Keep a little over 2 days. When it fills, the oldest N2S segment is dropped.
 
 char SD_sim_file[] = "SIM.TXT";         // File used to set Ineternal or External sim configuration
 char SD_simold_file[] = "SIMOLD.TXT";   // SIM.TXT renamed to this after sim configuration set
@@ -728,14 +749,17 @@ PMIC pmic;
 #include "WRD.h"                  // Wind Rain Distance
 #include "EP.h"                   // EEPROM
 #include "SDC.h"                  // SD Card
+#include "PR.h"                   // Publish Rate limiter
+#include "N2S.h"                  // Need to Send Observations
 #include "OBS.h"                  // Do Observation Processing
 #include "SM.h"                   // Station Monitor
 #include "PS.h"                   // Particle Support Functions
+#include "SCH.h"                  // Scheduler for background work
 #include "INFO.h"                 // Station Information
 
 /*
  * ======================================================================================================================
- * HeartBeat() - Burns 250 ms and part of our loop delay timing
+ * HeartBeat() - Burns 250 ms, used to refresh the watchdog before long calls. SCH_HeartBeat() does it in the background
  * ======================================================================================================================
  */
 void HeartBeat() {
@@ -752,39 +776,11 @@ void HeartBeat() {
 
 /*
  * ======================================================================================================================
- * BackGroundWork() - Take Sensor Reading, Check LoRa for Messages, Delay 1 Second for use as timming delay            
+ * BackGroundWork() - Run the SCH.h tasks (sensor sampling, LoRa, heartbeat, LED) for 1 Second for use as timming delay
  * ======================================================================================================================
  */
 void BackGroundWork() {
-  // Anything that needs sampling every second add below. Example Wind Speed and Direction, StreamGauge
-
-  uint64_t OneSecondFromNow = System.millis() + 1000;
-
-  Wind_TakeReading();
-
-  if (A4_State == A4_STATE_DISTANCE) {
-    DistanceGauge_TakeReading();
-  }
-
-  if (PM25AQI_exists) {
-    pm25aqi_TakeReading();
-  }
-
-  HeartBeat();  // Provides a 250ms delay
-
-  if (LORA_exists) {
-    lora_msg_poll(); // Provides a 750ms delay
-  }
-
-  int64_t TimeRemaining = (OneSecondFromNow - System.millis());
-  if ((TimeRemaining > 0) && (TimeRemaining < 1000)) {
-    delay (TimeRemaining);
-  }
-
-  if (TurnLedOff) {   // Turned on by rain gauge interrupt handler
-    digitalWrite(LED_PIN, LOW);  
-    TurnLedOff = false;
-  }
+  SCH_Run(1000);
 }
 
 // You must use SEMI_AUTOMATIC or MANUAL mode so the battery is properly reconnected on
@@ -857,7 +853,8 @@ void setup() {
   SD_initialize();
 
   // Report if we have Need to Send Observations
-  if (SD_exists && SD.exists(SD_n2s_file)) {
+  N2S_Initialize();
+  if (N2S_Exists()) {
     SystemStatusBits |= SSB_N2S; // Turn on Bit
     Output("N2S:Exists");
   }
@@ -866,14 +863,19 @@ void setup() {
     Output("N2S:None");
   }
 
+  OBS_QC_Init();  // QC limits from QC.h, CONFIG.TXT may override
   if (SD_exists && SD.exists(CF_NAME)) {
     SD_ReadConfigFile();
+    OBS_QC_ReadConfig();
   }
   else {
     sprintf(msgbuf, "CF:NO %s", CF_NAME); Output (msgbuf);
     Output(msgbuf);
   }
 
+  // Observation queue from the heap that is left, before any thread takes its stack
+  OBS_Alloc();
+
   // Display EEPROM Information 
   EEPROM_Dump();
 
@@ -1027,9 +1029,12 @@ void setup() {
   if (Time.isValid()) {
     // We now a a valid clock so we can initialize the EEPROM and make an observation
     EEPROM_Initialize();
+    N2S_Journal_Recover();
     //OBS_Do();     
   }
-  ws_refresh = true;
+
+  // Sample wind and distance from here on, independent of loop()
+  SMP_Start();
 }
 
 /*
@@ -1057,21 +1062,18 @@ void loop() {
       if (!eeprom_valid) {
         // We now a a valid clock so we can initialize the EEPROM
         EEPROM_Initialize();
+        N2S_Journal_Recover();
       }
 
       if (SendSystemInformation && Particle.connected()) {
         INFO_Do(); // Function sets SendSystemInformation back to false.
       }
 
-      // If we waited too long for acks while publishing and this threw off our wind observations.
-      // In that code ws_refresh was set to true for us to reinit wind data.
-      if (ws_refresh) {
-        Output ("WS Refresh Required");
-        Wind_Distance_Air_Initialize();
-      }
+      // Send the next N2S line if the drain thread has one ready
+      N2S_Drain_Poll();
 
       // Perform an Observation, save in OBS structure, Write to SD
-      if ( (System.millis() - lastOBS) > OBSERVATION_INTERVAL) {  // 1 minute
+      if (OBS_Due()) {  // On the UTC minute, or obs_interval
         I2C_Check_Sensors(); // Make sure Sensors are online
         OBS_Do();
       }
@@ -1113,6 +1115,7 @@ void loop() {
       if (System.millis() - LastTransmitTime > (3600 * 1000)) {  
         // Been too long with out a network connection, lets reboot
         Output("1HR W/O NW: Rebooting");
+        N2S_Close();
         delay(5000);
         System.reset();
       }
@@ -1168,9 +1171,6 @@ void loop() {
 		  Particle.connect();
 
       DailyRebootCountDownTimer = cf_reboot_countdown_timer; // Reset count incase reboot fails
-
-      // We need to reinitialize our wind readings before we can move on.
-      Wind_Distance_Air_Initialize();
     }   
 
 #if (PLATFORM_ID == PLATFORM_BORON) || (PLATFORM_ID == PLATFORM_MSOM)
@@ -1207,6 +1207,7 @@ void loop() {
       }
 
       Output("Powering Down");
+      N2S_Close();
 
       OLED_sleepDisplay();
       delay(5000);
@@ -1236,9 +1237,6 @@ void loop() {
 		  Cellular.on();
 
 		  Particle.connect();
-
-      // We need to reinitialize our wind readings before we can move on.
-      Wind_Distance_Air_Initialize();
     }
 #endif
   }
@@ -41,9 +41,7 @@ bool INFO_Do() {
   writer.name("type").value("muon");
 #endif
 
-  sprintf (Buffer32Bytes, "%d-%02d-%02dT%02d:%02d:%02d",
-    Time.year(ts), Time.month(ts), Time.day(ts),
-    Time.hour(ts), Time.minute(ts), Time.second(ts));
+  FMT_TimeStamp(ts, Buffer32Bytes);
   writer.name("at").value(Buffer32Bytes);
 
   writer.name("ver").value(VERSION_INFO);
@@ -53,10 +51,12 @@ bool INFO_Do() {
   sprintf (Buffer32Bytes,"%d-%d", System.resetReason(), System.resetReasonData());
   writer.name("rr").value(Buffer32Bytes);;
 
-  sprintf (Buffer32Bytes,"%ds", OBSERVATION_INTERVAL/1000);
+  sprintf (Buffer32Bytes,"%ds", OBS_Interval());
   writer.name("obsi").value(Buffer32Bytes);
+  writer.name("obsovr").value((unsigned int) obs_overruns); // Observation boundaries missed
   sprintf (Buffer32Bytes,"%dm", (int) obs_tx_interval);
   writer.name("obsti").value(Buffer32Bytes);
+  writer.name("obsq").value(obs_slots); // Observation slots in obs[]
 
   // Time 2 Next Transmit in Seconds
   sprintf (Buffer32Bytes, "%ds", (int) ((obs_tx_interval * 60) - ((System.millis() - LastTransmitTime)/1000)));
@@ -65,21 +65,32 @@ bool INFO_Do() {
   // Daily Reboot Countdown Timer
   writer.name("drct").value(DailyRebootCountDownTimer);
 
-  // Need 2 Send File
-  if (SD.exists(SD_n2s_file)) {
-    File fp = SD.open(SD_n2s_file, FILE_WRITE);
-    if (fp) {
-      writer.name("n2s").value(fp.size());
-      fp.close();
-    }
-    else {
-      writer.name("n2s").value(-1);
-    }
+  // Need 2 Send Segments
+  if (N2S_Exists()) {
+    writer.name("n2s").value((unsigned int) N2S_Size());
+    sprintf (Buffer32Bytes, "%lu-%lu", (unsigned long) n2s_head, (unsigned long) n2s_tail);
+    writer.name("n2sseg").value(Buffer32Bytes);
   }
   else {
     writer.name("n2s").value("NF");
   }
 
+  // Publish rate limiter, acked/failed and ack latency average/max in ms
+  sprintf (Buffer32Bytes, "%lu/%lu", (unsigned long) pr_ok, (unsigned long) pr_err);
+  writer.name("pub").value(Buffer32Bytes);
+  sprintf (Buffer32Bytes, "%lu/%lums", (unsigned long) pr_ack_avg, (unsigned long) pr_ack_max);
+  writer.name("puback").value(Buffer32Bytes);
+
+  // Scheduler task lateness, average/max/skipped periods
+  char sch[96];
+  SCH_Stats(sch);
+  writer.name("sch").value(sch);
+  writer.name("smpmiss").value((unsigned int) smp_missed); // Wind samples not taken
+  if (A4_State == A4_STATE_DISTANCE) {
+    sprintf (Buffer32Bytes, "%.1f/%lu", DistanceGauge_Spread(), (unsigned long) dg_rejects);
+    writer.name("dg").value(Buffer32Bytes);                 // Distance Gauge spread over the last minute/outliers rejected
+  }
+
 #if PLATFORM_ID == PLATFORM_ARGON
   writer.name("ps").value((digitalRead(PWR)) ? "USB" : "BATTERY");
   writer.name("bv").value(analogRead(BATT) * 0.0011224); // Battery Voltage
@@ -379,6 +390,7 @@ bool INFO_Do() {
 
   // Update INFO.TXT file
   if (SD_exists) {
+    SD_LOCK();
     File fp = SD.open(SD_INFO_FILE, FILE_WRITE | O_TRUNC); 
     if (fp) {
       fp.println(msgbuf);
@@ -404,13 +416,12 @@ bool INFO_Do() {
     result = false;
   }
 
-  // Deal with how long this took. More than likely we will always need to do a refresh of wind
+  // Deal with how long this took. Wind keeps being sampled by the sampler thread.
   time_t endTime = Time.now();
   unsigned long delta = (unsigned long)endTime-(unsigned long)ts;
   if (delta) { // More than a second
-    sprintf(buf, "INFO:EXTM=%lu,WSRefreshSet", delta);
+    sprintf(buf, "INFO:EXTM=%lu", delta);
     Output (buf);
-    ws_refresh = true;
   }
 
   return(result);
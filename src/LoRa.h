@@ -6,6 +6,8 @@
 
 // Prototyping functions to aviod compile function unknown issue.
 void SD_NeedToSend_Add(char *observation);
+void N2S_Session_Begin();
+void N2S_Session_End();
  
  /*
  * ======================================================================================================================
@@ -164,6 +166,7 @@ void lora_msgs_to_n2s() {
   if (LORA_exists) {
     LORA_MSG_RELAY_STR *m;
 
+    N2S_Session_Begin();
     for (int i=0; i< LORA_RELAY_MSGCNT; i++) {
       m = &lora_msg_relay[i];
       if (m->need2log) {
@@ -174,6 +177,7 @@ void lora_msgs_to_n2s() {
         Output (Buffer32Bytes);
       }
     }
+    N2S_Session_End();
   }
 }
 
@@ -444,15 +448,3 @@ void lora_msg_check() {
     }
   }
 }
-
-/* 
- *=======================================================================================================================
- * lora_msg_poll() -- Spend 750ms looking for LoRa Messages
- *=======================================================================================================================
- */
-void lora_msg_poll() {
-  for (int i=0; i<3; i++) {
-    lora_msg_check();
-    delay (250);
-  }
-}
\ No newline at end of file
@@ -0,0 +1,1715 @@
+/*
+ * ======================================================================================================================
+ *  N2S.h - Need to Send Observations
+ * ======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ *  The N2S store is a directory of segment files plus a manifest
+ *
+ *  /N2S/00000001.TXT ... /N2S/0000NNNN.TXT   One line per observation, "<data>,<Particle Event Type>"
+ *  /N2S/MANIFEST.TXT                         "head,tail" segment numbers
+ *
+ *  New lines go to the tail segment. When it reaches N2S_SEGMENT_SIZE a new tail is started.
+ *  When the segments hold more than SD_n2s_max_filesz bytes the head (oldest) segment is retired,
+ *  so a long outage loses the oldest hours instead of the whole backlog.
+ *  Lines are sent from the head segment, eeprom.n2sfp is the read position in the head segment (Cursor journal).
+ *
+ *  The tail segment is kept open for appending. It is not preallocated, SdFat's preAllocate() sets the file
+ *  size to the whole segment and readers would take the unwritten clusters as lines.
+ *  Lines are batched in n2s_wbuf. Outside of a session (N2S_Session_Begin/End) every line is synced
+ *  to the card as it is added. In a session lines are synced every N2S_SYNC_COUNT lines or N2S_SYNC_BYTES,
+ *  at the end of the session and before N2S is read or the device is reset.
+ * ======================================================================================================================
+ */
+#define N2S_DIR             "/N2S"
+#define N2S_MANIFEST        "/N2S/MANIFEST.TXT"
+#define N2S_SEGMENT_SIZE    (512 * 60 * 2)                          // About 2 hours of observations
+#define N2S_BLOCK_SIZE      512                                     // SD card block
+
+uint32_t n2s_head = 1;          // Oldest segment, the one we are sending from
+uint32_t n2s_tail = 1;          // Newest segment, the one we append to
+char n2s_path[32];              // Segment file name built by N2S_SegmentName()
+uint32_t n2s_bytes = 0;         // Bytes in all segments, kept under SD_n2s_max_filesz
+uint32_t n2s_seal = 1;          // Next segment the drain thread will try to seal, see Sealed segments
+volatile uint32_t n2s_drain_gen = 0; // Bumped when the send position changes under the drain thread
+
+// Prototyping functions to aviod compile function unknown issue.
+bool Particle_PublishData(const char *EventName, const char *data);
+bool OBS_Full();
+void OBS_Do();
+bool OBS_Due();
+long OBS_Secs2Due();
+
+/*
+ *=======================================================================================================================
+ * N2S_SegmentName() - Build the file name of segment seg in n2s_path
+ *=======================================================================================================================
+ */
+char *N2S_SegmentName(uint32_t seg) {
+  sprintf (n2s_path, "%s/%08lu.TXT", N2S_DIR, (unsigned long) seg);
+  return (n2s_path);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_TmpName() - Build the name of the copy of segment seg being rewritten
+ *=======================================================================================================================
+ */
+char *N2S_TmpName(uint32_t seg, char *path) {
+  sprintf (path, "%s/%08lu.TMP", N2S_DIR, (unsigned long) seg);
+  return (path);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_WriteManifest() - Save head and tail segment numbers
+ *=======================================================================================================================
+ */
+void N2S_WriteManifest() {
+  File fp = SD.open(N2S_MANIFEST, O_RDWR | O_CREAT | O_TRUNC);
+  if (fp) {
+    fp.print(n2s_head);
+    fp.print(",");
+    fp.println(n2s_tail);
+    fp.close();
+  }
+  else {
+    SystemStatusBits |= SSB_SD;  // Turn On Bit
+    Output ("N2S:MAN WR ERR");
+  }
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_ReadManifest() - Load head and tail segment numbers, return false if no valid manifest
+ *=======================================================================================================================
+ */
+bool N2S_ReadManifest() {
+  char buf[32];
+  char *comma;
+  int n;
+
+  File fp = SD.open(N2S_MANIFEST, FILE_READ);
+  if (!fp) {
+    return (false);
+  }
+  n = fp.read(buf, sizeof(buf)-1);
+  fp.close();
+  if (n <= 0) {
+    return (false);
+  }
+  buf[n] = 0;
+
+  comma = strchr(buf, ',');
+  if (comma == NULL) {
+    return (false);
+  }
+  n2s_head = HELPER_ascii2Long(buf, comma - buf);
+  n2s_tail = HELPER_ascii2Long(comma+1, strcspn(comma+1, "\r\n"));
+  if ((n2s_head == 0) || (n2s_tail < n2s_head)) {
+    n2s_head = n2s_tail = 1;
+    return (false);
+  }
+  return (true);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Exists() - Return true if there are observations needing to be sent
+ *=======================================================================================================================
+ */
+bool N2S_Exists() {
+  SD_LOCK();
+  return (SD_exists && ((n2s_head < n2s_tail) || SD.exists(N2S_SegmentName(n2s_head))));
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Size() - Return bytes in all segments
+ *=======================================================================================================================
+ */
+uint32_t N2S_Size() {
+  uint32_t size = 0;
+  SD_LOCK();
+
+  for (uint32_t seg=n2s_head; seg<=n2s_tail; seg++) {
+    File fp = SD.open(N2S_SegmentName(seg), FILE_READ);
+    if (fp) {
+      size += fp.size();
+      fp.close();
+    }
+  }
+  return (size);
+}
+
+/*
+ * ======================================================================================================================
+ *  Append handle
+ * ======================================================================================================================
+ */
+#define N2S_WBUF_SIZE       (4 * N2S_BLOCK_SIZE)   // RAM batch buffer, holds at least one full line
+#define N2S_SYNC_COUNT      16                     // In a session, sync after this many lines
+#define N2S_SYNC_BYTES      (8 * N2S_BLOCK_SIZE)   // In a session, sync after this many bytes
+
+File n2s_wfp;                   // Append handle
+uint32_t n2s_wseg = 0;          // Segment n2s_wfp has open, 0 = closed
+uint32_t n2s_wsize = 0;         // Size of segment n2s_wseg including what is in n2s_wbuf
+char n2s_wbuf[N2S_WBUF_SIZE];
+size_t n2s_wlen = 0;            // Bytes in n2s_wbuf
+int n2s_session = 0;            // N2S_Session_Begin() nesting depth
+int n2s_unsynced = 0;           // Lines added since last sync
+uint32_t n2s_unsynced_bytes = 0;
+
+/*
+ *=======================================================================================================================
+ * N2S_OpenTail() - Open the tail segment for appending if not already open, return false on error
+ *=======================================================================================================================
+ */
+bool N2S_OpenTail() {
+  if (n2s_wseg == n2s_tail) {
+    return (true);
+  }
+  if (n2s_wseg) {
+    n2s_wfp.close();
+    n2s_wseg = 0;
+  }
+
+  n2s_wfp = SD.open(N2S_SegmentName(n2s_tail), FILE_WRITE); // Open for writing at the end of the file.
+                                                            // It will be created if it doesn't already exist.
+  if (!n2s_wfp) {
+    SystemStatusBits |= SSB_SD;  // Turn On Bit - Note this will be reported on next observation
+    Output ("N2S:Open Error");
+    return (false);
+  }
+  n2s_wsize = n2s_wfp.size();
+  n2s_wseg = n2s_tail;
+  return (true);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Flush() - Write n2s_wbuf to the open segment
+ *=======================================================================================================================
+ */
+bool N2S_Flush() {
+  if (n2s_wlen == 0) {
+    return (true);
+  }
+  if (!n2s_wseg || (n2s_wfp.write((const uint8_t *) n2s_wbuf, n2s_wlen) != n2s_wlen)) {
+    SystemStatusBits |= SSB_SD;  // Turn On Bit
+    Output ("N2S:WR ERR");
+    n2s_wlen = 0;
+    return (false);
+  }
+  n2s_wlen = 0;
+  SystemStatusBits &= ~SSB_SD;  // Turn Off Bit
+  return (true);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Sync() - Get everything added to N2S on to the card
+ *=======================================================================================================================
+ */
+void N2S_Sync() {
+  SD_LOCK();
+  N2S_Flush();
+  if (n2s_wseg && !n2s_wfp.sync()) {
+    SystemStatusBits |= SSB_SD;  // Turn On Bit
+    Output ("N2S:SYNC ERR");
+  }
+  n2s_unsynced = 0;
+  n2s_unsynced_bytes = 0;
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Close() - Sync and close the append handle. Call before a reset or power down.
+ *=======================================================================================================================
+ */
+void N2S_Close() {
+  SD_LOCK();
+  N2S_Sync();
+  if (n2s_wseg) {
+    n2s_wfp.close();
+    n2s_wseg = 0;
+  }
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Session_Begin() - Start adding a group of lines, syncing is deferred until N2S_Session_End()
+ *=======================================================================================================================
+ */
+void N2S_Session_Begin() {
+  n2s_session++;
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Session_End() - End a group of lines and sync them to the card
+ *=======================================================================================================================
+ */
+void N2S_Session_End() {
+  if ((n2s_session > 0) && (--n2s_session == 0)) {
+    N2S_Sync();
+  }
+}
+
+/*
+ * ======================================================================================================================
+ *  Cursor journal - /N2S/CURSOR.LOG
+ *
+ *  The front cursor (n2s_head, eeprom.n2sfp) is appended here every n2s_journal acked lines (default
+ *  N2S_JOURNAL_EVERY), when a drain stops and whenever the cursor is reset or changes units. At power on the
+ *  newest good record is the cursor, so a reset mid drain resends at most n2s_journal lines and the EEPROM
+ *  is not written to save it. Each record is 16 bytes with a check word, a record torn by a power loss is
+ *  skipped. When the file reaches N2S_JOURNAL_MAX it is compacted to its newest record through CURSOR.NEW.
+ *  With no journal (first boot after an update) eeprom.n2sfp is used.
+ * ======================================================================================================================
+ */
+#define N2S_JOURNAL         "/N2S/CURSOR.LOG"
+#define N2S_JOURNAL_NEW     "/N2S/CURSOR.NEW"
+#define N2S_JOURNAL_EVERY   8                   // Acked lines between records when n2s_journal=0
+#define N2S_JOURNAL_MAX     (2 * N2S_BLOCK_SIZE) // Compact at this size
+#define N2S_JOURNAL_CHECK   0x4E325343UL        // "N2SC"
+
+typedef struct {
+  uint32_t        head;                 // Head segment
+  uint32_t        pos;                  // eeprom.n2sfp in the head segment
+  uint32_t        seq;                  // Record number, newest is highest
+  uint32_t        check;                // N2S_Journal_Check()
+} N2S_JOURNAL_STR;
+uint32_t n2s_journal_seq = 0;
+int n2s_journal_acks = 0;               // Acked lines since the last record
+
+/*
+ *=======================================================================================================================
+ * N2S_Journal_Check() - Check word for a journal record
+ *=======================================================================================================================
+ */
+uint32_t N2S_Journal_Check(N2S_JOURNAL_STR *j) {
+  return ((j->head * 2654435761UL) ^ (j->pos * 40503UL) ^ j->seq ^ N2S_JOURNAL_CHECK);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Journal_Commit() - Append the front cursor to the journal. No Output(), can run on the drain thread.
+ *=======================================================================================================================
+ */
+void N2S_Journal_Commit() {
+  N2S_JOURNAL_STR j;
+  File fp;
+  SD_LOCK();
+
+  if (!SD_exists) {
+    return;
+  }
+  j.head = n2s_head;
+  j.pos = eeprom.n2sfp;
+  j.seq = ++n2s_journal_seq;
+  j.check = N2S_Journal_Check(&j);
+  n2s_journal_acks = 0;
+
+  fp = SD.open(N2S_JOURNAL, O_RDWR | O_CREAT | O_AT_END);
+  if (!fp) {
+    SystemStatusBits |= SSB_SD;  // Turn On Bit
+    return;
+  }
+  if (fp.size() < N2S_JOURNAL_MAX) {
+    fp.write((const uint8_t *) &j, sizeof(j));
+    fp.close();
+    return;
+  }
+  fp.close();
+
+  // Compact, the new file holds only this record. Until it replaces the old one the old one is good.
+  fp = SD.open(N2S_JOURNAL_NEW, O_RDWR | O_CREAT | O_TRUNC);
+  if (!fp) {
+    SystemStatusBits |= SSB_SD;  // Turn On Bit
+    return;
+  }
+  fp.write((const uint8_t *) &j, sizeof(j));
+  fp.close();
+  SD.remove(N2S_JOURNAL);
+  SD.rename(N2S_JOURNAL_NEW, N2S_JOURNAL);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Journal_Ack() - A line was acked, append to the journal every n2s_journal lines
+ *=======================================================================================================================
+ */
+void N2S_Journal_Ack() {
+  if (++n2s_journal_acks >= ((cf_n2s_journal > 0) ? cf_n2s_journal : N2S_JOURNAL_EVERY)) {
+    N2S_Journal_Commit();
+  }
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Journal_Recover() - Set eeprom.n2sfp from the journal. Call after EEPROM_Initialize().
+ *=======================================================================================================================
+ */
+void N2S_Journal_Recover() {
+  N2S_JOURNAL_STR j;
+  N2S_JOURNAL_STR last;
+  File fp;
+  bool found = false;
+  SD_LOCK();
+
+  if (!SD_exists) {
+    return;
+  }
+
+  // Lost power compacting after the old journal was removed
+  if (!SD.exists(N2S_JOURNAL) && SD.exists(N2S_JOURNAL_NEW)) {
+    SD.rename(N2S_JOURNAL_NEW, N2S_JOURNAL);
+  }
+
+  fp = SD.open(N2S_JOURNAL, FILE_READ);
+  if (!fp) {
+    Output ("N2S:NO JOURNAL");
+    return;
+  }
+  while (fp.read(&j, sizeof(j)) == (int) sizeof(j)) {
+    if ((j.check == N2S_Journal_Check(&j)) && (!found || (j.seq > last.seq))) {
+      last = j;
+      found = true;
+    }
+  }
+  fp.close();
+  if (!found) {
+    Output ("N2S:JOURNAL BAD");
+    return;
+  }
+
+  // A record for an older head is from before it was retired, start of the new head
+  n2s_journal_seq = last.seq;
+  eeprom.n2sfp = (last.head == n2s_head) ? last.pos : 0;
+  sprintf (Buffer32Bytes, "N2S:JOURNAL %lu:%lu", (unsigned long) n2s_head, (unsigned long) eeprom.n2sfp);
+  Output (Buffer32Bytes);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_RetireHead() - Remove the head segment and move to the next one
+ *=======================================================================================================================
+ */
+void N2S_RetireHead() {
+  SD_LOCK();
+
+  // Reset the read position first. If we lose power before the manifest is updated we resend, not skip.
+  eeprom.n2sfp = 0;
+  N2S_Journal_Commit();
+
+  if (n2s_wseg == n2s_head) {
+    N2S_Close();
+  }
+  File fp = SD.open(N2S_SegmentName(n2s_head), FILE_READ);
+  if (fp) {
+    n2s_bytes -= (fp.size() < n2s_bytes) ? fp.size() : n2s_bytes;
+    fp.close();
+  }
+  if (SD.exists(n2s_path) && !SD.remove(n2s_path)) {
+    SystemStatusBits |= SSB_SD; // Turn On Bit
+    Output ("N2S->DEL:ERR");
+  }
+  sprintf (Buffer32Bytes, "N2S:SEG %lu RETIRED", (unsigned long) n2s_head);
+  Output (Buffer32Bytes);
+
+  if (n2s_head < n2s_tail) {
+    n2s_head++;
+  }
+  else {
+    SystemStatusBits &= ~SSB_N2S; // Turn Off Bit
+  }
+  N2S_WriteManifest();
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Initialize() - Load the manifest, move an old N2SOBS.TXT in as the head segment
+ *=======================================================================================================================
+ */
+void N2S_Initialize() {
+  if (!SD_exists) {
+    return;
+  }
+
+  if (!SD.exists(N2S_DIR) && !SD.mkdir(N2S_DIR)) {
+    Output ("N2S:MKDIR ERR");
+    SystemStatusBits |= SSB_SD;  // Turn On Bit
+    return;
+  }
+
+  if (!N2S_ReadManifest()) {
+    N2S_WriteManifest();
+  }
+
+  // Single file N2S from before segments. eeprom.n2sfp is already its read position.
+  if (SD.exists(SD_n2s_file)) {
+    if (!N2S_Exists() && SD.rename(SD_n2s_file, N2S_SegmentName(n2s_head))) {
+      Output ("N2S:MIGRATED");
+    }
+    else {
+      Output ("N2S:OLD FILE LEFT");
+    }
+  }
+
+  // Finish a segment rewrite that lost power, the copy is only complete if the segment was removed
+  char tmp[32];
+  for (uint32_t seg=n2s_head; seg<=n2s_tail; seg++) {
+    if (SD.exists(N2S_TmpName(seg, tmp))) {
+      if (SD.exists(N2S_SegmentName(seg))) {
+        SD.remove(tmp);
+      }
+      else {
+        SD.rename(tmp, n2s_path);
+      }
+      Output ("N2S:TMP FIXED");
+    }
+  }
+
+  n2s_bytes = N2S_Size();
+  n2s_seal = n2s_head;
+
+  sprintf (Buffer32Bytes, "N2S:SEG %lu-%lu", (unsigned long) n2s_head, (unsigned long) n2s_tail);
+  Output (Buffer32Bytes);
+}
+
+/*
+ *=======================================================================================================================
+ * SD_N2S_Delete() - Remove all segments
+ *=======================================================================================================================
+ */
+bool SD_N2S_Delete() {
+  bool result = true;
+  SD_LOCK();
+
+  if (SD_exists) {
+    N2S_Close();
+    for (uint32_t seg=n2s_head; seg<=n2s_tail; seg++) {
+      if (SD.exists(N2S_SegmentName(seg)) && !SD.remove(n2s_path)) {
+        result = false;
+      }
+    }
+    n2s_head = n2s_tail = n2s_tail + 1;
+    N2S_WriteManifest();
+    n2s_drain_gen++;
+    n2s_bytes = 0;
+  }
+
+  if (result) {
+    SystemStatusBits &= ~SSB_N2S; // Turn Off Bit
+    Output ("N2S->DEL:OK");
+  }
+  else {
+    Output ("N2S->DEL:ERR");
+    SystemStatusBits |= SSB_SD; // Turn On Bit
+  }
+  eeprom.n2sfp = 0;
+  N2S_Journal_Commit();
+  return (result);
+}
+
+/*
+ *=======================================================================================================================
+ * SD_NeedToSend_Add() - Append a line to the tail segment
+ *=======================================================================================================================
+ */
+void SD_NeedToSend_Add(char *observation) {
+  size_t len = strlen(observation);
+  SD_LOCK();
+
+  if (!SD_exists || ((len + 2) > N2S_WBUF_SIZE)) {
+    return;
+  }
+  if (!N2S_OpenTail()) {
+    return;
+  }
+
+  if ((n2s_wsize > 0) && ((n2s_wsize + len + 2) > N2S_SEGMENT_SIZE)) {
+    // Tail is full, start a new segment
+    N2S_Close();
+    n2s_tail++;
+    N2S_WriteManifest();
+
+    while ((n2s_head < n2s_tail) && (n2s_bytes > SD_n2s_max_filesz)) {
+      Output ("N2S:Full");
+      N2S_RetireHead();
+      n2s_drain_gen++; // Drain thread was reading the retired segment
+    }
+    if (!N2S_OpenTail()) {
+      return;
+    }
+  }
+
+  if ((n2s_wlen + len + 2) > N2S_WBUF_SIZE) {
+    N2S_Flush();
+  }
+  memcpy (n2s_wbuf + n2s_wlen, observation, len);
+  n2s_wbuf[n2s_wlen + len] = '\r';
+  n2s_wbuf[n2s_wlen + len + 1] = '\n';
+  n2s_wlen += len + 2;
+  n2s_wsize += len + 2;
+  n2s_bytes += len + 2;
+  n2s_unsynced++;
+  n2s_unsynced_bytes += len + 2;
+
+  SystemStatusBits |= SSB_N2S; // Turn on Bit that says there are entries in the N2S File
+  Output ("N2S:OBS Added");
+
+  if ((n2s_session == 0) || (n2s_unsynced >= N2S_SYNC_COUNT) || (n2s_unsynced_bytes >= N2S_SYNC_BYTES)) {
+    N2S_Sync();
+  }
+}
+
+/*
+ * ======================================================================================================================
+ *  N2S line reader - Reads a segment a 512 byte block at a time and finds lines with memchr().
+ *  Lines are handed out as pointers in to n2s_rd.buf, valid until the next N2S_Reader_Line() call.
+ * ======================================================================================================================
+ */
+typedef struct {
+  File            *fp;
+  uint32_t        pos;                  // File position of buf[0]
+  size_t          start;                // Start of unread data in buf
+  size_t          end;                  // End of data in buf
+  bool            bad;                  // Set when a line will not fit in MAX_MSGBUF_SIZE
+  char            buf[MAX_MSGBUF_SIZE + N2S_BLOCK_SIZE];
+} N2S_READER_STR;
+N2S_READER_STR n2s_rd;
+
+/*
+ *=======================================================================================================================
+ * N2S_Reader_Start() - Start reading file fp at position pos
+ *=======================================================================================================================
+ */
+void N2S_Reader_Start(File *fp, uint32_t pos) {
+  n2s_rd.fp = fp;
+  n2s_rd.pos = pos;
+  n2s_rd.start = 0;
+  n2s_rd.end = 0;
+  n2s_rd.bad = false;
+  fp->seek(pos);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Reader_Line() - Return the next line without CR LF and set next to the file position after it
+ *                     Return NULL at end of file or if the line is too long (n2s_rd.bad is set)
+ *                     A partial line at the end of the file is not returned
+ *=======================================================================================================================
+ */
+char *N2S_Reader_Line(uint32_t *next) {
+  char *line;
+  char *nl;
+  size_t len;
+  int n;
+
+  while (true) {
+    line = n2s_rd.buf + n2s_rd.start;
+    nl = (char *) memchr(line, '\n', n2s_rd.end - n2s_rd.start);
+    if (nl) {
+      len = nl - line;
+      n2s_rd.start += len + 1;
+      *next = n2s_rd.pos + n2s_rd.start;
+      if ((len > 0) && (line[len-1] == '\r')) {
+        len--;
+      }
+      if (len >= MAX_MSGBUF_SIZE) {
+        n2s_rd.bad = true;
+        return (NULL);
+      }
+      line[len] = 0;
+      return (line);
+    }
+
+    if ((n2s_rd.end - n2s_rd.start) > MAX_MSGBUF_SIZE) {  // Room for the longest line plus its CR
+      n2s_rd.bad = true;
+      return (NULL);
+    }
+
+    // Move the partial line to the front and read up to the next block boundary
+    if (n2s_rd.start) {
+      memmove(n2s_rd.buf, n2s_rd.buf + n2s_rd.start, n2s_rd.end - n2s_rd.start);
+      n2s_rd.pos += n2s_rd.start;
+      n2s_rd.end -= n2s_rd.start;
+      n2s_rd.start = 0;
+    }
+    n = N2S_BLOCK_SIZE - ((n2s_rd.pos + n2s_rd.end) % N2S_BLOCK_SIZE);
+    n = n2s_rd.fp->read(n2s_rd.buf + n2s_rd.end, n);
+    if (n <= 0) {
+      return (NULL);
+    }
+    n2s_rd.end += n;
+  }
+}
+
+/*
+ * ======================================================================================================================
+ *  Sealed segments - Compressed N2S storage (n2s_compress=1)
+ *
+ *  When the drain thread is idle it seals the segments before the tail. The text lines are rewritten as
+ *  blocks of up to N2S_LZ_RECS lines. Each line is LZ coded against the line before it in the block (the
+ *  previous minute) and itself, so keys and slow changing values become short copies. A block decodes on
+ *  its own, nothing before it is needed to resume.
+ *
+ *  Block    0xA5, lines, len (2 bytes LE), payload (len bytes), len (2 bytes LE)
+ *  Payload  For each line its length (2 bytes LE) then tokens until the line is complete
+ *             0nnnnnnn           n+1 literal bytes follow
+ *             1nnnnnnn oo oo     copy n+4 bytes from offset o (LE) in the previous line followed by this line
+ *  The len on the end lets a block be found from the end of the file.
+ *
+ *  eeprom.n2sfp in a sealed head segment is the block's file position << 8 | line in the block.
+ *  The tail segment is always text. LIFO unseals a segment back to text when it becomes the tail.
+ *  While a segment is rewritten the new copy is NNNNNNNN.TMP, N2S_Initialize() finishes or drops it.
+ *  The drain thread seals a block each time it takes SD_LOCK(), so appends and sends wait at most one block.
+ *  n2s_sealing says where it is. If the segment changes size or stops being one to seal it starts over or drops it.
+ *
+ *  tools/n2s_read prints the lines of a segment off the card, tools/test/test_n2s seals segments and reads
+ *  them back. JSON from a station with the usual sensors seals to about a third of its size (2.8x), FSX
+ *  lines about 1.5x as base64 leaves little to match.
+ * ======================================================================================================================
+ */
+#define N2S_LZ_MAGIC        0xA5        // First byte of a block, never the first byte of a text line
+#define N2S_LZ_RECS         32          // Lines per block
+#define N2S_LZ_BLOCK_MAX    8192        // Start a new block when the payload passes this
+#define N2S_LZ_HDR_SIZE     4           // Magic, lines, len
+#define N2S_LZ_HASH         1024        // Match finder hash table entries
+#define N2S_LZ_MIN          4           // Shortest copy
+#define N2S_LZ_MAX          (0x7F + N2S_LZ_MIN)
+#define N2S_LZ_LIT_MAX      0x80
+
+typedef struct {
+  File            *fp;
+  uint32_t        off;                  // File position of the block being read
+  uint16_t        len;                  // Payload length of the block
+  int             nrec;                 // Lines in the block
+  int             rec;                  // Next line in the block
+  int             skip;                 // Lines to skip when starting in the middle of a block
+  int             plen;                 // Length of the previous line at the start of win
+  bool            bad;                  // Set when the block does not decode
+  uint8_t         in[64];               // Input buffer
+  int             in_n;
+  int             in_i;
+  char            win[2 * MAX_MSGBUF_SIZE]; // Previous line followed by this line
+  int16_t         hash[N2S_LZ_HASH];
+  uint8_t         out[MAX_MSGBUF_SIZE + (MAX_MSGBUF_SIZE / N2S_LZ_LIT_MAX) + 2];
+} N2S_LZ_STR;
+N2S_LZ_STR n2s_lz;
+
+typedef struct {
+  uint32_t        seg;                  // Segment being sealed, 0 = none
+  uint32_t        size;                 // Its text size when the seal started
+  uint32_t        pos;                  // Text position of the next line to seal
+  uint32_t        boff;                 // Position of the next block in the copy, its size so far
+} N2S_SEALING_STR;
+N2S_SEALING_STR n2s_sealing;
+
+/*
+ *=======================================================================================================================
+ * N2S_LZ_IsSealed() - Return true if the open segment holds blocks
+ *=======================================================================================================================
+ */
+bool N2S_LZ_IsSealed(File *fp) {
+  fp->seek(0);
+  return (fp->read() == N2S_LZ_MAGIC);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_LZ_Hash() - Match finder hash of the 3 bytes at p
+ *=======================================================================================================================
+ */
+int N2S_LZ_Hash(const char *p) {
+  uint32_t v = ((uint8_t) p[0]) | ((uint8_t) p[1] << 8) | ((uint8_t) p[2] << 16);
+  return ((v * 2654435761UL) >> 22) & (N2S_LZ_HASH - 1);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_LZ_Literals() - Code win[from..to) as literal runs at out[o], return new o
+ *=======================================================================================================================
+ */
+int N2S_LZ_Literals(int from, int to, int o) {
+  while (from < to) {
+    int n = ((to - from) > N2S_LZ_LIT_MAX) ? N2S_LZ_LIT_MAX : (to - from);
+    n2s_lz.out[o++] = n - 1;
+    memcpy (&n2s_lz.out[o], &n2s_lz.win[from], n);
+    o += n;
+    from += n;
+  }
+  return (o);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_LZ_Encode() - Code the line at win[plen..wlen) against what is before it, return bytes in n2s_lz.out
+ *=======================================================================================================================
+ */
+int N2S_LZ_Encode(int plen, int wlen) {
+  char *w = n2s_lz.win;
+  int i = plen;
+  int lit = plen;     // Start of literals not yet coded
+  int rep = 0;        // Where the last copy would continue, lines line up with the previous minute
+  int o = 0;
+  int h, cand, len, rlen;
+
+  for (h=0; h<N2S_LZ_HASH; h++) {
+    n2s_lz.hash[h] = -1;
+  }
+  for (int p=0; (p+2)<plen; p++) {
+    n2s_lz.hash[N2S_LZ_Hash(&w[p])] = p;
+  }
+
+  while (i < wlen) {
+    len = 0;
+    if ((i+2) < wlen) {
+      h = N2S_LZ_Hash(&w[i]);
+      cand = n2s_lz.hash[h];
+      n2s_lz.hash[h] = i;
+      if (cand >= 0) {
+        while ((len < N2S_LZ_MAX) && ((i+len) < wlen) && (w[cand+len] == w[i+len])) {
+          len++;
+        }
+      }
+      rlen = 0;
+      while ((rep < i) && (rlen < N2S_LZ_MAX) && ((i+rlen) < wlen) && (w[rep+rlen] == w[i+rlen])) {
+        rlen++;
+      }
+      if (rlen > len) {
+        len = rlen;
+        cand = rep;
+      }
+    }
+    rep++;
+
+    if (len >= N2S_LZ_MIN) {
+      o = N2S_LZ_Literals(lit, i, o);
+      n2s_lz.out[o++] = 0x80 | (len - N2S_LZ_MIN);
+      n2s_lz.out[o++] = cand & 0xFF;
+      n2s_lz.out[o++] = cand >> 8;
+      for (int p=i+1; (p < (i+len)) && ((p+2) < wlen); p++) {
+        n2s_lz.hash[N2S_LZ_Hash(&w[p])] = p;
+      }
+      i += len;
+      lit = i;
+      rep = cand + len;
+    }
+    else {
+      i++;
+    }
+  }
+  return (N2S_LZ_Literals(lit, wlen, o));
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_LZ_Getc() - Next byte of the segment being read, -1 at end of file
+ *=======================================================================================================================
+ */
+int N2S_LZ_Getc() {
+  if (n2s_lz.in_i >= n2s_lz.in_n) {
+    n2s_lz.in_n = n2s_lz.fp->read(n2s_lz.in, sizeof(n2s_lz.in));
+    n2s_lz.in_i = 0;
+    if (n2s_lz.in_n <= 0) {
+      n2s_lz.in_n = 0;
+      return (-1);
+    }
+  }
+  return (n2s_lz.in[n2s_lz.in_i++]);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_LZ_Get16() - Next 2 byte little endian value, -1 at end of file
+ *=======================================================================================================================
+ */
+long N2S_LZ_Get16() {
+  int lo = N2S_LZ_Getc();
+  int hi = N2S_LZ_Getc();
+  return (((lo < 0) || (hi < 0)) ? -1 : (lo | (hi << 8)));
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_LZ_Start() - Start reading sealed segment fp at position pos (block << 8 | line)
+ *=======================================================================================================================
+ */
+void N2S_LZ_Start(File *fp, uint32_t pos) {
+  n2s_lz.fp = fp;
+  n2s_lz.off = pos >> 8;
+  n2s_lz.len = 0;
+  n2s_lz.nrec = 0;
+  n2s_lz.rec = 0;
+  n2s_lz.skip = pos & 0xFF;
+  n2s_lz.bad = false;
+  n2s_lz.in_n = 0;
+  n2s_lz.in_i = 0;
+  fp->seek(n2s_lz.off);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_LZ_Line() - Return the next line or NULL at end of file or bad block. Set next to the position after it.
+ *                 Line is in n2s_lz.win, valid until the next call.
+ *=======================================================================================================================
+ */
+char *N2S_LZ_Line(uint32_t *next) {
+  char *w = n2s_lz.win;
+  long rlen, c, src;
+  int o, n;
+
+  while (true) {
+    if (n2s_lz.rec >= n2s_lz.nrec) {
+      // Next block
+      if (n2s_lz.nrec) {
+        n2s_lz.off += N2S_LZ_HDR_SIZE + n2s_lz.len + 2;
+        n2s_lz.fp->seek(n2s_lz.off);
+        n2s_lz.in_n = n2s_lz.in_i = 0;
+      }
+      c = N2S_LZ_Getc();
+      if (c < 0) {
+        return (NULL); // End of file
+      }
+      n2s_lz.nrec = N2S_LZ_Getc();
+      rlen = N2S_LZ_Get16();
+      if ((c != N2S_LZ_MAGIC) || (n2s_lz.nrec <= 0) || (rlen < 0) || (n2s_lz.skip >= n2s_lz.nrec)) {
+        n2s_lz.bad = true;
+        return (NULL);
+      }
+      n2s_lz.len = rlen;
+      n2s_lz.rec = 0;
+      n2s_lz.plen = 0;
+    }
+
+    // Decode the line after the previous one
+    rlen = N2S_LZ_Get16();
+    if ((rlen < 0) || (rlen >= MAX_MSGBUF_SIZE)) {
+      n2s_lz.bad = true;
+      return (NULL);
+    }
+    o = n2s_lz.plen;
+    while (o < (n2s_lz.plen + rlen)) {
+      c = N2S_LZ_Getc();
+      if (c < 0) {
+        n2s_lz.bad = true;
+        return (NULL);
+      }
+      if (c & 0x80) {
+        n = (c & 0x7F) + N2S_LZ_MIN;
+        src = N2S_LZ_Get16();
+        if ((src < 0) || (src >= o) || ((o + n) > (n2s_lz.plen + rlen))) {
+          n2s_lz.bad = true;
+          return (NULL);
+        }
+        while (n--) {
+          w[o++] = w[src++]; // Byte at a time, a copy can overlap what it is making
+        }
+      }
+      else {
+        n = c + 1;
+        if ((o + n) > (n2s_lz.plen + rlen)) {
+          n2s_lz.bad = true;
+          return (NULL);
+        }
+        while (n--) {
+          if ((c = N2S_LZ_Getc()) < 0) {
+            n2s_lz.bad = true;
+            return (NULL);
+          }
+          w[o++] = c;
+        }
+      }
+    }
+
+    // This line becomes the previous line
+    memmove (w, w + n2s_lz.plen, rlen);
+    w[rlen] = 0;
+    n2s_lz.plen = rlen;
+    n2s_lz.rec++;
+
+    if (n2s_lz.rec < n2s_lz.nrec) {
+      *next = (n2s_lz.off << 8) | n2s_lz.rec;
+    }
+    else {
+      *next = (n2s_lz.off + N2S_LZ_HDR_SIZE + n2s_lz.len + 2) << 8;
+    }
+
+    if (n2s_lz.skip > 0) {
+      n2s_lz.skip--;
+      continue;
+    }
+    return (w);
+  }
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_LZ_EndBlock() - Write the block trailer and fill in its header
+ *=======================================================================================================================
+ */
+void N2S_LZ_EndBlock(File *fp, uint32_t boff, int nrec, uint16_t blen) {
+  uint8_t hdr[N2S_LZ_HDR_SIZE] = {N2S_LZ_MAGIC, (uint8_t) nrec, (uint8_t) (blen & 0xFF), (uint8_t) (blen >> 8)};
+
+  fp->write(&hdr[2], 2);
+  fp->seek(boff);
+  fp->write(hdr, N2S_LZ_HDR_SIZE);
+  fp->seekEnd();
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Replace() - Swap the rewritten copy in for segment seg. Return size change in bytes.
+ *=======================================================================================================================
+ */
+int32_t N2S_Replace(uint32_t seg, File *src, File *dst) {
+  char tmp[32];
+  int32_t delta = (int32_t) dst->size() - (int32_t) src->size();
+
+  src->close();
+  dst->close();
+  N2S_TmpName(seg, tmp);
+  if (!SD.remove(N2S_SegmentName(seg)) || !SD.rename(tmp, n2s_path)) {
+    SystemStatusBits |= SSB_SD;  // Turn On Bit
+    return (0);
+  }
+  return (delta);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Seal_Drop() - Give up the seal in progress, its segment stays text
+ *=======================================================================================================================
+ */
+void N2S_Seal_Drop() {
+  char tmp[32];
+
+  if (n2s_sealing.seg) {
+    SD.remove(N2S_TmpName(n2s_sealing.seg, tmp));
+    n2s_sealing.seg = 0;
+  }
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Seal() - Rewrite the next block of text segment seg. Called with SD_LOCK() held, the lock can be let go
+ *              between calls. Return true when seg is done, sealed or left as text.
+ *=======================================================================================================================
+ */
+bool N2S_Seal(uint32_t seg) {
+  char tmp[32];
+  char *line = NULL;
+  uint32_t next;
+  uint32_t blen = 0;
+  int nrec = 0;
+  int plen = 0;
+  int len, o;
+  uint8_t hdr[N2S_LZ_HDR_SIZE] = {0};
+  File dst;
+
+  if (n2s_sealing.seg && (n2s_sealing.seg != seg)) {
+    N2S_Seal_Drop();
+  }
+  File src = SD.open(N2S_SegmentName(seg), FILE_READ);
+  if (!src) {
+    N2S_Seal_Drop();
+    return (true);
+  }
+
+  if ((n2s_sealing.seg == seg) && (src.size() == n2s_sealing.size)) {
+    dst = SD.open(N2S_TmpName(seg, tmp), O_RDWR);
+    if (!dst || (dst.size() != n2s_sealing.boff)) {
+      src.close();
+      N2S_Seal_Drop(); // Next call starts over
+      return (false);
+    }
+  }
+  else {
+    // Start, or start over as the segment changed since the last block
+    if ((src.size() == 0) || N2S_LZ_IsSealed(&src)) {
+      src.close();
+      N2S_Seal_Drop();
+      return (true);
+    }
+    dst = SD.open(N2S_TmpName(seg, tmp), O_RDWR | O_CREAT | O_TRUNC);
+    if (!dst) {
+      src.close();
+      n2s_sealing.seg = 0;
+      return (true);
+    }
+    n2s_sealing.seg = seg;
+    n2s_sealing.size = src.size();
+    n2s_sealing.pos = 0;
+    n2s_sealing.boff = 0;
+  }
+
+  N2S_Reader_Start(&src, n2s_sealing.pos);
+  dst.seek(n2s_sealing.boff);
+  while ((nrec < N2S_LZ_RECS) && (blen < N2S_LZ_BLOCK_MAX) && ((line = N2S_Reader_Line(&next)) != NULL)) {
+    if (nrec == 0) {
+      dst.write(hdr, N2S_LZ_HDR_SIZE); // Filled in by N2S_LZ_EndBlock()
+    }
+    len = strlen(line);
+    memcpy (n2s_lz.win + plen, line, len);
+    o = N2S_LZ_Encode(plen, plen + len);
+    dst.write((uint8_t) (len & 0xFF));
+    dst.write((uint8_t) (len >> 8));
+    dst.write(n2s_lz.out, o);
+    blen += 2 + o;
+    memmove (n2s_lz.win, n2s_lz.win + plen, len);
+    plen = len;
+    nrec++;
+    n2s_sealing.pos = next;
+  }
+  if (nrec) {
+    N2S_LZ_EndBlock(&dst, n2s_sealing.boff, nrec, blen);
+    n2s_sealing.boff += N2S_LZ_HDR_SIZE + blen + 2;
+  }
+
+  if (n2s_rd.bad || !dst.sync()) {
+    // Leave it as text, the bad line drops the segment when it is sent
+    src.close();
+    dst.close();
+    N2S_Seal_Drop();
+    return (true);
+  }
+  if (line != NULL) {
+    src.close(); // More blocks to go
+    dst.close();
+    return (false);
+  }
+
+  n2s_sealing.seg = 0;
+  n2s_bytes += N2S_Replace(seg, &src, &dst); // No Output(), this runs on the drain thread
+  if (seg == n2s_head) {
+    N2S_Journal_Commit(); // The cursor is in block units now
+  }
+  return (true);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Unseal() - Rewrite sealed segment seg as text, moving eeprom.n2sfp with it. Called with SD_LOCK() held.
+ *=======================================================================================================================
+ */
+void N2S_Unseal(uint32_t seg) {
+  char tmp[32];
+  char *line;
+  uint32_t next;
+  uint32_t pos = 0;
+  uint32_t n2sfp = 0;
+  bool front = (seg == n2s_head);
+
+  File src = SD.open(N2S_SegmentName(seg), FILE_READ);
+  if (!src) {
+    return;
+  }
+  if (!N2S_LZ_IsSealed(&src)) {
+    src.close();
+    return;
+  }
+  File dst = SD.open(N2S_TmpName(seg, tmp), O_RDWR | O_CREAT | O_TRUNC);
+  if (!dst) {
+    src.close();
+    return;
+  }
+
+  N2S_LZ_Start(&src, 0);
+  while ((line = N2S_LZ_Line(&next)) != NULL) {
+    if (front && (pos == eeprom.n2sfp)) {
+      n2sfp = dst.size();
+    }
+    dst.write((const uint8_t *) line, strlen(line));
+    dst.write((const uint8_t *) "\r\n", 2);
+    pos = next;
+  }
+  if (front && (pos == eeprom.n2sfp)) {
+    n2sfp = dst.size();
+  }
+  if (n2s_lz.bad) {
+    Output ("N2S:UNSEAL BAD"); // Keep what decoded
+  }
+
+  if (!dst.sync()) {
+    src.close();
+    dst.close();
+    SD.remove(tmp);
+    return;
+  }
+  n2s_bytes += N2S_Replace(seg, &src, &dst);
+  if (front) {
+    eeprom.n2sfp = n2sfp;
+    N2S_Journal_Commit(); // The cursor is in text units now
+  }
+  sprintf (Buffer32Bytes, "N2S:SEG %lu UNSEALED", (unsigned long) seg);
+  Output (Buffer32Bytes);
+}
+
+/*
+ * ======================================================================================================================
+ *  Publishing N2S - The live queue is always sent first by OBS_PublishAll(), then N2S is drained
+ *
+ *  FIFO (n2s_lifo=0) sends oldest first from the front cursor, eeprom.n2sfp in the head segment.
+ *  It runs in the background, see N2S drain thread below.
+ *  LIFO (n2s_lifo=1) sends newest first, inline, from the back of the tail segment. The back cursor is the end of
+ *  the tail segment, each line is cut off with truncate() once it is sent, so new lines appended between
+ *  windows are always the next sent. Both ends stop when they meet.
+ *
+ *  Each transmit window is limited to n2s_max_recs lines and n2s_max_secs seconds (0 = no limit) so a large backlog
+ *  does not hold up the next observation and transmit window.
+ * ======================================================================================================================
+ */
+int n2s_sent;                   // Lines sent this window
+uint64_t n2s_window_start;      // System.millis() at start of this window
+
+/*
+ *=======================================================================================================================
+ * N2S_BudgetLeft() - Return true if this window can send another line
+ *=======================================================================================================================
+ */
+bool N2S_BudgetLeft() {
+  if ((cf_n2s_max_recs > 0) && (n2s_sent >= cf_n2s_max_recs)) {
+    Output ("N2S:MAX RECS");
+    return (false);
+  }
+  if ((cf_n2s_max_secs > 0) && ((System.millis() - n2s_window_start) >= ((uint64_t) cf_n2s_max_secs * 1000))) {
+    Output ("N2S:MAX SECS");
+    return (false);
+  }
+  return (true);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_PublishLine() - Split off the event type and publish line with one retry, return true if sent
+ *=======================================================================================================================
+ */
+bool N2S_PublishLine(char *line) {
+  // After the data is a comma and Particle Event Type ("FS", "FSX", "INFO", ...)
+  // The last comma on the line is the separator, base64 data has no commas
+  char *EventType = strrchr(line, ',');
+  if (EventType) {
+    *EventType++ = 0; // Set the comma to Null so we don't transmit to Particle what follows
+    while (*EventType == ' ') {
+      EventType++;
+    }
+  }
+  else {
+    EventType = (char *) "FS";
+  }
+
+  if (Particle_PublishData(EventType, line)) {
+    sprintf (Buffer32Bytes, "N2S[%d]%s->PUB:OK", n2s_sent++, EventType);
+    Output (Buffer32Bytes);
+    Serial_write (line);
+    return (true);
+  }
+
+  // Retry, Particle_PublishData() waits out the rate limiter's backoff
+  sprintf (Buffer32Bytes, "N2S[%d]%s->PUB:RETRY", n2s_sent, EventType);
+  Output (Buffer32Bytes);
+  Serial_write (line);
+
+  if (Particle_PublishData(EventType, line)) {
+    sprintf (Buffer32Bytes, "N2S[%d]%s->PUB:OK", n2s_sent++, EventType);
+    Output (Buffer32Bytes);
+    return (true);
+  }
+  sprintf (Buffer32Bytes, "N2S[%d]%s->PUB:ERR", n2s_sent, EventType);
+  Output (Buffer32Bytes);
+  return (false);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_ObsCheck() - Make the observation if it is time, return false if we need to get out and let loop() do it
+ *=======================================================================================================================
+ */
+bool N2S_ObsCheck() {
+  // We could be draining for a while. We don't want to miss our observation window.
+  // So make the observation and stay in the loop if we have space in the OBS array.
+  // We need to avoid a full array that would cause all observations to be saved to N2S file
+  // we are reading, a bad thing.
+  if (OBS_Due()) {
+    Output ("N2S:OBS Needed");
+    if (OBS_Full()) {
+      // need to get out of this loop and let the main loop make the needed observation
+      Output ("N2S:OBS FULL");
+      return (false);
+    }
+    I2C_Check_Sensors(); // Make sure Sensors are online
+    OBS_Do();
+  }
+  return (true);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Reader_LastLine() - Return the last line in fp before end, not before front. Set start to its file position
+ *                         Return NULL if there is no line or it is too long (n2s_rd.bad is set)
+ *=======================================================================================================================
+ */
+char *N2S_Reader_LastLine(File *fp, uint32_t front, uint32_t end, uint32_t *start) {
+  uint32_t lo;
+  int n;
+
+  n2s_rd.bad = false;
+  if (end <= front) {
+    return (NULL);
+  }
+
+  // Enough to hold the longest line and its CR LF
+  lo = ((end - front) > (MAX_MSGBUF_SIZE + 2)) ? (end - (MAX_MSGBUF_SIZE + 2)) : front;
+  fp->seek(lo);
+  n = fp->read(n2s_rd.buf, end - lo);
+  if (n != (int) (end - lo)) {
+    n2s_rd.bad = true;
+    return (NULL);
+  }
+
+  // Drop the CR LF on the end, then find the LF before the line
+  while ((n > 0) && ((n2s_rd.buf[n-1] == '\n') || (n2s_rd.buf[n-1] == '\r'))) {
+    n--;
+  }
+  n2s_rd.buf[n] = 0;
+  for (int i=n-1; i>=0; i--) {
+    if (n2s_rd.buf[i] == '\n') {
+      *start = lo + i + 1;
+      return (&n2s_rd.buf[i+1]);
+    }
+  }
+  if (lo == front) {
+    *start = front;
+    return (n2s_rd.buf);
+  }
+  n2s_rd.bad = true;
+  return (NULL);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Publish_LIFO() - Send lines newest first from the back of the tail segment
+ *=======================================================================================================================
+ */
+void N2S_Publish_LIFO() {
+  char *line;
+  uint32_t start;
+  uint32_t front;
+  SD_LOCK();
+
+  while (N2S_Exists() && N2S_BudgetLeft()) {
+    if (!N2S_OpenTail()) {
+      break;
+    }
+
+    // The front cursor is only in the tail segment when head and tail are the same segment
+    front = (n2s_head == n2s_tail) ? eeprom.n2sfp : 0;
+    line = N2S_Reader_LastLine(&n2s_wfp, front, n2s_wsize, &start);
+
+    if (line == NULL) {
+      if (n2s_rd.bad) {
+        sprintf (Buffer32Bytes, "N2S[%d]->BOR:ERR", n2s_sent);
+        Output (Buffer32Bytes);
+      }
+      // Ends have met or bad data, this segment is done
+      if (n2s_head == n2s_tail) {
+        N2S_RetireHead();
+      }
+      else {
+        n2s_bytes -= (n2s_wsize < n2s_bytes) ? n2s_wsize : n2s_bytes;
+        N2S_Close();
+        SD.remove(N2S_SegmentName(n2s_tail));
+        n2s_tail--;
+        N2S_WriteManifest();
+        N2S_Unseal(n2s_tail); // The tail is always text
+        if (n2s_seal > n2s_tail) {
+          n2s_seal = n2s_tail;
+        }
+        if (n2s_sealing.seg >= n2s_tail) {
+          N2S_Seal_Drop(); // Was sealing the new tail, it is cut from the back now
+        }
+      }
+      continue;
+    }
+
+    if (!N2S_PublishLine(line)) {
+      break;
+    }
+
+    // Cut the sent line off the back
+    if (!n2s_wfp.truncate(start)) {
+      SystemStatusBits |= SSB_SD;  // Turn On Bit
+      Output ("N2S:TRUNC ERR");
+      break;
+    }
+    n2s_bytes -= n2s_wsize - start;
+    n2s_wsize = start;
+    n2s_wfp.seekEnd();
+
+    if (!N2S_ObsCheck()) {
+      break;
+    }
+  }
+  if (n2s_wseg) {
+    n2s_wfp.seekEnd(); // Reading moved the file position, appends go on the end
+  }
+  N2S_Sync();
+}
+
+/*
+ * ======================================================================================================================
+ *  N2S drain thread - FIFO lines are read on their own thread so loop() keeps its 1 second sampling
+ *
+ *  n2s_ring is a single producer / single consumer hand off. The drain thread is the only writer of
+ *  n2s_ring_in and reads lines from the card under SD_LOCK() in to free slots. loop() is the only writer
+ *  of n2s_ring_out. N2S_Drain_Poll() is called once a loop(), it starts a non blocking Particle.publish()
+ *  on the oldest slot, and on the next calls checks for the ack. Only an acked line moves the front
+ *  cursor (n2s_head, eeprom.n2sfp), so a reset or failed publish resends, never skips.
+ *
+ *  Each slot carries n2s_drain_gen from when it was read. Anything that moves the cursor under the
+ *  thread (stop, bad segment, N2S full, delete) bumps the gen, loop() drops old slots and the thread
+ *  starts over from the front cursor.
+ *
+ *  n2s_drain_hold is back pressure from the observation scheduler. When an observation is due the
+ *  thread stops reading the card and no new publish is started until OBS_Do() has run.
+ * ======================================================================================================================
+ */
+#define N2S_RING_SIZE       4           // Slots, power of 2
+#define N2S_RING_LINE       0           // Slot holds a line to send
+#define N2S_RING_EOF        1           // Thread reached the end of the tail segment
+#define N2S_RING_BAD        2           // Line too long, seg needs to be dropped
+#define N2S_DRAIN_IDLE      50          // ms thread sleeps when there is nothing to do
+#define N2S_OBS_GUARD       2000        // ms before an observation is due to hold the drain
+
+typedef struct {
+  uint32_t        gen;                  // n2s_drain_gen when read
+  uint32_t        seg;                  // Segment the line is from
+  uint32_t        next;                 // File position after the line
+  uint8_t         type;                 // N2S_RING_LINE, N2S_RING_EOF, N2S_RING_BAD
+  const char      *event;               // Particle Event Type, split off the end of line
+  char            line[MAX_MSGBUF_SIZE];
+} N2S_RING_STR;
+N2S_RING_STR n2s_ring[N2S_RING_SIZE];
+volatile uint32_t n2s_ring_in = 0;      // Free running, written by the drain thread
+volatile uint32_t n2s_ring_out = 0;     // Free running, written by loop()
+
+Thread *n2s_thread = NULL;
+volatile bool n2s_drain = false;        // Set while a FIFO drain is in progress
+volatile bool n2s_drain_hold = false;   // Back pressure from the observation scheduler
+particle::Future<bool> n2s_pub;         // Publish in flight for the oldest slot
+bool n2s_pub_busy = false;
+int n2s_pub_tries = 0;
+uint64_t n2s_pub_ms = 0;                // System.millis() the publish was started
+
+/*
+ *=======================================================================================================================
+ * N2S_Ring_Push() - Drain thread, hand the filled slot to loop()
+ *=======================================================================================================================
+ */
+void N2S_Ring_Push() {
+  __sync_synchronize(); // Slot contents before the index
+  n2s_ring_in = n2s_ring_in + 1;
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Ring_Pop() - loop(), done with the oldest slot
+ *=======================================================================================================================
+ */
+void N2S_Ring_Pop() {
+  n2s_ring_out = n2s_ring_out + 1;
+  n2s_pub_tries = 0;
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Drain_Thread() - Read lines from the front cursor forward in to n2s_ring
+ *=======================================================================================================================
+ */
+void N2S_Drain_Thread(void *param) {
+  File fp;
+  N2S_RING_STR *r;
+  char *line;
+  uint32_t next;
+  uint32_t gen = 0;
+  uint32_t seg = 0;
+  uint32_t pos = 0;
+  bool done = true;
+  bool sealed;
+
+  (void) param;
+  while (true) {
+    if (cf_n2s_compress && !n2s_drain && !n2s_drain_hold && (n2s_seal < n2s_tail)) {
+      // Idle, compress the next segment before the tail a block at a time, the card is free between blocks.
+      // Not the head once sending from it has started.
+      SD_LOCK();
+      if (n2s_seal < n2s_head) {
+        n2s_seal = n2s_head;
+      }
+      if ((n2s_seal < n2s_tail) && ((n2s_seal != n2s_head) || (eeprom.n2sfp == 0))) {
+        if (!N2S_Seal(n2s_seal)) {
+          continue;
+        }
+      }
+      else {
+        N2S_Seal_Drop();
+      }
+      n2s_seal++;
+      continue;
+    }
+
+    if (!n2s_drain || n2s_drain_hold || ((n2s_ring_in - n2s_ring_out) >= N2S_RING_SIZE) ||
+        (done && (gen == n2s_drain_gen))) {
+      delay (N2S_DRAIN_IDLE);
+      continue;
+    }
+
+    SD_LOCK();
+    if (gen != n2s_drain_gen) {
+      // Start over from the front cursor
+      gen = n2s_drain_gen;
+      seg = n2s_head;
+      pos = eeprom.n2sfp;
+      done = false;
+    }
+
+    fp = SD.open(N2S_SegmentName(seg), FILE_READ);
+    sealed = fp && N2S_LZ_IsSealed(&fp);
+    if (fp && (((sealed) ? (pos >> 8) : pos) > fp.size())) {
+      // Something wrong. Can not have a file position that is larger than the file
+      pos = 0;
+    }
+
+    // Fill the free slots
+    line = NULL;
+    if (sealed) {
+      N2S_LZ_Start(&fp, pos);
+    }
+    else if (fp) {
+      N2S_Reader_Start(&fp, pos);
+    }
+    while ((n2s_ring_in - n2s_ring_out) < N2S_RING_SIZE) {
+      r = &n2s_ring[n2s_ring_in % N2S_RING_SIZE];
+      r->gen = gen;
+      r->seg = seg;
+      r->next = pos;
+
+      if (fp && ((line = (sealed) ? N2S_LZ_Line(&next) : N2S_Reader_Line(&next)) != NULL)) {
+        strcpy (r->line, line);
+        r->next = pos = next;
+        r->type = N2S_RING_LINE;
+
+        // After the data is a comma and Particle Event Type ("FS", "FSX", "INFO", ...)
+        // The last comma on the line is the separator, base64 data has no commas
+        char *EventType = strrchr(r->line, ',');
+        if (EventType) {
+          *EventType++ = 0; // Set the comma to Null so we don't transmit to Particle what follows
+          while (*EventType == ' ') {
+            EventType++;
+          }
+          r->event = EventType;
+        }
+        else {
+          r->event = "FS";
+        }
+        N2S_Ring_Push();
+        continue;
+      }
+
+      if (fp && ((sealed) ? n2s_lz.bad : n2s_rd.bad)) {
+        r->type = N2S_RING_BAD;
+        N2S_Ring_Push();
+        done = true;
+      }
+      else if (seg < n2s_tail) {
+        // End of this segment, on to the next. loop() retires this one when a line from the next is acked
+        seg++;
+        pos = 0;
+      }
+      else {
+        r->type = N2S_RING_EOF;
+        N2S_Ring_Push();
+        done = true;
+      }
+      break;
+    }
+    if (fp) {
+      fp.close();
+    }
+  }
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Drain_Stop() - End the FIFO drain, save the front cursor
+ *=======================================================================================================================
+ */
+void N2S_Drain_Stop() {
+  SD_LOCK();
+  n2s_drain = false;
+  n2s_drain_gen++;
+  N2S_Journal_Commit(); // Save the file postion
+  sprintf (Buffer32Bytes, "N2S:Drain Stop[%d]", n2s_sent);
+  Output (Buffer32Bytes);
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Drain_Commit() - Slot r was sent or finished, move the front cursor past it
+ *=======================================================================================================================
+ */
+void N2S_Drain_Commit(N2S_RING_STR *r) {
+  SD_LOCK();
+  while (n2s_head < r->seg) {
+    N2S_RetireHead(); // Everything in the head segment has been sent
+  }
+  eeprom.n2sfp = r->next;
+  N2S_Journal_Ack();
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Drain_Start() - Start a FIFO drain, the thread is created the first time
+ *=======================================================================================================================
+ */
+void N2S_Drain_Start() {
+  if (n2s_thread == NULL) {
+    n2s_thread = new Thread("n2s", N2S_Drain_Thread, NULL, OS_THREAD_PRIORITY_DEFAULT, 3*1024);
+  }
+  if (!n2s_drain) {
+    Output ("N2S:Drain Start");
+    n2s_drain_gen++;
+    n2s_drain = true;
+  }
+}
+
+/*
+ *=======================================================================================================================
+ * N2S_Drain_Poll() - Called each loop(). Check the publish in flight and start the next one
+ *=======================================================================================================================
+ */
+void N2S_Drain_Poll() {
+  N2S_RING_STR *r;
+
+  // Back pressure, keep the card and the network free for the observation that is coming due
+  n2s_drain_hold = (Time.isValid() && ((OBS_Secs2Due() * 1000) <= N2S_OBS_GUARD)) || OBS_Full();
+
+  if (!n2s_drain) {
+    return;
+  }
+
+  if (n2s_pub_busy) {
+    if (!n2s_pub.isDone()) {
+      return; // Still waiting on the ack
+    }
+    n2s_pub_busy = false;
+    r = &n2s_ring[n2s_ring_out % N2S_RING_SIZE];
+    PR_Result(n2s_pub.isSucceeded() && n2s_pub.result(), System.millis() - n2s_pub_ms);
+
+    if (n2s_pub.isSucceeded() && n2s_pub.result()) {
+      sprintf (Buffer32Bytes, "N2S[%d]%s->PUB:OK", n2s_sent++, r->event);
+      Output (Buffer32Bytes);
+      Serial_write (r->line);
+      if (r->gen == n2s_drain_gen) {
+        N2S_Drain_Commit(r);
+      }
+      N2S_Ring_Pop();
+    }
+    else if ((n2s_pub_tries < 2) && (r->gen == n2s_drain_gen)) {
+      // Retry when the rate limiter's backoff is over
+      sprintf (Buffer32Bytes, "N2S[%d]%s->PUB:RETRY", n2s_sent, r->event);
+      Output (Buffer32Bytes);
+      return;
+    }
+    else {
+      // On transmit failure, stop. Next transmit window starts from the last acked line.
+      sprintf (Buffer32Bytes, "N2S[%d]%s->PUB:ERR", n2s_sent, r->event);
+      Output (Buffer32Bytes);
+      N2S_Drain_Stop();
+      return;
+    }
+  }
+
+  // Drop slots read before the cursor was moved
+  while ((n2s_ring_in != n2s_ring_out) && (n2s_ring[n2s_ring_out % N2S_RING_SIZE].gen != n2s_drain_gen)) {
+    N2S_Ring_Pop();
+  }
+  if (n2s_ring_in == n2s_ring_out) {
+    return; // Thread is reading
+  }
+  __sync_synchronize(); // Index before the slot contents
+  r = &n2s_ring[n2s_ring_out % N2S_RING_SIZE];
+
+  if (r->type == N2S_RING_BAD) {
+    sprintf (Buffer32Bytes, "N2S[%d]->BOR:ERR", n2s_sent);
+    Output (Buffer32Bytes);
+    SD_LOCK();
+    N2S_Drain_Commit(r);
+    N2S_RetireHead(); // Drop only this segment
+    n2s_drain_gen++;
+    return;
+  }
+
+  if (r->type == N2S_RING_EOF) {
+    SD_LOCK();
+    N2S_Drain_Commit(r);
+    N2S_Sync(); // Lines added since the thread reached the end are not sent yet
+    File fp = SD.open(N2S_SegmentName(n2s_head), FILE_READ);
+    if (!fp || ((fp.size() - eeprom.n2sfp) <= 20)) {
+      // At EOF or some invalid amount left
+      if (fp) {
+        fp.close();
+      }
+      N2S_RetireHead();
+    }
+    else {
+      fp.close();
+    }
+    N2S_Drain_Stop();
+    return;
+  }
+
+  if (n2s_drain_hold) {
+    return;
+  }
+  if (!N2S_BudgetLeft() || !Particle.connected()) {
+    N2S_Drain_Stop();
+    return;
+  }
+  if (!PR_Take()) {
+    return; // No token or backing off, try next loop()
+  }
+
+  n2s_pub = Particle.publish(r->event, r->line, WITH_ACK); // Returns now, ack is checked on the next calls
+  n2s_pub_ms = System.millis();
+  n2s_pub_busy = true;
+  n2s_pub_tries++;
+}
+
+/*
+ *=======================================================================================================================
+ * SD_N2S_Publish() - Send N2S lines in this transmit window
+ *=======================================================================================================================
+ */
+void SD_N2S_Publish() {
+  if (!N2S_Exists()) {
+    return;
+  }
+  Output ("N2S:Publish");
+  N2S_Sync(); // So the reader sees every line
+
+  n2s_sent = 0;
+  n2s_window_start = System.millis();
+
+  if (cf_n2s_lifo) {
+    N2S_Publish_LIFO();
+  }
+  else {
+    N2S_Drain_Start(); // Lines are sent from loop() by N2S_Drain_Poll()
+  }
+}
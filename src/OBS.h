@@ -6,13 +6,17 @@
 
 /*
  * ======================================================================================================================
- *  Observation storage
+ *  Observation schema - Every observation tag we can report, registered once here
+ *  
+ *  Each one minute observation only stores a packed value vector indexed by the schema plus a presence bitmap. 
+ *  The order of obs_schema[] is the order tags are written to the JSON observation. 
+ *  OBS_SCHEMA_IDX and obs_schema[] must be kept in the same order.
+ *  
+ *  The binary observation format (FSX) identifies sensors by schema index, so any change to the entries,
+ *  their order or decimal places must bump OBS_SCHEMA_ID and add the new table to tools/fsx.h.
  * ======================================================================================================================
  */
-#define MAX_SENSORS         96
-#define MAX_ONE_MINUTE_OBS  17 // Want more OBS space than our OBSERVATION_TRANSMIT_INTERVAL (For 15m interval use 17)
-                              // This prevents OBS from filling and being written to N2S file while we are Connecting
-
+#define OBS_SCHEMA_ID 4
 typedef enum {
   F_OBS, 
   I_OBS, 
@@ -20,23 +24,504 @@ typedef enum {
 } OBS_TYPE;
 
 typedef struct {
-  char          id[6];       // Suport 4 character length observation names
-  int           type;
-  float         f_obs;
-  int           i_obs;
-  unsigned long u_obs;
-  bool          inuse;
-} SENSOR;
+  const char    *id;         // Observation tag name
+  OBS_TYPE      type;
+  float         qc_min;      // QC bounds, checked when qc_min < qc_max
+  float         qc_max;
+  float         qc_err;      // Value reported when outside QC bounds
+  uint8_t       dp;          // Decimal places reported, F_OBS values are scaled by 10^dp in the binary format
+} OBS_SCHEMA_STR;
+
+#define QC_NONE       0.0, 0.0, 0.0
+#define QC_T          QC_MIN_T, QC_MAX_T, QC_ERR_T
+#define QC_P          QC_MIN_P, QC_MAX_P, QC_ERR_P
+#define QC_RH         QC_MIN_RH, QC_MAX_RH, QC_ERR_RH
+#define QC_IR         QC_MIN_IR, QC_MAX_IR, QC_ERR_IR
+#define QC_VI         QC_MIN_VI, QC_MAX_VI, QC_ERR_VI
+#define QC_UV         QC_MIN_UV, QC_MAX_UV, QC_ERR_UV
+#define QC_VLX        QC_MIN_VLX, QC_MAX_VLX, QC_ERR_VLX
+#define QC_BLX        QC_MIN_BLX, QC_MAX_BLX, QC_ERR_BLX
+#define QC_WS         QC_MIN_WS, QC_MAX_WS, QC_ERR_WS
+#define QC_WD         QC_MIN_WD, QC_MAX_WD, QC_ERR_WD
+
+typedef enum {
+  OBS_BCS, OBS_BPC, OBS_CFR,
+  OBS_RG, OBS_RGT, OBS_RGP, OBS_RGR, OBS_RGI, OBS_RGF, OBS_RGL,
+  OBS_WS, OBS_WD, OBS_WG, OBS_WGD, OBS_WGT,
+  OBS_BP1, OBS_BT1, OBS_BH1,
+  OBS_BP2, OBS_BT2, OBS_BH2,
+  OBS_HH1, OBS_HT1,
+  OBS_ST1, OBS_SH1,
+  OBS_ST2, OBS_SH2,
+  OBS_HDT1, OBS_HDH1,
+  OBS_HDT2, OBS_HDH2,
+  OBS_LPT1, OBS_LPP1,
+  OBS_LPT2, OBS_LPP2,
+  OBS_HT2, OBS_HH2,
+  OBS_SV1, OBS_SI1, OBS_SU1,
+  OBS_MT1, OBS_MT2, OBS_GT1, OBS_GT2,
+  OBS_VLX, OBS_BLX,
+  OBS_SG, OBS_SGMN, OBS_SGMX, OBS_A4R, OBS_RG2, OBS_RGT2, OBS_RGP2, OBS_RGR2, OBS_RGI2, OBS_RGF2, OBS_RGL2, OBS_A5R,
+  OBS_PM1S10, OBS_PM1S25, OBS_PM1S100, OBS_PM1E10, OBS_PM1E25, OBS_PM1E100,
+  OBS_HI, OBS_WBT, OBS_WBGT,
+  OBS_TLWW, OBS_TLWT,
+  OBS_TSME25, OBS_TSMEC, OBS_TSMVWC, OBS_TSMT,
+  OBS_TMSMS1, OBS_TMSMS2, OBS_TMSMS3, OBS_TMSMS4, OBS_TMSMT1, OBS_TMSMT2,
+  OBS_PMTS,
+  OBS_SCHEMA_CNT
+} OBS_SCHEMA_IDX;
+
+const OBS_SCHEMA_STR obs_schema[OBS_SCHEMA_CNT] = {
+  {"bcs",     I_OBS, QC_NONE, 0},     // Battery Charging State
+  {"bpc",     F_OBS, QC_NONE, 1},     // Battery Percent Charge
+  {"cfr",     I_OBS, QC_NONE, 0},     // Battery Charger Fault Register
+  {"rg",      F_OBS, QC_NONE, 1},     // Rain Gauge - QC is rate based, done in OBS_Do()
+  {"rgt",     F_OBS, QC_NONE, 1},     // Rain Gauge Total
+  {"rgp",     F_OBS, QC_NONE, 1},     // Rain Gauge Prior Day
+  {"rgr",     F_OBS, QC_NONE, 1},     // Rain Gauge Rate mm/h, from the time between tips
+  {"rgi",     F_OBS, QC_NONE, 1},     // Rain Gauge peak 1 minute Intensity today mm/h
+  {"rgf",     U_OBS, QC_NONE, 0},     // Rain Gauge time of First tip today
+  {"rgl",     U_OBS, QC_NONE, 0},     // Rain Gauge time of Last tip today
+  {"ws",      F_OBS, QC_WS, 1},       // Wind Speed
+  {"wd",      I_OBS, QC_WD, 0},       // Wind Direction
+  {"wg",      F_OBS, QC_WS, 1},       // Wind Gust
+  {"wgd",     I_OBS, QC_WD, 0},       // Wind Gust Direction
+  {"wgt",     U_OBS, QC_NONE, 0},     // Wind Gust Time, seconds before the observation time
+  {"bp1",     F_OBS, QC_P, 1},        // BMX1 Pressure
+  {"bt1",     F_OBS, QC_T, 1},        // BMX1 Temperature
+  {"bh1",     F_OBS, QC_RH, 1},       // BMX1 Humidity
+  {"bp2",     F_OBS, QC_P, 1},        // BMX2 Pressure
+  {"bt2",     F_OBS, QC_T, 1},        // BMX2 Temperature
+  {"bh2",     F_OBS, QC_RH, 1},       // BMX2 Humidity
+  {"hh1",     F_OBS, QC_RH, 1},       // HTU Humidity
+  {"ht1",     F_OBS, QC_T, 1},        // HTU Temperature
+  {"st1",     F_OBS, QC_T, 1},        // SHT1 Temperature
+  {"sh1",     F_OBS, QC_RH, 1},       // SHT1 Humidity
+  {"st2",     F_OBS, QC_T, 1},        // SHT2 Temperature
+  {"sh2",     F_OBS, QC_RH, 1},       // SHT2 Humidity
+  {"hdt1",    F_OBS, QC_T, 1},        // HDC1 Temperature
+  {"hdh1",    F_OBS, QC_RH, 1},       // HDC1 Humidity
+  {"hdt2",    F_OBS, QC_T, 1},        // HDC2 Temperature
+  {"hdh2",    F_OBS, QC_RH, 1},       // HDC2 Humidity
+  {"lpt1",    F_OBS, QC_T, 1},        // LPS1 Temperature
+  {"lpp1",    F_OBS, QC_P, 1},        // LPS1 Pressure
+  {"lpt2",    F_OBS, QC_T, 1},        // LPS2 Temperature
+  {"lpp2",    F_OBS, QC_P, 1},        // LPS2 Pressure
+  {"ht2",     F_OBS, QC_T, 1},        // HIH8 Temperature
+  {"hh2",     F_OBS, QC_RH, 1},       // HIH8 Humidity
+  {"sv1",     F_OBS, QC_VI, 1},       // SI Visible
+  {"si1",     F_OBS, QC_IR, 1},       // SI IR
+  {"su1",     F_OBS, QC_UV, 1},       // SI UV
+  {"mt1",     F_OBS, QC_T, 1},        // MCP1 Temperature
+  {"mt2",     F_OBS, QC_T, 1},        // MCP2 Temperature
+  {"gt1",     F_OBS, QC_T, 1},        // MCP3 Globe Temperature
+  {"gt2",     F_OBS, QC_T, 1},        // MCP4 Globe Temperature
+  {"vlx",     F_OBS, QC_VLX, 1},      // VEML7700 Auto Lux Value
+  {"blx",     F_OBS, QC_BLX, 1},      // DFR BLUX30 Auto Lux Value
+  {"sg",      F_OBS, QC_NONE, 1},     // Distance Gauge (snow or stream)
+  {"sgmn",    F_OBS, QC_NONE, 1},     // Distance Gauge lowest reading over the last minute
+  {"sgmx",    F_OBS, QC_NONE, 1},     // Distance Gauge highest reading over the last minute
+  {"a4r",     F_OBS, QC_NONE, 1},     // A4 Raw
+  {"rg2",     F_OBS, QC_NONE, 1},     // Rain Gauge 2 - QC is rate based, done in OBS_Do()
+  {"rgt2",    F_OBS, QC_NONE, 1},     // Rain Gauge 2 Total
+  {"rgp2",    F_OBS, QC_NONE, 1},     // Rain Gauge 2 Prior Day
+  {"rgr2",    F_OBS, QC_NONE, 1},     // Rain Gauge 2 Rate mm/h
+  {"rgi2",    F_OBS, QC_NONE, 1},     // Rain Gauge 2 peak 1 minute Intensity today mm/h
+  {"rgf2",    U_OBS, QC_NONE, 0},     // Rain Gauge 2 time of First tip today
+  {"rgl2",    U_OBS, QC_NONE, 0},     // Rain Gauge 2 time of Last tip today
+  {"a5r",     F_OBS, QC_NONE, 1},     // A5 Raw
+  {"pm1s10",  I_OBS, QC_NONE, 0},     // Standard Particle PM1.0
+  {"pm1s25",  I_OBS, QC_NONE, 0},     // Standard Particle PM2.5
+  {"pm1s100", I_OBS, QC_NONE, 0},     // Standard Particle PM10.0
+  {"pm1e10",  I_OBS, QC_NONE, 0},     // Atmospheric Environmental PM1.0
+  {"pm1e25",  I_OBS, QC_NONE, 0},     // Atmospheric Environmental PM2.5
+  {"pm1e100", I_OBS, QC_NONE, 0},     // Atmospheric Environmental PM10.0
+  {"hi",      F_OBS, QC_NONE, 1},     // Heat Index Temperature
+  {"wbt",     F_OBS, QC_NONE, 1},     // Wet Bulb Temperature
+  {"wbgt",    F_OBS, QC_NONE, 1},     // Wet Bulb Globe Temperature
+  {"tlww",    F_OBS, QC_NONE, 1},     // Tinovi Leaf Wetness
+  {"tlwt",    F_OBS, QC_T, 1},        // Tinovi Leaf Temperature
+  {"tsme25",  F_OBS, QC_NONE, 1},     // Tinovi Soil Dielectric Permittivity
+  {"tsmec",   F_OBS, QC_NONE, 1},     // Tinovi Soil Electrical Conductivity
+  {"tsmvwc",  F_OBS, QC_NONE, 1},     // Tinovi Soil Volumetric Water Content
+  {"tsmt",    F_OBS, QC_T, 1},        // Tinovi Soil Temperature
+  {"tmsms1",  F_OBS, QC_NONE, 1},     // Tinovi Multi Level Soil Moisture 1
+  {"tmsms2",  F_OBS, QC_NONE, 1},     // Tinovi Multi Level Soil Moisture 2
+  {"tmsms3",  F_OBS, QC_NONE, 1},     // Tinovi Multi Level Soil Moisture 3
+  {"tmsms4",  F_OBS, QC_NONE, 1},     // Tinovi Multi Level Soil Moisture 4
+  {"tmsmt1",  F_OBS, QC_T, 1},        // Tinovi Multi Level Soil Temperature 1
+  {"tmsmt2",  F_OBS, QC_T, 1},        // Tinovi Multi Level Soil Temperature 2
+  {"pmts",    F_OBS, QC_NONE, 1}      // Particle Muon on board temperature (Not an environmental sensor)
+};
+
+/*
+ * ======================================================================================================================
+ *  Observation storage
+ *  
+ *  Old layout was 96 SENSOR structs per minute with the tag string copied in to each, 2712 bytes a minute
+ *  and 46,104 bytes for 17 minutes on Argon/Boron. A minute is now 4 bytes per schema entry plus a header and
+ *  bitmap, 348 bytes with 80 entries, so 120 minutes take 41,760 bytes. tools/obs_bench measures both.
+ *  
+ *  obs[] is allocated by OBS_Alloc() in setup() from what System.freeMemory() says is left, keeping
+ *  OBS_HEAP_RESERVE for Device OS, publishes and the threads started after it. obs_slots is how many we got,
+ *  at most MAX_ONE_MINUTE_OBS. If the heap can not hold OBS_SLOTS_MIN we take what it can, down to the
+ *  one static slot, and the queue spills to N2S sooner.
+ * ======================================================================================================================
+ */
+#define MAX_ONE_MINUTE_OBS  120 // Want more OBS space than our OBSERVATION_TRANSMIT_INTERVAL (For 15m interval use 17 or more)
+                              // This prevents OBS from filling and being written to N2S file while we are Connecting
+#define OBS_SLOTS_MIN       17        // 15 minute transmit interval plus 2
+#define OBS_HEAP_RESERVE    (32*1024) // Heap left free after obs[] is allocated
+#define OBS_PRESENT_WORDS   ((OBS_SCHEMA_CNT+31)/32)
+
+typedef union {
+  float         f;
+  int32_t       i;
+  uint32_t      u;
+} OBS_VALUE;
 
 typedef struct {
   bool            inuse;                // Set to true when an observation is stored here         
-  time_t          ts;                   // TimeStamp
+  time32_t        ts;                   // TimeStamp
   float           css;                  // Cell Signal Strength
   unsigned long   hth;                  // System Status Bits
-  SENSOR          sensor[MAX_SENSORS];
+  uint32_t        present[OBS_PRESENT_WORDS]; // Bit set for each schema entry that has a value
+  OBS_VALUE       value[OBS_SCHEMA_CNT];
 } OBSERVATION_STR;
-OBSERVATION_STR obs[MAX_ONE_MINUTE_OBS];
+OBSERVATION_STR obs_one[1];            // Used until OBS_Alloc(), and if the heap has no room at all
+OBSERVATION_STR *obs = obs_one;
+int obs_slots = 1;                     // Entries in obs[]
+
+/*
+ * ======================================================================================================================
+ *  Observation queue - obs[] is used as a ring. obs_head is the oldest observation, new ones are added at the tail.
+ *  
+ *  When the queue is full and a new observation is needed, cf_obs_overflow picks what goes to the N2S file
+ * ======================================================================================================================
+ */
+#define OBS_OVERFLOW_OLDEST  0  // Move only the oldest observation to N2S
+#define OBS_OVERFLOW_ALL     1  // Move all observations and LoRa relay messages to N2S
+
+int obs_head = 0;              // Index of oldest observation
+int obs_count = 0;             // Number of observations in the queue
+
+/*
+ * ======================================================================================================================
+ * OBS_Present() - Return true if observation i has a value for schema entry s
+ * ======================================================================================================================
+ */
+bool OBS_Present(int i, int s) {
+  return (obs[i].present[s>>5] & (1UL << (s&31)));
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_SetF() - Store a float value for schema entry s in observation i
+ * ======================================================================================================================
+ */
+void OBS_SetF(int i, int s, float f) {
+  obs[i].value[s].f = f;
+  obs[i].present[s>>5] |= (1UL << (s&31));
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_SetI() - Store a integer value for schema entry s in observation i
+ * ======================================================================================================================
+ */
+void OBS_SetI(int i, int s, int v) {
+  obs[i].value[s].i = v;
+  obs[i].present[s>>5] |= (1UL << (s&31));
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_SetU() - Store a unsigned value for schema entry s in observation i
+ * ======================================================================================================================
+ */
+void OBS_SetU(int i, int s, unsigned long v) {
+  obs[i].value[s].u = v;
+  obs[i].present[s>>5] |= (1UL << (s&31));
+}
+
+/*
+ * ======================================================================================================================
+ *  Encoded observation - An observation is serialized once in to obs_enc and the bytes are reused by the
+ *  SD log, publish and N2S paths. obs_enc.idx is the obs[] index the bytes belong to, -1 when empty.
+ *  Anything that changes an observation after it is encoded must call OBS_Encode_Invalidate().
+ * ======================================================================================================================
+ */
+typedef struct {
+  int             idx;                  // obs[] index encoded in buf, -1 = nothing
+  size_t          len;                  // JSON length in buf, not including the null
+  size_t          at_end;               // Offset in buf just past the "at" value
+  size_t          hth_name;             // Offset in buf of the separator before "hth"
+  size_t          hth_pos;              // Offset in buf of the hth value
+  size_t          hth_len;              // Number of characters in the hth value
+  unsigned long   hth;                  // hth value currently in buf
+  char            buf[MAX_MSGBUF_SIZE];
+} OBS_ENCODED_STR;
+OBS_ENCODED_STR obs_enc = { -1, 0, 0, 0, 0, 0, 0, "" };
+
+#define OBS_ENC_SUFFIX_SPACE  8         // Room kept after the JSON for ",FS" event type when saving to N2S
+
+#define OBS_ENC_FIELD_MAX     64        // Room needed for the longest ,"tag":value member
+
+/*
+ * ======================================================================================================================
+ * OBS_JSON_Name() - Write ,"id": at p, return pointer just past it
+ * ======================================================================================================================
+ */
+char *OBS_JSON_Name(char *p, const char *id) {
+  *p++ = ',';
+  *p++ = '"';
+  while (*id) {
+    *p++ = *id++;
+  }
+  *p++ = '"';
+  *p++ = ':';
+  return (p);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_JSON_Sensors() - Write observation i sensor values as JSON members at p in schema order
+ *                      Members that would go past end are dropped, return pointer to the null at the end
+ * ======================================================================================================================
+ */
+char *OBS_JSON_Sensors(char *p, char *end, int i) {
+  for (int s=0; s<OBS_SCHEMA_CNT; s++) {
+    if (OBS_Present(i, s)) {
+      if ((end - p) < OBS_ENC_FIELD_MAX) {
+        Output ("OBS:JSON FULL");
+        break;
+      }
+      p = OBS_JSON_Name(p, obs_schema[s].id);
+      switch (obs_schema[s].type) {
+        case F_OBS :
+          p = FMT_Fixed(p, obs[i].value[s].f, obs_schema[s].dp);
+          break;
+        case I_OBS :
+          p = FMT_Int(p, (int) obs[i].value[s].i);
+          break;
+        case U_OBS :
+          p = FMT_Int(p, (int) obs[i].value[s].u);
+          break;
+        default : // Should never happen
+          Output ("WhyAmIHere?");
+          break;
+      }
+    }
+  }
+  *p = 0;
+  return (p);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Encode_Invalidate() - Forget the encoded bytes if they are for observation i
+ * ======================================================================================================================
+ */
+void OBS_Encode_Invalidate(int i) {
+  if (obs_enc.idx == i) {
+    obs_enc.idx = -1;
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Encode() - Serialize observation i to JSON in obs_enc.buf, return false if not in use
+ *                If observation i is already encoded the cached bytes are used
+ * ======================================================================================================================
+ */
+bool OBS_Encode(int i) {
+  if (!obs[i].inuse) {     // Sanity check
+    return (false);
+  }
+
+  if (obs_enc.idx == i) {
+    return (true);
+  }
+
+  char *p = obs_enc.buf;
+  char *end = obs_enc.buf + sizeof(obs_enc.buf) - OBS_ENC_SUFFIX_SPACE - 2;  // 2 for } and null
+
+  // Same bytes JSONBufferWriter would write, without going through printf
+  memcpy (p, "{\"at\":\"", 7);
+  p += 7;
+  FMT_TimeStamp(obs[i].ts, p);
+  p += strlen(p);
+  *p++ = '"';
+  obs_enc.at_end = p - obs_enc.buf;
+
+  memcpy (p, ",\"css\":", 7);
+  p = FMT_Fixed(p+7, obs[i].css, 4);
+
+  obs_enc.hth_name = p - obs_enc.buf;
+  memcpy (p, ",\"hth\":", 7);
+  p += 7;
+  obs_enc.hth_pos = p - obs_enc.buf;
+  p = FMT_Int(p, (int) obs[i].hth);
+  obs_enc.hth_len = (p - obs_enc.buf) - obs_enc.hth_pos;
+  obs_enc.hth = obs[i].hth;
+
+  p = OBS_JSON_Sensors(p, end, i);
+  *p++ = '}';
+  *p = 0;
+
+  obs_enc.len = p - obs_enc.buf;
+  obs_enc.idx = i;
+  return (true);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Encode_SetHealth() - Patch the hth value in the encoded observation in place
+ * ======================================================================================================================
+ */
+void OBS_Encode_SetHealth(unsigned long hth) {
+  char digits[16];
+  size_t n;
+
+  if ((obs_enc.idx < 0) || (obs_enc.hth == hth) || ((obs_enc.hth_pos + obs_enc.hth_len) > obs_enc.len)) {
+    return;
+  }
+
+  n = FMT_Int(digits, (int) hth) - digits;
+  if ((obs_enc.len - obs_enc.hth_len + n) >= (sizeof(obs_enc.buf) - OBS_ENC_SUFFIX_SPACE)) {
+    obs_enc.idx = -1; // No room, force a new encode
+    return;
+  }
+
+  // Shift what follows the hth value if the number of digits changed
+  char *tail = obs_enc.buf + obs_enc.hth_pos + obs_enc.hth_len;
+  memmove (obs_enc.buf + obs_enc.hth_pos + n, tail, obs_enc.len - (obs_enc.hth_pos + obs_enc.hth_len) + 1);
+  memcpy (obs_enc.buf + obs_enc.hth_pos, digits, n);
+  obs_enc.len = obs_enc.len - obs_enc.hth_len + n;
+  obs_enc.hth_len = n;
+  obs_enc.hth = hth;
+}
+
+/*
+ * ======================================================================================================================
+ *  Binary observations - Event FSX, sent instead of FS/FSB when obs_format=1 in CONFIG.TXT
+ *  tools/fsx_decode turns the records back in to FS JSON, tools/test/test_fsx checks the round trip.
+ *  
+ *  The event data is the base64 of one or more records back to back. A record is
+ *    u8      OBS_SCHEMA_ID
+ *    u32     ts, seconds since 1970, little endian
+ *    varint  css * 10^4, zigzag
+ *    varint  hth
+ *    u8[]    presence bitmap, OBS_BIN_BITMAP_SIZE bytes, schema entry s is byte s/8 bit s%8
+ *    varint  for each schema entry present, in schema order
+ *              F_OBS  value * 10^dp rounded to nearest even, zigzag. INT32_MIN if NaN or out of range
+ *              I_OBS  value, zigzag
+ *              U_OBS  value
+ *  Varints are 7 bits per byte, low bits first, high bit set when another byte follows.
+ *  Zigzag maps n to (n << 1) ^ (n >> 31) so small negative numbers stay small.
+ *  A float times 10^dp (dp <= 4) is exact as a double, so the rounding matches the JSON writer.
+ * ======================================================================================================================
+ */
+#define OBS_FORMAT_JSON       0
+#define OBS_FORMAT_BINARY     1
+
+#define OBS_BIN_BITMAP_SIZE   ((OBS_SCHEMA_CNT+7)/8)
+#define OBS_BIN_REC_MAX_SIZE  (1 + 4 + 5 + 5 + OBS_BIN_BITMAP_SIZE + (OBS_SCHEMA_CNT*5))
+#define OBS_BIN_MAX_SIZE      (((MAX_MSGBUF_SIZE-1)/4)*3)  // Raw bytes that fit in a event once base64 encoded
+uint8_t obs_bin[OBS_BIN_MAX_SIZE];
+char obs_batch[MAX_MSGBUF_SIZE];        // Text of batched (FSB) or base64 (FSX) event data
+
+/*
+ * ======================================================================================================================
+ * OBS_Bin_Varint() - Write v as a varint at p, return number of bytes written
+ * ======================================================================================================================
+ */
+size_t OBS_Bin_Varint(uint8_t *p, uint32_t v) {
+  size_t n = 0;
+
+  while (v >= 0x80) {
+    p[n++] = (v & 0x7F) | 0x80;
+    v >>= 7;
+  }
+  p[n++] = v;
+  return (n);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Bin_Zigzag() - Map a signed value to unsigned so small magnitudes make short varints
+ * ======================================================================================================================
+ */
+uint32_t OBS_Bin_Zigzag(int32_t v) {
+  return (((uint32_t) v << 1) ^ (uint32_t) (v >> 31));
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Bin_Scale() - Return f * 10^dp as a rounded integer
+ * ======================================================================================================================
+ */
+int32_t OBS_Bin_Scale(float f, uint8_t dp) {
+  double d = f;
+
+  while (dp-- > 0) {
+    d *= 10.0;
+  }
+  if (isnan(d) || (d >= 2147483647.0) || (d <= -2147483648.0)) {
+    return (INT32_MIN);
+  }
+  return ((int32_t) rint(d));
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Bin_Encode() - Write observation i as a binary record at p, return record length or 0 if not in use
+ *                    p must have room for OBS_BIN_REC_MAX_SIZE bytes
+ * ======================================================================================================================
+ */
+size_t OBS_Bin_Encode(int i, uint8_t *p) {
+  size_t n = 0;
+  uint32_t ts;
+  uint8_t *bitmap;
+
+  if (!obs[i].inuse) {     // Sanity check
+    return (0);
+  }
 
+  p[n++] = OBS_SCHEMA_ID;
+  ts = (uint32_t) obs[i].ts;
+  p[n++] = ts;
+  p[n++] = ts >> 8;
+  p[n++] = ts >> 16;
+  p[n++] = ts >> 24;
+  n += OBS_Bin_Varint(p+n, OBS_Bin_Zigzag(OBS_Bin_Scale(obs[i].css, 4)));
+  n += OBS_Bin_Varint(p+n, obs[i].hth);
+
+  bitmap = p+n;
+  memset(bitmap, 0, OBS_BIN_BITMAP_SIZE);
+  n += OBS_BIN_BITMAP_SIZE;
+
+  for (int s=0; s<OBS_SCHEMA_CNT; s++) {
+    if (OBS_Present(i, s)) {
+      bitmap[s>>3] |= (1 << (s&7));
+      switch (obs_schema[s].type) {
+        case F_OBS :
+          n += OBS_Bin_Varint(p+n, OBS_Bin_Zigzag(OBS_Bin_Scale(obs[i].value[s].f, obs_schema[s].dp)));
+          break;
+        case I_OBS :
+          n += OBS_Bin_Varint(p+n, OBS_Bin_Zigzag(obs[i].value[s].i));
+          break;
+        case U_OBS :
+          n += OBS_Bin_Varint(p+n, obs[i].value[s].u);
+          break;
+        default : // Should never happen
+          Output ("WhyAmIHere?");
+          break;
+      }
+    }
+  }
+  return (n);
+}
 
 /*
  * ======================================================================================================================
@@ -44,10 +529,9 @@ OBSERVATION_STR obs[MAX_ONE_MINUTE_OBS];
  * ======================================================================================================================
  */
 void OBS_Clear(int i) {
+  OBS_Encode_Invalidate(i);
   obs[i].inuse =false;
-  for (int s=0; s<MAX_SENSORS; s++) {
-    obs[i].sensor[s].inuse = false;
-  }
+  memset(obs[i].present, 0, sizeof(obs[i].present));
 }
 
 /*
@@ -56,1114 +540,1028 @@ void OBS_Clear(int i) {
  * ======================================================================================================================
  */
 void OBS_Init() {
-  // Scan OBS for free spot
-  for (int i=0; i<MAX_ONE_MINUTE_OBS; i++){
+  for (int i=0; i<obs_slots; i++){
     OBS_Clear(i);
   }
+  obs_head = 0;
+  obs_count = 0;
 }
 
 /*
  * ======================================================================================================================
- * OBS_N2S_Add() - Save OBS to N2S file
+ * OBS_Alloc() - Size obs[] from the free heap, call once from setup() before any observation is made
  * ======================================================================================================================
  */
-void OBS_N2S_Add(int i) {
-  if (obs[i].inuse) {     // Sanity check
-    char ts[32];
-    
-    memset(msgbuf, 0, sizeof(msgbuf));
+void OBS_Alloc() {
+  uint32_t mem = System.freeMemory();
+  int n = (mem > OBS_HEAP_RESERVE) ? (mem - OBS_HEAP_RESERVE) / sizeof(OBSERVATION_STR) : 0;
+  OBSERVATION_STR *p = NULL;
 
-    JSONBufferWriter writer(msgbuf, sizeof(msgbuf)-1);
-    writer.beginObject();
-
-    sprintf (ts, "%d-%02d-%02dT%02d:%02d:%02d",
-      Time.year(obs[i].ts), Time.month(obs[i].ts), Time.day(obs[i].ts),
-      Time.hour(obs[i].ts), Time.minute(obs[i].ts), Time.second(obs[i].ts));
+  if (n > MAX_ONE_MINUTE_OBS) {
+    n = MAX_ONE_MINUTE_OBS;
+  }
+  while ((n > 1) && ((p = (OBSERVATION_STR *) malloc(n * sizeof(OBSERVATION_STR))) == NULL)) {
+    n /= 2;  // Free heap is not all in one piece
+  }
+  if (p) {
+    obs = p;
+    obs_slots = n;
+  }
+  OBS_Init();
 
-    writer.name("at").value(ts);
-    writer.name("css").value(obs[i].css, 4);
+  sprintf (Buffer32Bytes, "OBS:%d SLOTS%s", obs_slots, (obs_slots < OBS_SLOTS_MIN) ? " LOW" : "");
+  Output (Buffer32Bytes);
+}
 
+/*
+ * ======================================================================================================================
+ * OBS_N2S_Add() - Save OBS to N2S file
+ * ======================================================================================================================
+ */
+void OBS_N2S_Add(int i) {
+  if (cf_obs_format == OBS_FORMAT_BINARY) {
+    if (obs[i].inuse) {
+      // Modify System Status and Set From Need to Send file bit
+      obs[i].hth |= SSB_FROM_N2S; // Turn On Bit
+      OBS_Encode_Invalidate(i);
+
+      size_t len = Base64_Encode(obs_bin, OBS_Bin_Encode(i, obs_bin), obs_batch);
+      strcpy (obs_batch+len, ",FSX");  // Add Particle Event Type after base64 data
+      SD_NeedToSend_Add(obs_batch); // Save to N2F File
+      sprintf (Buffer32Bytes, "OBS->%d Add N2S", i);
+      Output(Buffer32Bytes);
+      Serial_write (obs_batch);
+    }
+  }
+  else if (OBS_Encode(i)) {
     // Modify System Status and Set From Need to Send file bit
     obs[i].hth |= SSB_FROM_N2S; // Turn On Bit
-    writer.name("hth").value((int) obs[i].hth);
-
-    for (int s=0; s<MAX_SENSORS; s++) {
-      if (obs[i].sensor[s].inuse) {
-        switch (obs[i].sensor[s].type) {
-          case F_OBS :
-            writer.name(obs[i].sensor[s].id).value(obs[i].sensor[s].f_obs, 1);
-            break;
-          case I_OBS :
-            writer.name(obs[i].sensor[s].id).value(obs[i].sensor[s].i_obs);
-            break;
-          case U_OBS :
-            writer.name(obs[i].sensor[s].id).value((int) obs[i].sensor[s].u_obs);
-            break;
-          default : // Should never happen
-            Output ("WhyAmIHere?");
-            break;
-        }
-      }
-    }
-    writer.endObject();
+    OBS_Encode_SetHealth(obs[i].hth);
+    OBS_Encode(i); // Only encodes again if there was no room to patch
 
-    sprintf (msgbuf+strlen(msgbuf), ",FS");  // Add Particle Event Type after JSON structure
-    SD_NeedToSend_Add(msgbuf); // Save to N2F File
+    strcpy (obs_enc.buf+obs_enc.len, ",FS");  // Add Particle Event Type after JSON structure
+    SD_NeedToSend_Add(obs_enc.buf); // Save to N2F File
+    obs_enc.buf[obs_enc.len] = 0;
     sprintf (Buffer32Bytes, "OBS->%d Add N2S", i);
     Output(Buffer32Bytes);
-    Serial_write (msgbuf);
+    Serial_write (obs_enc.buf);
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Relay_Build_JSON() - Create JSON observation in msgbuf, remove from relay structure
+ *                          Return the message relay type we are preparing
+ * ======================================================================================================================
+ */
+int OBS_Relay_Build_JSON() {
+  LORA_MSG_RELAY_STR *m;
+  int relay_type = 0;
+
+  memset(msgbuf, 0, sizeof(msgbuf));
+  JSONBufferWriter writer(msgbuf, sizeof(msgbuf)-1);
+
+  // Locate message we need to log
+  int i = lora_relay_need2log_idx();
+  if (i >= 0) {
+    m = &lora_msg_relay[i];
+    strncpy (msgbuf, m->message, LORA_RELAY_MSG_LENGTH-1); // minus 1 so last byte in array will always be null
+    relay_type = m->message_type;
+    lora_relay_msg_free(m);
+  }
+  return (relay_type);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Log() - Save OBS to Log file
+ * ======================================================================================================================
+ */
+void OBS_Log(int i) {
+  if (OBS_Encode(i)) {
+    sprintf (Buffer32Bytes, "OBS[%d]->SD", i);
+    Output(Buffer32Bytes);
+    Serial_write (obs_enc.buf);
+
+    SD_LogObservation(obs_enc.buf);
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Dequeue() - Remove the oldest observation from the queue
+ * ======================================================================================================================
+ */
+void OBS_Dequeue() {
+  if (obs_count > 0) {
+    OBS_Clear(obs_head);
+    obs_head = (obs_head + 1) % obs_slots;
+    obs_count--;
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_N2S_SaveAll() - Save All N Observations to Need2Send File
+ * ======================================================================================================================
+ */
+void OBS_N2S_SaveAll() {
+  int relay_type;
+
+  N2S_Session_Begin();
+
+  // Save All Station Observations to N2S file, oldest first
+  while (obs_count > 0) {
+    OBS_N2S_Add (obs_head);
+    OBS_Dequeue();
+  }
+
+  // Save All Rain and Soil LoRa Observations to N2S file
+  while (lora_relay_need2log()) {
+   relay_type = OBS_Relay_Build_JSON(); // This removed msg from relay structure and places it in msgbuf
+    sprintf (msgbuf+strlen(msgbuf), ", %s", relay_msgtypes[relay_type]);  // Add Particle Event Type after JSON structure
+    SD_NeedToSend_Add(msgbuf); // Save to N2F File
+    Output("LR->N2S");
+    Serial_write (msgbuf); 
+  }
+  N2S_Session_End();
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Last() - Find Last OBS and return index or -1 if empty
+ * ======================================================================================================================
+ */
+int OBS_Last() {
+  if (obs_count == 0) {
+    return (-1);
+  }
+  return ((obs_head + obs_count - 1) % obs_slots);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Full() - Return true if there are no open spots
+ * ======================================================================================================================
+ */
+bool OBS_Full() {
+  return (obs_count >= obs_slots);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Open() - Add a free OBS to the tail of the queue and return index
+ * ======================================================================================================================
+ */
+int OBS_Open() {
+  int i;
+
+  if (OBS_Full()) {
+    if (cf_obs_overflow == OBS_OVERFLOW_ALL) {
+      // Save All N Observations to Need2Send File
+      Output ("OBS[ALL]->N2S");
+      OBS_N2S_SaveAll();
+    }
+    else {
+      // Make room by moving only the oldest observation to the Need2Send File
+      sprintf (Buffer32Bytes, "OBS[%d]->N2S", obs_head);
+      Output(Buffer32Bytes);
+      OBS_N2S_Add (obs_head);
+      OBS_Dequeue();
+    }
+  }
+
+  i = (obs_head + obs_count) % obs_slots;
+  OBS_Clear(i);
+  obs_count++;
+  return (i);
+}
+
+/*
+ * ======================================================================================================================
+ *  Sensor registry - Each sensor has a read function that stores its raw values in the observation with 
+ *  OBS_SetF/I/U(). OBS_Do() calls the readers of the sensors whose exists flag is set (NULL = always read), 
+ *  then applies the obs_qc[] limits to every value in one pass, then runs the derived readers which 
+ *  use the QC'd values.
+ *  
+ *  Adding a sensor is a schema entry for each tag it reports, a read function and a line in obs_sensors[].
+ * ======================================================================================================================
+ */
+typedef struct {
+  const char    *name;            // Used in debug output
+  bool          *exists;          // Presence flag, NULL = always read, reader checks its own state
+  void          (*read)(int oidx);
+} OBS_SENSOR_STR;
+
+/*
+ * ======================================================================================================================
+ * OBS_GetF() - Return float value for schema entry s in observation i, 0.0 if not present
+ * ======================================================================================================================
+ */
+float OBS_GetF(int i, int s) {
+  return (OBS_Present(i, s) ? obs[i].value[s].f : 0.0);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_Battery() - Battery Charging State, Percent Charge and Charger Fault Register
+ * ======================================================================================================================
+ */
+void OBS_Read_Battery(int oidx) {
+  float BatteryPoC = 0.0; // Battery Percent of Charge
+#if PLATFORM_ID == PLATFORM_ARGON
+  int BatteryState = 0;
+  byte cfr = 0;
+#else
+  int BatteryState = System.batteryState();
+  byte cfr = pmic.getFault(); // Get Battery Charger Failt Register
+  if (BatteryState>0 && BatteryState<6) {
+    BatteryPoC = System.batteryCharge();
+  }
+#endif
+  OBS_SetI(oidx, OBS_BCS, BatteryState);
+  OBS_SetF(oidx, OBS_BPC, BatteryPoC);
+  OBS_SetI(oidx, OBS_CFR, cfr);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_Rain() - Rain Gauges - Each tip is 0.2mm of rain. QC is rate based so it is done here.
+ * ======================================================================================================================
+ */
+void OBS_Read_Rain(int oidx) {
+  float rain = 0.0;
+  float rain2 = 0.0;
+  uint64_t rgms;         // rain gauge delta ms, since last rain gauge observation logged
+  uint64_t rg2ms;        // rain gauge delta ms, since last rain gauge observation logged
+  float intensity;
+  time32_t first, last;
+
+  rgms = System.millis()-raingauge1_interrupt_stime;
+  rain = raingauge1_interrupt_count * 0.2;
+  rain = (isnan(rain) || (rain < QC_MIN_RG) || (rain > QC_MAX_RG_MS(rgms)) ) ? QC_ERR_RG : rain;
+  raingauge1_interrupt_count = 0;
+  raingauge1_interrupt_stime = System.millis();
+  raingauge1_interrupt_ltime = 0; // used to debounce the tip
+
+  if (A4_State == A4_STATE_RAIN) {
+    rg2ms = System.millis()-raingauge2_interrupt_stime;
+    rain2 = raingauge2_interrupt_count * 0.2;
+    rain2 = (isnan(rain2) || (rain2 < QC_MIN_RG) || (rain2 > QC_MAX_RG_MS(rg2ms)) ) ? QC_ERR_RG : rain2;
+    raingauge2_interrupt_count = 0;
+    raingauge2_interrupt_stime = System.millis();
+    raingauge2_interrupt_ltime = 0; // used to debounce the tip
+  }
+
+  EEPROM_UpdateRainTotals(rain, rain2);
+
+  // Rate, intensity and tip times from the tip rings
+  Rain_TipsTake(&rain_tips[0]);
+  Rain_TipsObs(&rain_tips[0], &intensity, &first, &last);
+  EEPROM_RainUpdate(0, intensity, first, last);
+  if (A4_State == A4_STATE_RAIN) {
+    Rain_TipsTake(&rain_tips[1]);
+    Rain_TipsObs(&rain_tips[1], &intensity, &first, &last);
+    EEPROM_RainUpdate(1, intensity, first, last);
+  }
+
+  OBS_SetF(oidx, OBS_RG, rain);
+  // OBS_SetU(oidx, OBS_RGS, rgms/1000); // Add "rgs" to obs_schema[] before enabling
+  OBS_SetF(oidx, OBS_RGT, eeprom.rgt1);
+  OBS_SetF(oidx, OBS_RGP, eeprom.rgp1);
+  OBS_SetF(oidx, OBS_RGR, Rain_Rate(&rain_tips[0]));
+  OBS_SetF(oidx, OBS_RGI, eeprom_rain.rgi[0]);
+  if (eeprom_rain.rgf[0]) {
+    OBS_SetU(oidx, OBS_RGF, eeprom_rain.rgf[0]);
+    OBS_SetU(oidx, OBS_RGL, eeprom_rain.rgl[0]);
+  }
+
+  if (A4_State == A4_STATE_RAIN) {
+    OBS_SetF(oidx, OBS_RG2, rain2);
+    OBS_SetF(oidx, OBS_RGT2, eeprom.rgt2);
+    OBS_SetF(oidx, OBS_RGP2, eeprom.rgp2);
+    OBS_SetF(oidx, OBS_RGR2, Rain_Rate(&rain_tips[1]));
+    OBS_SetF(oidx, OBS_RGI2, eeprom_rain.rgi[1]);
+    if (eeprom_rain.rgf[1]) {
+      OBS_SetU(oidx, OBS_RGF2, eeprom_rain.rgf[1]);
+      OBS_SetU(oidx, OBS_RGL2, eeprom_rain.rgl[1]);
+    }
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_Wind() - Wind Speed, Direction, Gust and Gust Direction
+ * ======================================================================================================================
+ */
+void OBS_Read_Wind(int oidx) {
+  OBS_SetF(oidx, OBS_WS, Wind_SpeedAverage());
+  OBS_SetI(oidx, OBS_WD, Wind_DirectionVector());
+  OBS_SetF(oidx, OBS_WG, Wind_Gust());
+  OBS_SetI(oidx, OBS_WGD, Wind_GustDirection());
+  if (wind.gust_ts) {
+    OBS_SetU(oidx, OBS_WGT, (obs[oidx].ts > wind.gust_ts) ? (obs[oidx].ts - wind.gust_ts) : 0);
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_BMX() - BMP280, BME280, BMP388 or BMP390 Pressure, Temperature and Humidity
+ * ======================================================================================================================
+ */
+void OBS_Read_BMX(int oidx, byte chip_id, byte type, Adafruit_BMP280 &bmp, Adafruit_BME280 &bme, Adafruit_BMP3XX &bm3, 
+                  int sp, int st, int sh) {
+  float p = 0.0;
+  float t = 0.0;
+  float h = 0.0;
+
+  if (chip_id == BMP280_CHIP_ID) {
+    p = bmp.readPressure()/100.0F;       // hPa
+    t = bmp.readTemperature();
+  }
+  else if (chip_id == BME280_BMP390_CHIP_ID) {
+    if (type == BMX_TYPE_BME280) {
+      p = bme.readPressure()/100.0F;     // hPa
+      t = bme.readTemperature();
+      h = bme.readHumidity();
+    }
+    if (type == BMX_TYPE_BMP390) {
+      p = bm3.readPressure()/100.0F;     // hPa
+      t = bm3.readTemperature();
+    }    
+  }
+  else { // BMP388
+    p = bm3.readPressure()/100.0F;       // hPa
+    t = bm3.readTemperature();
+  }
+  OBS_SetF(oidx, sp, p);
+  OBS_SetF(oidx, st, t);
+  if (type == BMX_TYPE_BME280) {
+    OBS_SetF(oidx, sh, h);
+  }
+}
+
+void OBS_Read_BMX1(int oidx) {
+  OBS_Read_BMX(oidx, BMX_1_chip_id, BMX_1_type, bmp1, bme1, bm31, OBS_BP1, OBS_BT1, OBS_BH1);
+}
+
+void OBS_Read_BMX2(int oidx) {
+  OBS_Read_BMX(oidx, BMX_2_chip_id, BMX_2_type, bmp2, bme2, bm32, OBS_BP2, OBS_BT2, OBS_BH2);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_HTU() - HTU21DF Humidity and Temperature
+ * ======================================================================================================================
+ */
+void OBS_Read_HTU(int oidx) {
+  OBS_SetF(oidx, OBS_HH1, htu.readHumidity());
+  OBS_SetF(oidx, OBS_HT1, htu.readTemperature());
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_SHT1() / OBS_Read_SHT2() - SHT31 Temperature and Humidity
+ * ======================================================================================================================
+ */
+void OBS_Read_SHT1(int oidx) {
+  OBS_SetF(oidx, OBS_ST1, sht1.readTemperature());
+  OBS_SetF(oidx, OBS_SH1, sht1.readHumidity());
+}
+
+void OBS_Read_SHT2(int oidx) {
+  OBS_SetF(oidx, OBS_ST2, sht2.readTemperature());
+  OBS_SetF(oidx, OBS_SH2, sht2.readHumidity());
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_HDC() - HDC302x Temperature and Humidity, sets or clears status bit ssb on read error
+ * ======================================================================================================================
+ */
+void OBS_Read_HDC(int oidx, Adafruit_HDC302x &hdc, unsigned long ssb, int st, int sh) {
+  double t = -999.9;
+  double h = -999.9;
+
+  if (hdc.readTemperatureHumidityOnDemand(t, h, TRIGGERMODE_LP0)) {
+    SystemStatusBits &= ~ssb;  // Turn Off Bit
+  }
+  else {
+    sprintf (Buffer32Bytes, "ERR:HDC%d Read", (ssb == SSB_HDC_1) ? 1 : 2);
+    Output (Buffer32Bytes);
+    SystemStatusBits |= ssb;  // Turn On Bit
+  }
+  OBS_SetF(oidx, st, (float) t);
+  OBS_SetF(oidx, sh, (float) h);
+}
+
+void OBS_Read_HDC1(int oidx) {
+  OBS_Read_HDC(oidx, hdc1, SSB_HDC_1, OBS_HDT1, OBS_HDH1);
+}
+
+void OBS_Read_HDC2(int oidx) {
+  OBS_Read_HDC(oidx, hdc2, SSB_HDC_2, OBS_HDT2, OBS_HDH2);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_LPS1() / OBS_Read_LPS2() - LPS35HW Temperature and Pressure
+ * ======================================================================================================================
+ */
+void OBS_Read_LPS1(int oidx) {
+  OBS_SetF(oidx, OBS_LPT1, lps1.readTemperature());
+  OBS_SetF(oidx, OBS_LPP1, lps1.readPressure());
+}
+
+void OBS_Read_LPS2(int oidx) {
+  OBS_SetF(oidx, OBS_LPT2, lps2.readTemperature());
+  OBS_SetF(oidx, OBS_LPP2, lps2.readPressure());
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_HIH8() - HIH8000 Temperature and Humidity
+ * ======================================================================================================================
+ */
+void OBS_Read_HIH8(int oidx) {
+  float t = 0.0;
+  float h = 0.0;
+
+  if (!hih8_getTempHumid(&t, &h)) {
+    t = -999.99;
+    h = 0.0;
+  }
+  OBS_SetF(oidx, OBS_HT2, t);
+  OBS_SetF(oidx, OBS_HH2, h);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_SI1145() - SI1145 Visible, IR and UV
+ * ======================================================================================================================
+ */
+void OBS_Read_SI1145(int oidx) {
+  float si_vis = uv.readVisible();
+  float si_ir = uv.readIR();
+  float si_uv = uv.readUV()/100.0;
+
+  // Additional code to force sensor online if we are getting 0.0s back.
+  if ( ((si_vis+si_ir+si_uv) == 0.0) && ((si_last_vis+si_last_ir+si_last_uv) != 0.0) ) {
+    // Let Reset The SI1145 and try again
+    Output ("SI RESET");
+    if (uv.begin()) {
+      SI1145_exists = true;
+      Output ("SI ONLINE");
+      SystemStatusBits &= ~SSB_SI1145; // Turn Off Bit
+
+      si_vis = uv.readVisible();
+      si_ir = uv.readIR();
+      si_uv = uv.readUV()/100.0;
+    }
+    else {
+      SI1145_exists = false;
+      Output ("SI OFFLINE");
+      SystemStatusBits |= SSB_SI1145;  // Turn On Bit    
+    }
+  }
+
+  // Save current readings for next loop around compare
+  si_last_vis = si_vis;
+  si_last_ir = si_ir;
+  si_last_uv = si_uv;
+
+  OBS_SetF(oidx, OBS_SV1, si_vis);
+  OBS_SetF(oidx, OBS_SI1, si_ir);
+  OBS_SetF(oidx, OBS_SU1, si_uv);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_MCPn() - MCP9808 Air Temperature (MCP1, MCP2) and Globe Temperature (MCP3, MCP4)
+ * ======================================================================================================================
+ */
+void OBS_Read_MCP1(int oidx) {
+  OBS_SetF(oidx, OBS_MT1, mcp1.readTempC());
+}
+
+void OBS_Read_MCP2(int oidx) {
+  OBS_SetF(oidx, OBS_MT2, mcp2.readTempC());
+}
+
+void OBS_Read_MCP3(int oidx) {
+  OBS_SetF(oidx, OBS_GT1, mcp3.readTempC());
+}
+
+void OBS_Read_MCP4(int oidx) {
+  OBS_SetF(oidx, OBS_GT2, mcp4.readTempC());
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_VEML7700() / OBS_Read_BLX() - Auto Lux Values
+ * ======================================================================================================================
+ */
+void OBS_Read_VEML7700(int oidx) {
+  OBS_SetF(oidx, OBS_VLX, veml.readLux(VEML_LUX_AUTO));
+}
+
+void OBS_Read_BLX(int oidx) {
+  OBS_SetF(oidx, OBS_BLX, blx_takereading());
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_A4A5() - Distance Gauge or Raw readings on A4 and A5. Rain Gauge 2 on A4 is read by OBS_Read_Rain()
+ * ======================================================================================================================
+ */
+void OBS_Read_A4A5(int oidx) {
+  if (A4_State == A4_STATE_DISTANCE) {
+    OBS_SetF(oidx, OBS_SG, DistanceGauge_Median());
+    OBS_SetF(oidx, OBS_SGMN, DistanceGauge_Min());
+    OBS_SetF(oidx, OBS_SGMX, DistanceGauge_Max());
+  }
+  if (A4_State == A4_STATE_RAW) {
+    OBS_SetF(oidx, OBS_A4R, Pin_ReadAvg(A4));
+  }
+  if (A5_State == A5_STATE_RAW) {
+    OBS_SetF(oidx, OBS_A5R, Pin_ReadAvg(A5));
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_PM25AQI() - Max PM concentrations in µg 𝑚3 since last observation
+ * ======================================================================================================================
+ */
+void OBS_Read_PM25AQI(int oidx) {
+  OBS_SetI(oidx, OBS_PM1S10, pm25aqi_obs.max_s10);    // Standard Particle PM1.0
+  OBS_SetI(oidx, OBS_PM1S25, pm25aqi_obs.max_s25);    // Standard Particle PM2.5
+  OBS_SetI(oidx, OBS_PM1S100, pm25aqi_obs.max_s100);  // Standard Particle PM10.0
+  OBS_SetI(oidx, OBS_PM1E10, pm25aqi_obs.max_e10);    // Atmospheric Environmental PM1.0
+  OBS_SetI(oidx, OBS_PM1E25, pm25aqi_obs.max_e25);    // Atmospheric Environmental PM2.5
+  OBS_SetI(oidx, OBS_PM1E100, pm25aqi_obs.max_e100);  // Atmospheric Environmental PM10.0
+
+  // Clear readings
+  pm25aqi_clear();
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_TLW() - Tinovi Leaf Wetness
+ * ======================================================================================================================
+ */
+void OBS_Read_TLW(int oidx) {
+  tlw.newReading();
+  delay(100);
+  OBS_SetF(oidx, OBS_TLWW, tlw.getWet());
+  OBS_SetF(oidx, OBS_TLWT, tlw.getTemp());
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_TSM() - Tinovi Soil Moisture
+ * ======================================================================================================================
+ */
+void OBS_Read_TSM(int oidx) {
+  tsm.newReading();
+  delay(100);
+  OBS_SetF(oidx, OBS_TSME25, tsm.getE25());
+  OBS_SetF(oidx, OBS_TSMEC, tsm.getEC());
+  OBS_SetF(oidx, OBS_TSMVWC, tsm.getVWC());
+  OBS_SetF(oidx, OBS_TSMT, tsm.getTemp());
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_TMSM() - Tinovi Multi Level Soil Moisture
+ * ======================================================================================================================
+ */
+void OBS_Read_TMSM(int oidx) {
+  soil_ret_t multi;
+
+  tmsm.newReading();
+  delay(100);
+  tmsm.getData(&multi);
+
+  OBS_SetF(oidx, OBS_TMSMS1, (float) multi.vwc[0]);
+  OBS_SetF(oidx, OBS_TMSMS2, (float) multi.vwc[1]);
+  OBS_SetF(oidx, OBS_TMSMS3, (float) multi.vwc[2]);
+  OBS_SetF(oidx, OBS_TMSMS4, (float) multi.vwc[3]);
+  OBS_SetF(oidx, OBS_TMSMT1, (float) multi.temp[0]);
+  OBS_SetF(oidx, OBS_TMSMT2, (float) multi.temp[1]);
+}
+
+#if PLATFORM_ID == PLATFORM_MSOM
+/*
+ * ======================================================================================================================
+ * OBS_Read_PMTS() - Particle Muon on board temperature sensor (Not an environmental sensor, no QC)
+ * ======================================================================================================================
+ */
+void OBS_Read_PMTS(int oidx) {
+  OBS_SetF(oidx, OBS_PMTS, ptms_readtempc());
+}
+#endif
+
+/*
+ * ======================================================================================================================
+ * OBS_Read_HI() / OBS_Read_WBT() / OBS_Read_WBGT() - Derived from the QC'd SHT1 and MCP3 Globe readings
+ * ======================================================================================================================
+ */
+void OBS_Read_HI(int oidx) {
+  OBS_SetF(oidx, OBS_HI, (float) hi_calculate(OBS_GetF(oidx, OBS_ST1), OBS_GetF(oidx, OBS_SH1)));
+}
+
+void OBS_Read_WBT(int oidx) {
+  OBS_SetF(oidx, OBS_WBT, (float) wbt_calculate(OBS_GetF(oidx, OBS_ST1), OBS_GetF(oidx, OBS_SH1)));
+}
+
+void OBS_Read_WBGT(int oidx) {
+  float wbgt = 0.0;
+
+  if (MCP_3_exists) {
+    // TempAir, TempGlobe, TempWetBulb
+    wbgt = wbgt_using_wbt(OBS_GetF(oidx, OBS_ST1), OBS_GetF(oidx, OBS_GT1), OBS_GetF(oidx, OBS_WBT));
+  }
+  else {
+    wbgt = wbgt_using_hi(OBS_GetF(oidx, OBS_HI));
+  }
+  OBS_SetF(oidx, OBS_WBGT, (float) wbgt);
+}
+
+/*
+ * ======================================================================================================================
+ *  Sensor tables - Read in order listed, order values are reported is set by obs_schema[]
+ * ======================================================================================================================
+ */
+const OBS_SENSOR_STR obs_sensors[] = {
+  {"BAT",     NULL,              OBS_Read_Battery},
+  {"RAIN",    NULL,              OBS_Read_Rain},
+  {"WIND",    NULL,              OBS_Read_Wind},
+  {"BMX1",    &BMX_1_exists,     OBS_Read_BMX1},
+  {"BMX2",    &BMX_2_exists,     OBS_Read_BMX2},
+  {"HTU",     &HTU21DF_exists,   OBS_Read_HTU},
+  {"SHT1",    &SHT_1_exists,     OBS_Read_SHT1},
+  {"SHT2",    &SHT_2_exists,     OBS_Read_SHT2},
+  {"HDC1",    &HDC_1_exists,     OBS_Read_HDC1},
+  {"HDC2",    &HDC_2_exists,     OBS_Read_HDC2},
+  {"LPS1",    &LPS_1_exists,     OBS_Read_LPS1},
+  {"LPS2",    &LPS_2_exists,     OBS_Read_LPS2},
+  {"HIH8",    &HIH8_exists,      OBS_Read_HIH8},
+  {"SI",      &SI1145_exists,    OBS_Read_SI1145},
+  {"MCP1",    &MCP_1_exists,     OBS_Read_MCP1},
+  {"MCP2",    &MCP_2_exists,     OBS_Read_MCP2},
+  {"MCP3",    &MCP_3_exists,     OBS_Read_MCP3},
+  {"MCP4",    &MCP_4_exists,     OBS_Read_MCP4},
+  {"VEML",    &VEML7700_exists,  OBS_Read_VEML7700},
+  {"BLX",     &BLX_exists,       OBS_Read_BLX},
+  {"A4A5",    NULL,              OBS_Read_A4A5},
+  {"PM",      &PM25AQI_exists,   OBS_Read_PM25AQI},
+  {"TLW",     &TLW_exists,       OBS_Read_TLW},
+  {"TSM",     &TSM_exists,       OBS_Read_TSM},
+  {"TMSM",    &TMSM_exists,      OBS_Read_TMSM},
+#if PLATFORM_ID == PLATFORM_MSOM
+  {"PMTS",    &PMTS_exists,      OBS_Read_PMTS},
+#endif
+};
+#define OBS_SENSOR_CNT (sizeof(obs_sensors) / sizeof(obs_sensors[0]))
+
+const OBS_SENSOR_STR obs_derived[] = {
+  {"HI",      &HI_exists,        OBS_Read_HI},
+  {"WBT",     &WBT_exists,       OBS_Read_WBT},
+  {"WBGT",    &WBGT_exists,      OBS_Read_WBGT},
+};
+#define OBS_DERIVED_CNT (sizeof(obs_derived) / sizeof(obs_derived[0]))
+
+/*
+ * ======================================================================================================================
+ * OBS_Sensors_Read() - Call the read function of each present sensor in table t
+ * ======================================================================================================================
+ */
+void OBS_Sensors_Read(const OBS_SENSOR_STR *t, size_t cnt, int oidx) {
+  for (size_t n=0; n<cnt; n++) {
+    if ((t[n].exists == NULL) || *t[n].exists) {
+      WIRE_LOCK(); // Per sensor, so the sampler thread gets the bus between them
+      t[n].read(oidx);
+    }
+  }
+}
+
+/*
+ * ======================================================================================================================
+ *  QC limits - One entry per schema tag, loaded from obs_schema[] (QC.h) by OBS_QC_Init() and optionally
+ *  overridden from CONFIG.TXT by OBS_QC_ReadConfig() with lines of the form
+ *  
+ *    qc_<tag>=min,max[,roc[,stuck]]
+ *  
+ *    min,max  Range check, a value outside is replaced by the QC error value. Checked when min < max
+ *    roc      Rate of change, max change from the last good value per minute. 0 = off
+ *    stuck    Flag the value after this many identical readings in a row. 0 = off
+ *  
+ *  The rate of change and stuck checks keep the last value per tag so each check is O(1).
+ * ======================================================================================================================
+ */
+typedef struct {
+  float         min;
+  float         max;
+  float         err;
+  float         roc;            // Max change per minute, 0 = off
+  uint16_t      stuck;          // Max identical readings in a row, 0 = off
+  bool          have_good;      // good and good_ts are set
+  float         good;           // Last value that passed QC
+  time32_t      good_ts;
+  bool          have_prev;      // prev is set
+  float         prev;           // Last value read, used for the stuck check
+  uint16_t      same;           // Number of readings in a row equal to prev
+} OBS_QC_STR;
+OBS_QC_STR obs_qc[OBS_SCHEMA_CNT];
+
+/*
+ * ======================================================================================================================
+ * OBS_QC_Init() - Load QC limits from the schema and clear rate of change and stuck state
+ * ======================================================================================================================
+ */
+void OBS_QC_Init() {
+  memset(obs_qc, 0, sizeof(obs_qc));
+  for (int s=0; s<OBS_SCHEMA_CNT; s++) {
+    obs_qc[s].min = obs_schema[s].qc_min;
+    obs_qc[s].max = obs_schema[s].qc_max;
+    obs_qc[s].err = obs_schema[s].qc_err;
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_QC_ReadConfig() - Read all qc_<tag>= lines from CONFIG.TXT in one pass
+ * ======================================================================================================================
+ */
+void OBS_QC_ReadConfig() {
+  char line[LINE_MAX_LENGTH+1];
+  int len;
+
+  // Disable LoRA SPI0 Chip Select
+  pinMode(LORA_SS, OUTPUT);
+  digitalWrite(LORA_SS, HIGH);
+
+  File configFile = SD.open(CF_NAME);
+  if (!configFile) {
+    return;
+  }
+
+  while (configFile.available()) {
+    len = configFile.readBytesUntil('\n', line, LINE_MAX_LENGTH);
+    if ((len > 0) && (line[len-1] == '\r')) {
+      len--; // trim the \r
+    }
+    line[len] = 0;
+
+    if (strncmp(line, "qc_", 3) != 0) {
+      continue;
+    }
+    char *value = strchr(line, '=');
+    if (value == NULL) {
+      continue;
+    }
+    *value++ = 0;
+
+    int s;
+    for (s=0; s<OBS_SCHEMA_CNT; s++) {
+      if (strcmp(line+3, obs_schema[s].id) == 0) {
+        break;
+      }
+    }
+    if (s == OBS_SCHEMA_CNT) {
+      sprintf(msgbuf, "CF:%s UNKNOWN TAG", line); Output (msgbuf);
+      continue;
+    }
+
+    // min,max[,roc[,stuck]]
+    float f[4] = {obs_qc[s].min, obs_qc[s].max, 0.0, 0.0};
+    char *field = value;
+    for (int n=0; (n<4) && field; n++) {
+      char *next = strchr(field, ',');
+      int flen = (next) ? (next - field) : strlen(field);
+      if (flen > 0) {
+        f[n] = HELPER_ascii2Float(field, flen);
+      }
+      field = (next) ? next+1 : NULL;
+    }
+    obs_qc[s].min = f[0];
+    obs_qc[s].max = f[1];
+    obs_qc[s].roc = (f[2] > 0) ? f[2] : 0.0;
+    obs_qc[s].stuck = (f[3] > 0) ? (uint16_t) f[3] : 0;
+    sprintf(msgbuf, "CF:%s=[%s]", line, value); Output (msgbuf);
   }
+  configFile.close();
 }
 
 /*
  * ======================================================================================================================
- * OBS_FS_Build_JSON() - Create JSON observation in msgbuf
+ * OBS_QC_Check() - Return true if value v of schema entry s taken at time ts passes QC, update the QC state
  * ======================================================================================================================
  */
-bool OBS_FS_Build_JSON(int i) {
-  if (obs[i].inuse) {     // Sanity check
-    char ts[32];
-    
-    memset(msgbuf, 0, sizeof(msgbuf));
-
-    JSONBufferWriter writer(msgbuf, sizeof(msgbuf)-1);
-    writer.beginObject();
+bool OBS_QC_Check(int s, float v, time32_t ts) {
+  OBS_QC_STR *q = &obs_qc[s];
 
-    sprintf (ts, "%d-%02d-%02dT%02d:%02d:%02d",
-      Time.year(obs[i].ts), Time.month(obs[i].ts), Time.day(obs[i].ts),
-      Time.hour(obs[i].ts), Time.minute(obs[i].ts), Time.second(obs[i].ts));
+  if (isnan(v)) {
+    return (false);
+  }
+  if ((q->min < q->max) && ((v < q->min) || (v > q->max))) {
+    return (false);
+  }
 
-    writer.name("at").value(ts);
-    writer.name("css").value(obs[i].css, 4);
-    writer.name("hth").value((int) obs[i].hth);
+  if (q->stuck) {
+    q->same = (q->have_prev && (v == q->prev)) ? q->same + 1 : 1;
+    q->prev = v;
+    q->have_prev = true;
+    if (q->same > q->stuck) {
+      return (false);
+    }
+  }
 
-    for (int s=0; s<MAX_SENSORS; s++) {
-      if (obs[i].sensor[s].inuse) {
-        switch (obs[i].sensor[s].type) {
-          case F_OBS :
-            // sprintf (Buffer32Bytes, "%s=%.4f", obs[i].sensor[s].id, obs[i].sensor[s].f_obs);
-            // Output (Buffer32Bytes);
-            writer.name(obs[i].sensor[s].id).value(obs[i].sensor[s].f_obs, 1);
-            break;
-          case I_OBS :
-            writer.name(obs[i].sensor[s].id).value(obs[i].sensor[s].i_obs);
-            break;
-          case U_OBS :
-            writer.name(obs[i].sensor[s].id).value((int) obs[i].sensor[s].u_obs);
-            break;
-          default : // Should never happen
-            Output ("WhyAmIHere?");
-            break;
-        }
+  if (q->roc > 0) {
+    if (q->have_good) {
+      // Allowed change grows with the time since the last good value so a real step change is accepted later
+      long minutes = (ts - q->good_ts + 59) / 60;
+      if (fabs(v - q->good) > (q->roc * ((minutes > 0) ? minutes : 1))) {
+        return (false);
       }
     }
-    writer.endObject();
-    return (true);
-  }
-  else {
-    return (false);
   }
+  q->good = v;
+  q->good_ts = ts;
+  q->have_good = true;
+  return (true);
 }
 
 /*
  * ======================================================================================================================
- * OBS_Relay_Build_JSON() - Create JSON observation in msgbuf, remove from relay structure
- *                          Return the message relay type we are preparing
+ * OBS_QC() - Check every value in observation i in one pass, failed values are replaced by the QC error value
+ *            Values with a bit set in checked (present[] from an earlier pass, NULL = none) are skipped, the
+ *            rate of change and stuck state would count them twice.
  * ======================================================================================================================
  */
-int OBS_Relay_Build_JSON() {
-  LORA_MSG_RELAY_STR *m;
-  int relay_type = 0;
-
-  memset(msgbuf, 0, sizeof(msgbuf));
-  JSONBufferWriter writer(msgbuf, sizeof(msgbuf)-1);
-
-  // Locate message we need to log
-  int i = lora_relay_need2log_idx();
-  if (i >= 0) {
-    m = &lora_msg_relay[i];
-    strncpy (msgbuf, m->message, LORA_RELAY_MSG_LENGTH-1); // minus 1 so last byte in array will always be null
-    relay_type = m->message_type;
-    lora_relay_msg_free(m);
+void OBS_QC(int oidx, const uint32_t *checked) {
+  for (int s=0; s<OBS_SCHEMA_CNT; s++) {
+    if (OBS_Present(oidx, s) && !(checked && (checked[s>>5] & (1UL << (s&31))))) {
+      OBS_VALUE *v = &obs[oidx].value[s];
+
+      if (obs_schema[s].type == F_OBS) {
+        if (!OBS_QC_Check(s, v->f, obs[oidx].ts)) {
+          v->f = obs_qc[s].err;
+        }
+      }
+      else if (obs_schema[s].type == I_OBS) {
+        if (!OBS_QC_Check(s, (float) v->i, obs[oidx].ts)) {
+          v->i = (int32_t) obs_qc[s].err;
+        }
+      }
+    }
   }
-  return (relay_type);
 }
 
 /*
  * ======================================================================================================================
- * OBS_Log() - Save OBS to Log file
+ *  Observation clock - Observations are made on UTC boundaries that are a multiple of the obs interval
+ *
+ *  obs_interval in CONFIG.TXT is seconds (0 = OBSERVATION_INTERVAL), it must divide an hour evenly so every
+ *  station lands on the same instants. OBS_Due() is true once Time.now() reaches obs_next_ts and the
+ *  observation is stamped with that boundary, not with how late we got to it. If we get to it a whole
+ *  interval or more late, the missed boundaries are counted in obs_overruns and we take the latest one
+ *  that has passed, so catching up is always to the same boundaries and never a burst of observations.
  * ======================================================================================================================
  */
-void OBS_Log(int i) {
-  if (OBS_FS_Build_JSON(i)) {
-    sprintf (Buffer32Bytes, "OBS[%d]->SD", i);
-    Output(Buffer32Bytes);
-    Serial_write (msgbuf);
-
-    SD_LogObservation(msgbuf);
-  }
-}
+time32_t obs_next_ts = 0;       // Next observation boundary, 0 = not set
+time32_t obs_due_ts = 0;        // Boundary OBS_Do() stamps the observation with
+uint32_t obs_overruns = 0;      // Boundaries missed
 
 /*
  * ======================================================================================================================
- * OBS_N2S_SaveAll() - Save All N Observations to Need2Send File
+ * OBS_Interval() - Seconds between observations
  * ======================================================================================================================
  */
-void OBS_N2S_SaveAll() {
-  int relay_type;
-
-  // Save All Station Observations to N2S file
-  for (int i=0; i<MAX_ONE_MINUTE_OBS; i++) {
-    OBS_N2S_Add (i);
-    OBS_Clear(i);
-  }
-
-  // Save All Rain and Soil LoRa Observations to N2S file
-  while (lora_relay_need2log()) {
-   relay_type = OBS_Relay_Build_JSON(); // This removed msg from relay structure and places it in msgbuf
-    sprintf (msgbuf+strlen(msgbuf), ", %s", relay_msgtypes[relay_type]);  // Add Particle Event Type after JSON structure
-    SD_NeedToSend_Add(msgbuf); // Save to N2F File
-    Output("LR->N2S");
-    Serial_write (msgbuf); 
-  }
+int OBS_Interval() {
+  return ((cf_obs_interval > 0) ? cf_obs_interval : (OBSERVATION_INTERVAL / 1000));
 }
 
 /*
  * ======================================================================================================================
- * OBS_Last() - Find Last OBS and return index or -1 if empty
+ * OBS_Secs2Due() - Seconds until the next observation boundary, 0 or less if it is due
  * ======================================================================================================================
  */
-int OBS_Last() {
-  // Scan OBS for free spot
-  for (int i=0; i<MAX_ONE_MINUTE_OBS; i++){
-    if (obs[i].inuse == false) {
-      if (i == 0) {
-        return (-1);
-      }
-      else {
-        return (i-1);
-      }
-    }
+long OBS_Secs2Due() {
+  time32_t now = Time.now();
+  time32_t interval = OBS_Interval();
+
+  if ((obs_next_ts == 0) || (obs_next_ts > (now + interval))) {
+    // First time or the clock was set back, line up on the next boundary
+    obs_next_ts = now - (now % interval) + interval;
   }
-  // Arrary full, Never found an empty, return last in Array
-  return (MAX_ONE_MINUTE_OBS-1);
+  return (obs_next_ts - now);
 }
 
 /*
  * ======================================================================================================================
- * OBS_Full() - Return true if there are open spots
+ * OBS_Due() - Return true if it is time for an observation
  * ======================================================================================================================
  */
-bool OBS_Full() {
-  // Scan OBS for free spot
-  for (int i=0; i<MAX_ONE_MINUTE_OBS; i++){
-    if (obs[i].inuse == false) {
-      return (false);
-    }
-  }
-  return (true);
+bool OBS_Due() {
+  return (Time.isValid() && (OBS_Secs2Due() <= 0));
 }
 
 /*
  * ======================================================================================================================
- * OBS_Open() - Find a free OBS and return index
+ * OBS_Clock_Advance() - Set obs_due_ts to the boundary being observed and obs_next_ts to the one after
  * ======================================================================================================================
  */
-int OBS_Open() {
-  // Scan OBS for free spot
-  for (int i=0; i<MAX_ONE_MINUTE_OBS; i++){
-    if (obs[i].inuse == false) {
-      return (i);
-    }
+void OBS_Clock_Advance() {
+  time32_t now = Time.now();
+  time32_t interval = OBS_Interval();
+  time32_t missed;
+
+  OBS_Secs2Due();
+  obs_due_ts = obs_next_ts;
+  if (now >= (obs_next_ts + interval)) {
+    // Overrun, use the latest boundary that has passed
+    missed = (now - obs_next_ts) / interval;
+    obs_overruns += missed;
+    obs_due_ts = obs_next_ts + (missed * interval);
+    sprintf (Buffer32Bytes, "OBS:OVERRUN %lu", (unsigned long) missed);
+    Output (Buffer32Bytes);
   }
-
-  // All Observations are inuse
-  Output ("OBS[ALL]->N2S");
-
-  // Save All N Observations to Need2Send File
-  OBS_N2S_SaveAll();
-
-  // All OBS are Clear so return the first OBS 
-  return (0);
+  obs_next_ts = obs_due_ts + interval;
 }
 
 /*
  * ======================================================================================================================
- * OBS_Do() - Get Observations - Should be called once a minute
+ * OBS_Do() - Get Observations - Called when OBS_Due()
  * ======================================================================================================================
  */
 void OBS_Do() {
   int oidx;
-  int sidx = 0;;
-  float rain = 0.0;
-  float rain2 = 0.0;
-  float ws = 0.0;
-  int wd = 0;
-  unsigned long rgds;    // rain gauge delta seconds, seconds since last rain gauge observation logged
-  unsigned long rg2ds;   // rain gauge delta seconds, seconds since last rain gauge observation logged
-  float BatteryPoC = 0.0; // Battery Percent of Charge
-  float mcp1_temp = 0.0;  // air temperature
-  float mcp3_temp = 0.0;  // globe temperature
-  float wetbulb_temp = 0.0;
-  float sht1_humid = 0.0;
-  float sht1_temp = 0.0;
-  float heat_index = 0.0;
 
 // Output("DB:OBS_Start");
 
-
   // Safty Check for Vaild Time
   if (!Time.isValid()) {
     Output ("OBS_Do: Time NV");
     return;
   }
 
+  OBS_Clock_Advance();
+
   Wind_GustUpdate(); // Update Gust and Gust Direction readings
   
 #if PLATFORM_ID == PLATFORM_ARGON
-  int BatteryState = 0;
   WiFiSignal sig = WiFi.RSSI();
-  byte cfr = 0;
 #else
-  int BatteryState = System.batteryState();
   CellularSignal sig = Cellular.RSSI();
-  byte cfr = pmic.getFault(); // Get Battery Charger Failt Register
-  if (BatteryState>0 && BatteryState<6) {
-    BatteryPoC = System.batteryCharge();
-  }
 #endif
 
   oidx = OBS_Open();    // Get a free observation spot
 
   obs[oidx].inuse = true;
-  obs[oidx].ts = Time.now();
+  obs[oidx].ts = obs_due_ts;   // On the boundary, so observations from all stations line up
   obs[oidx].css = sig.getStrength();
 
-  // 00 Battery Charging State
-  strcpy (obs[oidx].sensor[sidx].id, "bcs");
-  obs[oidx].sensor[sidx].type = I_OBS;
-  obs[oidx].sensor[sidx].i_obs = BatteryState;
-  obs[oidx].sensor[sidx++].inuse = true;
-
-  // 01 Battery Percent Charge
-  strcpy (obs[oidx].sensor[sidx].id, "bpc");
-  obs[oidx].sensor[sidx].type = F_OBS;
-  obs[oidx].sensor[sidx].f_obs = BatteryPoC;
-  obs[oidx].sensor[sidx++].inuse = true;
-
-  // 02 Battery Charger Fault Register
-  strcpy (obs[oidx].sensor[sidx].id, "cfr");
-  obs[oidx].sensor[sidx].type = I_OBS;
-  obs[oidx].sensor[sidx].i_obs = cfr;
-  obs[oidx].sensor[sidx++].inuse = true;
-
-  // 03 Rain Gauge - Each tip is 0.2mm of rain
-  rgds = (System.millis()-raingauge1_interrupt_stime)/1000;
-  rain = raingauge1_interrupt_count * 0.2;
-  rain = (isnan(rain) || (rain < QC_MIN_RG) || (rain > ((rgds / 60) * QC_MAX_RG)) ) ? QC_ERR_RG : rain;
-  raingauge1_interrupt_count = 0;
-  raingauge1_interrupt_stime = System.millis();
-  raingauge1_interrupt_ltime = 0; // used to debounce the tip
-
-  if (A4_State == A4_STATE_RAIN) {
-    rg2ds = (System.millis()-raingauge2_interrupt_stime)/1000;
-    rain2 = raingauge2_interrupt_count * 0.2;
-    rain2 = (isnan(rain2) || (rain2 < QC_MIN_RG) || (rain2 > ((rg2ds / 60) * QC_MAX_RG)) ) ? QC_ERR_RG : rain2;
-    raingauge2_interrupt_count = 0;
-    raingauge2_interrupt_stime = System.millis();
-    raingauge2_interrupt_ltime = 0; // used to debounce the tip
-  }
-
-// Output("DB:OBS_URT");
-  EEPROM_UpdateRainTotals(rain, rain2);
-// Output("DB:OBS_URTx");
-
-  // 04 Rain Gauge
-  strcpy (obs[oidx].sensor[sidx].id, "rg");
-  obs[oidx].sensor[sidx].type = F_OBS;
-  obs[oidx].sensor[sidx].f_obs = rain;
-  obs[oidx].sensor[sidx++].inuse = true;
-
-  // 05 Rain Gauge Delta Seconds
-  // strcpy (obs[oidx].sensor[sidx].id, "rgs");
-  // obs[oidx].sensor[sidx].type = U_OBS;
-  // obs[oidx].sensor[sidx].u_obs = rgds;
-  // obs[oidx].sensor[sidx++].inuse = true;
-
-  // 06 Rain Gauge Total
-  strcpy (obs[oidx].sensor[sidx].id, "rgt");
-  obs[oidx].sensor[sidx].type = F_OBS;
-  obs[oidx].sensor[sidx].f_obs = eeprom.rgt1;
-  obs[oidx].sensor[sidx++].inuse = true;
-
-  // 07 Rain Gauge  Prior Day
-  strcpy (obs[oidx].sensor[sidx].id, "rgp");
-  obs[oidx].sensor[sidx].type = F_OBS;
-  obs[oidx].sensor[sidx].f_obs = eeprom.rgp1;
-  obs[oidx].sensor[sidx++].inuse = true;
-
-  // 08 Wind Speed (Global)
-  strcpy (obs[oidx].sensor[sidx].id, "ws");
-  obs[oidx].sensor[sidx].type = F_OBS;
-  ws = Wind_SpeedAverage();
-  ws = (isnan(ws) || (ws < QC_MIN_WS) || (ws > QC_MAX_WS)) ? QC_ERR_WS : ws;
-  obs[oidx].sensor[sidx].f_obs = ws;
-  obs[oidx].sensor[sidx++].inuse = true;
-
-  // 09 Wind Direction
-  strcpy (obs[oidx].sensor[sidx].id, "wd");
-  obs[oidx].sensor[sidx].type = I_OBS;
-  wd = Wind_DirectionVector();
-  wd = (isnan(wd) || (wd < QC_MIN_WD) || (wd > QC_MAX_WD)) ? QC_ERR_WD : wd;
-  obs[oidx].sensor[sidx].i_obs = wd;
-  obs[oidx].sensor[sidx++].inuse = true;
-
-  // 10 Wind Gust (Global)
-  strcpy (obs[oidx].sensor[sidx].id, "wg");
-  obs[oidx].sensor[sidx].type = F_OBS;
-  ws = Wind_Gust();
-  ws = (isnan(ws) || (ws < QC_MIN_WS) || (ws > QC_MAX_WS)) ? QC_ERR_WS : ws;
-  obs[oidx].sensor[sidx].f_obs = ws;
-  obs[oidx].sensor[sidx++].inuse = true;
-
-  // 11 Wind Gust Direction (Global)
-  strcpy (obs[oidx].sensor[sidx].id, "wgd");
-  obs[oidx].sensor[sidx].type = I_OBS;
-  wd = Wind_GustDirection();
-  wd = (isnan(wd) || (wd < QC_MIN_WD) || (wd > QC_MAX_WD)) ? QC_ERR_WD : wd;
-  obs[oidx].sensor[sidx].i_obs = wd;
-  obs[oidx].sensor[sidx++].inuse = true;
-
-// Output("DB:OBS_I2C");
-
-  //
-  // Add I2C Sensors
-  //
-  if (BMX_1_exists) {
-// Output("DB:OBS_BMX1");
-
-    float p = 0.0;
-    float t = 0.0;
-    float h = 0.0;
-
-    if (BMX_1_chip_id == BMP280_CHIP_ID) {
-      p = bmp1.readPressure()/100.0F;       // bp1 hPa
-      t = bmp1.readTemperature();           // bt1
-    }
-    else if (BMX_1_chip_id == BME280_BMP390_CHIP_ID) {
-      if (BMX_1_type == BMX_TYPE_BME280) {
-        p = bme1.readPressure()/100.0F;     // bp1 hPa
-        t = bme1.readTemperature();         // bt1
-        h = bme1.readHumidity();            // bh1 
-      }
-      if (BMX_1_type == BMX_TYPE_BMP390) {
-        p = bm31.readPressure()/100.0F;     // bp1 hPa
-        t = bm31.readTemperature();         // bt1 
-      }    
-    }
-    else { // BMP388
-      p = bm31.readPressure()/100.0F;       // bp1 hPa
-      t = bm31.readTemperature();           // bt1
-    }
-    p = (isnan(p) || (p < QC_MIN_P)  || (p > QC_MAX_P))  ? QC_ERR_P  : p;
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-    
-    // 12 BMX1 Preasure
-    strcpy (obs[oidx].sensor[sidx].id, "bp1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = p;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 13 BMX1 Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "bt1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = t;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 14 BMX1 Humidity
-    if (BMX_1_type == BMX_TYPE_BME280) {
-      strcpy (obs[oidx].sensor[sidx].id, "bh1");
-      obs[oidx].sensor[sidx].type = F_OBS;
-      obs[oidx].sensor[sidx].f_obs = h;
-      obs[oidx].sensor[sidx++].inuse = true;
-    }
-// Output("DB:OBS_BMX1x");
-  }
-
-  if (BMX_2_exists) {
-// Output("DB:OBS_BMX2");
-
-    float p = 0.0;
-    float t = 0.0;
-    float h = 0.0;
-
-    if (BMX_2_chip_id == BMP280_CHIP_ID) {
-      p = bmp2.readPressure()/100.0F;       // bp2 hPa
-      t = bmp2.readTemperature();           // bt2
-    }
-    else if (BMX_2_chip_id == BME280_BMP390_CHIP_ID) {
-      if (BMX_2_type == BMX_TYPE_BME280) {
-        p = bme2.readPressure()/100.0F;     // bp2 hPa
-        t = bme2.readTemperature();         // bt2
-        h = bme2.readHumidity();            // bh2 
-      }
-      if (BMX_2_type == BMX_TYPE_BMP390) {
-        p = bm32.readPressure()/100.0F;     // bp2 hPa
-        t = bm32.readTemperature();         // bt2       
-      }
-    }
-    else { // BMP388
-      p = bm32.readPressure()/100.0F;       // bp2 hPa
-      t = bm32.readTemperature();           // bt2
-    }
-    p = (isnan(p) || (p < QC_MIN_P)  || (p > QC_MAX_P))  ? QC_ERR_P  : p;
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-
-    // 15 BMX2 Preasure
-    strcpy (obs[oidx].sensor[sidx].id, "bp2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = p;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 16 BMX2 Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "bt2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = t;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 17 BMX2 Humidity
-    if (BMX_2_type == BMX_TYPE_BME280) {
-      strcpy (obs[oidx].sensor[sidx].id, "bh2");
-      obs[oidx].sensor[sidx].type = F_OBS;
-      obs[oidx].sensor[sidx].f_obs = h;
-      obs[oidx].sensor[sidx++].inuse = true;
-    }
-// Output("DB:OBS_BMX2x");
-  }
-
-  if (HTU21DF_exists) {
-// Output("DB:OBS_HTU");
-
-    float t = 0.0;
-    float h = 0.0;
-
-    // 18 HTU Humidity
-    strcpy (obs[oidx].sensor[sidx].id, "hh1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    h = htu.readHumidity();
-    h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-    obs[oidx].sensor[sidx].f_obs = h;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 19 HTU Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "ht1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    t = htu.readTemperature();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    obs[oidx].sensor[sidx].f_obs = t;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_HTUx");
-  }
-
-  if (SHT_1_exists) {
-// Output("DB:OBS_SHT1");
-
-    float t = 0.0;
-    float h = 0.0;
-
-    // 20 SHT1 Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "st1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    t = sht1.readTemperature();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    obs[oidx].sensor[sidx].f_obs = t;
-    obs[oidx].sensor[sidx++].inuse = true;
-    sht1_temp = t; // save for derived observations
-
-    // 21 SHT1 Humidity
-    strcpy (obs[oidx].sensor[sidx].id, "sh1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    h = sht1.readHumidity();
-    h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-    obs[oidx].sensor[sidx].f_obs = h;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    sht1_humid = h; // save for derived observations
-// Output("DB:OBS_SHT1x");
-  }
-
-  if (SHT_2_exists) {
-// Output("DB:OBS_SHT2");
-
-    float t = 0.0;
-    float h = 0.0;
-
-    // 22 SHT2 Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "st2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    t = sht2.readTemperature();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    obs[oidx].sensor[sidx].f_obs = t;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 23 SHT2 Humidity
-    strcpy (obs[oidx].sensor[sidx].id, "sh2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    h = sht2.readHumidity();
-    h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-    obs[oidx].sensor[sidx].f_obs = h;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_SSHt2x");
-  }
-
-  if (HDC_1_exists) {
-// Output("DB:OBS_HDC1");
-
-    double t = -999.9;
-    double h = -999.9;
-
-    if (hdc1.readTemperatureHumidityOnDemand(t, h, TRIGGERMODE_LP0)) {
-      t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-      h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-      SystemStatusBits &= ~ SSB_HDC_1;  // Turn Off Bit
-    }
-    else {
-      Output ("ERR:HDC1 Read");
-      SystemStatusBits |= SSB_HDC_1;  // Turn On Bit
-    }
-
-    // 24 HDC1 Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "hdt1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) t;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 25 HDC1 Humidity
-    strcpy (obs[oidx].sensor[sidx].id, "hdh1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) h;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_HDC1x");
-
-  }
-
-  if (HDC_2_exists) {
-// Output("DB:OBS_HDC2");
-
-    double t = -999.9;
-    double h = -999.9;
-
-    if (hdc2.readTemperatureHumidityOnDemand(t, h, TRIGGERMODE_LP0)) {
-      t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-      h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-      SystemStatusBits &= ~ SSB_HDC_2;  // Turn Off Bit
-    }
-    else {
-      Output ("ERR:HDC1 Read");
-      SystemStatusBits |= SSB_HDC_2;  // Turn On Bit
-    }
-
-    // 26 HDC2 Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "hdt2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) t;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 27 HDC2 Humidity
-    strcpy (obs[oidx].sensor[sidx].id, "hdh2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) h;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_HDC2x");
-
-  }
-
-  if (LPS_1_exists) {
-// Output("DB:OBS_LPS1");
-    float t = lps1.readTemperature();
-    float p = lps1.readPressure();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    p = (isnan(p) || (p < QC_MIN_P)  || (p > QC_MAX_P))  ? QC_ERR_P  : p;
-
-    // 28 LPS1 Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "lpt1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) t;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 29 LPS1 Pressure
-    strcpy (obs[oidx].sensor[sidx].id, "lpp1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) p;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_LPS1x");
-  }
-
-  if (LPS_2_exists) {
-// Output("DB:OBS_LPS2");
-    float t = lps2.readTemperature();
-    float p = lps2.readPressure();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    p = (isnan(p) || (p < QC_MIN_P)  || (p > QC_MAX_P))  ? QC_ERR_P  : p;
-
-    // 30 LPS1 Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "lpt2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) t;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 31 LPS1 Pressure
-    strcpy (obs[oidx].sensor[sidx].id, "lpp2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) p;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_LPS2x");
-  }
-
-  if (HIH8_exists) {
-// Output("DB:OBS_HIH");
-    float t = 0.0;
-    float h = 0.0;
-
-    bool status = hih8_getTempHumid(&t, &h);
-    if (!status) {
-      t = -999.99;
-      h = 0.0;
-    }
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-
-    // 32 HIH8 Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "ht2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = t;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 33 HIH8 Humidity
-    strcpy (obs[oidx].sensor[sidx].id, "hh2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = h;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_HIHx");
-  }
-
-  if (SI1145_exists) {
-// Output("DB:OBS_SII");
-    float si_vis = uv.readVisible();
-    float si_ir = uv.readIR();
-    float si_uv = uv.readUV()/100.0;
-
-    // Additional code to force sensor online if we are getting 0.0s back.
-    if ( ((si_vis+si_ir+si_uv) == 0.0) && ((si_last_vis+si_last_ir+si_last_uv) != 0.0) ) {
-      // Let Reset The SI1145 and try again
-      Output ("SI RESET");
-      if (uv.begin()) {
-        SI1145_exists = true;
-        Output ("SI ONLINE");
-        SystemStatusBits &= ~SSB_SI1145; // Turn Off Bit
-
-        si_vis = uv.readVisible();
-        si_ir = uv.readIR();
-        si_uv = uv.readUV()/100.0;
-      }
-      else {
-        SI1145_exists = false;
-        Output ("SI OFFLINE");
-        SystemStatusBits |= SSB_SI1145;  // Turn On Bit    
-      }
-    }
-
-    // Save current readings for next loop around compare
-    si_last_vis = si_vis;
-    si_last_ir = si_ir;
-    si_last_uv = si_uv;
-
-    // QC Checks
-    si_vis = (isnan(si_vis) || (si_vis < QC_MIN_VI)  || (si_vis > QC_MAX_VI)) ? QC_ERR_VI  : si_vis;
-    si_ir  = (isnan(si_ir)  || (si_ir  < QC_MIN_IR)  || (si_ir  > QC_MAX_IR)) ? QC_ERR_IR  : si_ir;
-    si_uv  = (isnan(si_uv)  || (si_uv  < QC_MIN_UV)  || (si_uv  > QC_MAX_UV)) ? QC_ERR_UV  : si_uv;
-
-    // 34 SI Visible
-    strcpy (obs[oidx].sensor[sidx].id, "sv1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = si_vis;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 35 SI IR
-    strcpy (obs[oidx].sensor[sidx].id, "si1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = si_ir;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 36 SI UV
-    strcpy (obs[oidx].sensor[sidx].id, "su1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = si_uv;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_SIIx");
-  }
-
-  if (MCP_1_exists) {
-// Output("DB:OBS_MCP1");
-    float t = 0.0;
-
-    // 37 MCP1 Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "mt1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    t = mcp1.readTempC();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    obs[oidx].sensor[sidx].f_obs = t;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    mcp1_temp = t; // save for derived observations
-// Output("DB:OBS_MCP1x");
-  }
-
-  if (MCP_2_exists) {
-// Output("DB:OBS_MCP2");
-    float t = 0.0;
-
-    // 38 MCP2 Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "mt2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    t = mcp2.readTempC();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    obs[oidx].sensor[sidx].f_obs = t;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_MCP2x");
-  }
-
-  if (MCP_3_exists) {
-// Output("DB:OBS_MCP3");
-    float t = 0.0;
-
-    // 39 MCP3 Globe Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "gt1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    t = mcp3.readTempC();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    obs[oidx].sensor[sidx].f_obs = t;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    mcp3_temp = t; // globe temperature
-// Output("DB:OBS_MCP3x");
-  }
-
-  if (MCP_4_exists) {
-// Output("DB:OBS_MCP4");
-    float t = 0.0;
-
-    // 40 MCP4 Globe Temperature
-    strcpy (obs[oidx].sensor[sidx].id, "gt2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    t = mcp4.readTempC();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    obs[oidx].sensor[sidx].f_obs = t;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_MCP4x");
-  }
-
-  if (VEML7700_exists) {
-// Output("DB:OBS_VEML");
-    float lux = veml.readLux(VEML_LUX_AUTO);
-    lux = (isnan(lux) || (lux < QC_MIN_VLX)  || (lux > QC_MAX_VLX))  ? QC_ERR_VLX  : lux;
-
-    // 41 VEML7700 Auto Lux Value
-    strcpy (obs[oidx].sensor[sidx].id, "vlx");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = lux;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_VEMLx");
-  }
-
-  if (BLX_exists) {
-// Output("DB:OBS_BLX");
-    float lux=blx_takereading();
-    lux = (isnan(lux) || (lux < QC_MIN_BLX)  || (lux > QC_MAX_BLX))  ? QC_ERR_BLX  : lux;
-
-    // 42 DFR BLUX30 Auto Lux Value
-    strcpy (obs[oidx].sensor[sidx].id, "blx");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = lux;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_BLXx");
-  }
-
-  if (A4_State == A4_STATE_DISTANCE) {
-// Output("DB:OBS_A4D");
-    // 43 Distance Guage
-    strcpy (obs[oidx].sensor[sidx].id, "sg"); // sg = snow or stream
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = DistanceGauge_Median();
-    obs[oidx].sensor[sidx++].inuse = true;
-  }
-  if (A4_State == A4_STATE_RAW) {
-// Output("DB:OBS_A4R");
-    // 44 A4 Raw
-    strcpy (obs[oidx].sensor[sidx].id, "a4r");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = Pin_ReadAvg(A4);
-    obs[oidx].sensor[sidx++].inuse = true;
-  }
-  else if (A4_State == A4_STATE_RAIN) {
-// Output("DB:OBS_A4R");
-    // 45 Rain Guage 2
-    strcpy (obs[oidx].sensor[sidx].id, "rg2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = rain2;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 46 Rain Gauge 2 Total - Not Implemented
-    strcpy (obs[oidx].sensor[sidx].id, "rgt2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = eeprom.rgt2;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 47 Rain Gauge 2 Prior Day - Not Implemented
-    strcpy (obs[oidx].sensor[sidx].id, "rgp2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = eeprom.rgp2;
-    obs[oidx].sensor[sidx++].inuse = true;
-  }
-
-  if (A5_State == A5_STATE_RAW) {
-// Output("DB:OBS_A5R");
-    // 44 A4 Raw
-    strcpy (obs[oidx].sensor[sidx].id, "a5r");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = Pin_ReadAvg(A5);
-    obs[oidx].sensor[sidx++].inuse = true;
-  }
-
-  if (PM25AQI_exists) {
-// Output("DB:OBS_PM");
-    // 49 Standard Particle PM1.0 concentration unit µg 𝑚3
-    strcpy (obs[oidx].sensor[sidx].id, "pm1s10");
-    obs[oidx].sensor[sidx].type = I_OBS;
-    obs[oidx].sensor[sidx].i_obs = pm25aqi_obs.max_s10;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 50 Standard Particle PM2.5 concentration unit µg 𝑚3
-    strcpy (obs[oidx].sensor[sidx].id, "pm1s25");
-    obs[oidx].sensor[sidx].type = I_OBS;
-    obs[oidx].sensor[sidx].i_obs = pm25aqi_obs.max_s25;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 51 Standard Particle PM10.0 concentration unit µg 𝑚3
-    strcpy (obs[oidx].sensor[sidx].id, "pm1s100");
-    obs[oidx].sensor[sidx].type = I_OBS;
-    obs[oidx].sensor[sidx].i_obs = pm25aqi_obs.max_s100;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 52 Atmospheric Environmental PM1.0 concentration unit µg 𝑚3
-    strcpy (obs[oidx].sensor[sidx].id, "pm1e10");
-    obs[oidx].sensor[sidx].type = I_OBS;
-    obs[oidx].sensor[sidx].i_obs = pm25aqi_obs.max_e10;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 53 Atmospheric Environmental PM2.5 concentration unit µg 𝑚3
-    strcpy (obs[oidx].sensor[sidx].id, "pm1e25");
-    obs[oidx].sensor[sidx].type = I_OBS;
-    obs[oidx].sensor[sidx].i_obs = pm25aqi_obs.max_e25;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // 54  Atmospheric Environmental PM10.0 concentration unit µg 𝑚3
-    strcpy (obs[oidx].sensor[sidx].id, "pm1e100");
-    obs[oidx].sensor[sidx].type = I_OBS;
-    obs[oidx].sensor[sidx].i_obs = pm25aqi_obs.max_e100;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    // Clear readings
-    pm25aqi_clear();
-// Output("DB:OBS_PMx");
-  }
-
-  // 55 Heat Index Temperature
-  if (HI_exists) {
-// Output("DB:OBS_HI");
-    heat_index = hi_calculate(sht1_temp, sht1_humid);
-    strcpy (obs[oidx].sensor[sidx].id, "hi");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) heat_index;
-    obs[oidx].sensor[sidx++].inuse = true;    
-  } 
-
-  // 56 Wet Bulb Temperature
-  if (WBT_exists) {
-// Output("DB:OBS_WBT");
-    wetbulb_temp = wbt_calculate(sht1_temp, sht1_humid);
-    strcpy (obs[oidx].sensor[sidx].id, "wbt");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) wetbulb_temp;
-    obs[oidx].sensor[sidx++].inuse = true;  
-// Output("DB:OBS_WBTx");  
-  }
-
-  // 57 Wet Bulb Globe Temperature
-  if (WBGT_exists) {
-// Output("DB:OBS_WBGT");
-    float wbgt = 0.0;
-    if (MCP_3_exists) {
-      wbgt = wbgt_using_wbt(sht1_temp, mcp3_temp, wetbulb_temp); // TempAir, TempGlobe, TempWetBulb
-    }
-    else {
-      wbgt = wbgt_using_hi(heat_index);
-    }
-    strcpy (obs[oidx].sensor[sidx].id, "wbgt");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) wbgt;
-    obs[oidx].sensor[sidx++].inuse = true;    
-// Output("DB:OBS_WBGTx");
-  }
-
-  // 58,59 Tinovi Leaf Wetness
-  if (TLW_exists) {
-// Output("DB:OBS_TLW");
-    tlw.newReading();
-    delay(100);
-    float w = tlw.getWet();
-    float t = tlw.getTemp();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-
-    strcpy (obs[oidx].sensor[sidx].id, "tlww");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) w;
-    obs[oidx].sensor[sidx++].inuse = true; 
-
-    strcpy (obs[oidx].sensor[sidx].id, "tlwt");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) t;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_TLWx");
-  }
-
-  // 60-63 Tinovi Soil Moisture
-  if (TSM_exists) {
-// Output("DB:OBS_TSM");
-    tsm.newReading();
-    delay(100);
-    float e25 = tsm.getE25();
-    float ec = tsm.getEC();
-    float vwc = tsm.getVWC();
-    float t = tsm.getTemp();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-
-    strcpy (obs[oidx].sensor[sidx].id, "tsme25");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) e25;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    strcpy (obs[oidx].sensor[sidx].id, "tsmec");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) ec;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    strcpy (obs[oidx].sensor[sidx].id, "tsmvwc");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) vwc;
-    obs[oidx].sensor[sidx++].inuse = true; 
-
-    strcpy (obs[oidx].sensor[sidx].id, "tsmt");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) t;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_TSMx");
-  }
-
-   // 64-69 Tinovi Multi Level Soil Moisture
-  if (TMSM_exists) {
-// Output("DB:OBS_TMSM");
-    soil_ret_t multi;
-    float t;
-
-    tmsm.newReading();
-    delay(100);
-    tmsm.getData(&multi);
-
-    strcpy (obs[oidx].sensor[sidx].id, "tmsms1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) multi.vwc[0];
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    strcpy (obs[oidx].sensor[sidx].id, "tmsms2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) multi.vwc[1];
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    strcpy (obs[oidx].sensor[sidx].id, "tmsms3");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) multi.vwc[2];
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    strcpy (obs[oidx].sensor[sidx].id, "tmsms4");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) multi.vwc[3];
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    t = multi.temp[0];
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    strcpy (obs[oidx].sensor[sidx].id, "tmsmt1");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) t;
-    obs[oidx].sensor[sidx++].inuse = true;
-
-    t = multi.temp[1];
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    strcpy (obs[oidx].sensor[sidx].id, "tmsmt2");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) t;
-    obs[oidx].sensor[sidx++].inuse = true;
-// Output("DB:OBS_TMSMx");
-  }
+  OBS_Sensors_Read(obs_sensors, OBS_SENSOR_CNT, oidx);
+  OBS_QC(oidx, NULL);
 
-#if PLATFORM_ID == PLATFORM_MSOM
-  // Particle Muon on board temperature sensor 
-  if (PMTS_exists) {
-    float t = ptms_readtempc();
-    // t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t; // This is not and environmental sensor
-    strcpy (obs[oidx].sensor[sidx].id, "pmts");
-    obs[oidx].sensor[sidx].type = F_OBS;
-    obs[oidx].sensor[sidx].f_obs = (float) t;
-    obs[oidx].sensor[sidx++].inuse = true;
-  }
-#endif
+  // Derived values are made from the checked readings, then checked themselves so qc_hi= etc. apply
+  uint32_t checked[OBS_PRESENT_WORDS];
+  memcpy (checked, obs[oidx].present, sizeof(checked));
+  OBS_Sensors_Read(obs_derived, OBS_DERIVED_CNT, oidx);
+  OBS_QC(oidx, checked);
 
   // Set this after we read all sensors. So we capture if their state changes 
   obs[oidx].hth = SystemStatusBits;
 
   // Save Observation to SD Card
   OBS_Log(oidx);
-
-  lastOBS = System.millis();
 // Output("DB:OBS_Exit");
 }
 
 /*
  * ======================================================================================================================
- * Particle_Publish() - Publish to Particle what is in msgbuf
+ * Particle_PublishData() - Publish data to Particle
  * ======================================================================================================================
  */
-bool Particle_Publish(char *EventName) {
+bool Particle_PublishData(const char *EventName, const char *data) {
   // Calling Particle.publish() when the cloud connection has been turned off will not publish an event. 
   // This is indicated by the return success code of false. If the cloud connection is turned on and 
   // trying to connect to the cloud unsuccessfully, Particle.publish() may block for up to 20 seconds 
   // (normal conditions) to 10 minutes (unusual conditions). Checking Particle.connected() 
   // before calling Particle.publish() can help prevent this.
   if (Particle.connected()) {
+    // Currently, a device can publish at rate of about 1 event/sec, with bursts of up to 4 allowed in 1 second. 
+    // Back to back burst of 4 messages will take 4 seconds to recover. PR.h paces us to that.
+    if (!PR_Wait()) {
+      return(false);
+    }
     uint64_t start_ts = System.millis();
-    if (Particle.publish(EventName, msgbuf, WITH_ACK)) {  // PRIVATE flag is always used even when not specified
-
-      // A safty check, If we got hung up for N seconds or more sending, 
-      // let's invalidate our wind data and force a reinit in the main loop()
-      if ((System.millis() - start_ts) >= 2000) {
-        ws_refresh = true;
-      }
-      // Currently, a device can publish at rate of about 1 event/sec, with bursts of up to 4 allowed in 1 second. 
-      // Back to back burst of 4 messages will take 4 seconds to recover.
-      // Our BackGroundWork() provides a delay between observations of 1 second 
-      BackGroundWork();
+    bool ok = Particle.publish(EventName, data, WITH_ACK);  // PRIVATE flag is always used even when not specified
+    PR_Result(ok, System.millis() - start_ts);
+    SCH_Yield(); // Catch up on anything that came due while we waited for the ack
+    if (ok) {
       return(true);
     }
   }
@@ -1173,16 +1571,27 @@ bool Particle_Publish(char *EventName) {
   return(false);
 }
 
+/*
+ * ======================================================================================================================
+ * Particle_Publish() - Publish to Particle what is in msgbuf
+ * ======================================================================================================================
+ */
+bool Particle_Publish(char *EventName) {
+  return (Particle_PublishData(EventName, msgbuf));
+}
+
 /*
  * ======================================================================================================================
  * OBS_FS_Publish() - obs[i].inuse for this observation must be true prior to calling
  * ======================================================================================================================
  */
 bool OBS_FS_Publish(int i) {
-  OBS_FS_Build_JSON(i);  
-  if (Particle_Publish((char *) "FS")) {
-    Serial_write (msgbuf);
-    sprintf (Buffer32Bytes, "FS[%d]->PUB OK[%d]", i, strlen(msgbuf)+1);
+  if (!OBS_Encode(i)) {
+    return(false);
+  }
+  if (Particle_PublishData("FS", obs_enc.buf)) {
+    Serial_write (obs_enc.buf);
+    sprintf (Buffer32Bytes, "FS[%d]->PUB OK[%u]", i, (unsigned) (obs_enc.len+1));
     Output(Buffer32Bytes);
     return(true);
   }
@@ -1219,23 +1628,183 @@ bool OBS_Relay_Publish(int relay_type) {
   }
 }
 
+/*
+ * ======================================================================================================================
+ *  Batched observations - Event FSB
+ *  
+ *  Several minutes are sent in one event up to the event data limit. The header carries the time of the first
+ *  observation and its health. Each entry carries its time offset in seconds from "at", and "hth" only when it 
+ *  differs from the header. Entries are built from the OBS_Encode() bytes so nothing is serialized twice.
+ *  
+ *  {"at":"2025-07-21T12:01:00","hth":16,"obs":[{"to":0,"css":80.1234,"bcs":3,...},{"to":60,"css":80.1234,...}]}
+ *  
+ *  tools/fsb_expand turns a FSB event back in to the FS events of its observations, tools/test/test_fsb checks it.
+ * ======================================================================================================================
+ */
+#define OBS_BATCH_MAX_SIZE  (MAX_MSGBUF_SIZE-1)  // Device OS event data limit is 1024 bytes
+
+/*
+ * ======================================================================================================================
+ * OBS_Batch_Add() - Append observation i to obs_batch, return false if it will not fit
+ * ======================================================================================================================
+ */
+bool OBS_Batch_Add(int i, time32_t base, unsigned long hth, size_t *len) {
+  char to[24];
+  size_t n, body, health, rest, hth_end, need;
+
+  if (!OBS_Encode(i)) {
+    return (false);
+  }
+
+  hth_end = obs_enc.hth_pos + obs_enc.hth_len;
+  n = sprintf (to, "{\"to\":%ld", (long) (obs[i].ts - base));
+  body = obs_enc.hth_name - obs_enc.at_end;                                    // ,"css":n
+  health = (obs_enc.hth != hth) ? (hth_end - obs_enc.hth_name) : 0;           // ,"hth":n
+  rest = obs_enc.len - hth_end;                                                // ,sensors}
+  need = ((obs_batch[*len-1] == '[') ? 0 : 1) + n + body + health + rest;
+
+  if ((*len + need + 2) > OBS_BATCH_MAX_SIZE) {  // 2 for closing ]}
+    return (false);
+  }
+
+  if (obs_batch[*len-1] != '[') {
+    obs_batch[(*len)++] = ',';
+  }
+  memcpy (obs_batch + *len, to, n);                                   *len += n;
+  memcpy (obs_batch + *len, obs_enc.buf + obs_enc.at_end, body);      *len += body;
+  memcpy (obs_batch + *len, obs_enc.buf + obs_enc.hth_name, health);  *len += health;
+  memcpy (obs_batch + *len, obs_enc.buf + hth_end, rest);             *len += rest;
+  obs_batch[*len] = 0;
+  return (true);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Batch_PublishAll() - Send all queued observations as FSB events, oldest first
+ *                          Observations in a batch that fails to publish are saved to N2S as FS records
+ *                          Return false if anything was added to N2S
+ * ======================================================================================================================
+ */
+bool OBS_Batch_PublishAll() {
+  bool OK2Send = true;
+  char ts[32];
+
+  while (obs_count > 0) {
+    int i = obs_head;
+    int n = 0;
+    size_t len;
+
+    FMT_TimeStamp(obs[i].ts, ts);
+    len = sprintf (obs_batch, "{\"at\":\"%s\",\"hth\":%d,\"obs\":[", ts, (int) obs[i].hth);
+    while ((n < obs_count) && OBS_Batch_Add((obs_head + n) % obs_slots, obs[i].ts, obs[i].hth, &len)) {
+      n++;
+    }
+
+    if (n == 0) {
+      // Will not fit in a batch by itself, send it as a FS event
+      if (OBS_FS_Publish(i) == false) {
+        OBS_N2S_Add (i);
+        OK2Send = false;
+      }
+      OBS_Dequeue();
+      continue;
+    }
+    strcpy (obs_batch+len, "]}");
+
+    if (Particle_PublishData("FSB", obs_batch)) {
+      Serial_write (obs_batch);
+      sprintf (Buffer32Bytes, "FSB[%d]->PUB OK[%u]", n, (unsigned) (len+3));
+      Output(Buffer32Bytes);
+      while (n-- > 0) {
+        OBS_Dequeue();
+      }
+    }
+    else {
+      sprintf (Buffer32Bytes, "FSB[%d]->PUB ERR", n);
+      Output(Buffer32Bytes);
+      while (n-- > 0) {
+        OBS_N2S_Add (obs_head);
+        OBS_Dequeue();
+      }
+      // Don't try to send any N2S because we just added to the file
+      OK2Send = false;
+    }
+  }
+  return (OK2Send);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Bin_PublishAll() - Send all queued observations as FSX events, oldest first
+ *                        With obs_batch=1 as many records as fit are sent in each event
+ *                        Observations in a event that fails to publish are saved to N2S as FSX records
+ *                        Return false if anything was added to N2S
+ * ======================================================================================================================
+ */
+bool OBS_Bin_PublishAll() {
+  bool OK2Send = true;
+  uint8_t rec[OBS_BIN_REC_MAX_SIZE];
+
+  while (obs_count > 0) {
+    int n = 0;
+    size_t len = 0;
+    size_t b64len;
+
+    while ((n < obs_count) && ((n == 0) || cf_obs_batch)) {
+      size_t rlen = OBS_Bin_Encode((obs_head + n) % obs_slots, rec);
+      if ((rlen == 0) || ((len + rlen) > OBS_BIN_MAX_SIZE)) {
+        break;
+      }
+      memcpy (obs_bin + len, rec, rlen);
+      len += rlen;
+      n++;
+    }
+
+    if (n == 0) {
+      // Not in use, should never happen
+      OBS_Dequeue();
+      continue;
+    }
+    b64len = Base64_Encode(obs_bin, len, obs_batch);
+
+    if (Particle_PublishData("FSX", obs_batch)) {
+      Serial_write (obs_batch);
+      sprintf (Buffer32Bytes, "FSX[%d]->PUB OK[%u]", n, (unsigned) (b64len+1));
+      Output(Buffer32Bytes);
+      while (n-- > 0) {
+        OBS_Dequeue();
+      }
+    }
+    else {
+      sprintf (Buffer32Bytes, "FSX[%d]->PUB ERR", n);
+      Output(Buffer32Bytes);
+      while (n-- > 0) {
+        OBS_N2S_Add (obs_head);
+        OBS_Dequeue();
+      }
+      // Don't try to send any N2S because we just added to the file
+      OK2Send = false;
+    }
+  }
+  return (OK2Send);
+}
+
 /*
  * ======================================================================================================================
  * OBS_PublishAll() - Send to logging site
  * 
- * If we take to long sending observations code restarts the 60 samples for wind and direction.
- * So we might miss a one minute observation
+ * Function Particle_Publish() is paced by the PR.h rate limiter
  * 
- * Function Particle_Publish() calls BackGroundWork() after each transmission
- * 
- * If sending an observation takes 2 or more seconds ws_refresh is set and 
- *   the main program loop calls Wind_Distance_Air_Initialize() 
+ * Wind and distance keep being sampled by the sampler thread (WRD.h) however long this takes
  * ======================================================================================================================
  */
 void OBS_PublishAll() {
   bool OK2Send=true;
   int relay_type;
 
+  // Anything we fail to send goes to N2S, sync it once when we are done
+  N2S_Session_Begin();
+
   // Update Cell Signal Strength On Last (Most Current) OBS Since Cell is turned to get reading
   int last = OBS_Last();
   if (last >= 0) {
@@ -1245,18 +1814,24 @@ void OBS_PublishAll() {
     CellularSignal sig = Cellular.RSSI();
 #endif
     obs[last].css = sig.getStrength();
+    OBS_Encode_Invalidate(last);
   }
 
-  // Go through the saved 1 minute observers and send them
-  for (int i=0; i<MAX_ONE_MINUTE_OBS; i++) {
-    if (obs[i].inuse) {
-      if (OBS_FS_Publish(i) == false) {
-        OBS_N2S_Add (i);
-        // Don't try to send any N2S because we just added to the file
-        OK2Send = false;
-      }
-      OBS_Clear(i);
+  // Go through the saved 1 minute observers, oldest first, and send them
+  if (cf_obs_format == OBS_FORMAT_BINARY) {
+    OK2Send = OBS_Bin_PublishAll();
+  }
+  else if (cf_obs_batch) {
+    OK2Send = OBS_Batch_PublishAll();
+  }
+  while (obs_count > 0) {
+    int i = obs_head;
+    if (OBS_FS_Publish(i) == false) {
+      OBS_N2S_Add (i);
+      // Don't try to send any N2S because we just added to the file
+      OK2Send = false;
     }
+    OBS_Dequeue();
   }
 
   // Publish LoRa Relay Observations   
@@ -1282,6 +1857,8 @@ void OBS_PublishAll() {
     }
   }
 
+  N2S_Session_End();
+
   // Check if we have any N2S only if we have not added to the file while trying to send OBS
   if (OK2Send) {
     SD_N2S_Publish(); 
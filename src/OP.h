@@ -49,6 +49,7 @@ Adafruit_SSD1306 display64(SCREEN_WIDTH, 64, &Wire, OLED_RESET);
  * ======================================================================================================================
  */
 void OLED_sleepDisplay() {
+  WIRE_LOCK();
   if (DisplayEnabled) {
     if (OLED32) {
       display32.ssd1306_command(SSD1306_DISPLAYOFF);
@@ -65,6 +66,7 @@ void OLED_sleepDisplay() {
  * ======================================================================================================================
  */
 void OLED_wakeDisplay() {
+  WIRE_LOCK();
   if (DisplayEnabled) {
     if (OLED32) {
       display32.ssd1306_command(SSD1306_DISPLAYON);
@@ -81,6 +83,7 @@ void OLED_wakeDisplay() {
  * ======================================================================================================================
  */
 void OLED_spin() {
+  WIRE_LOCK();
   static int spin=0;
     
   if (DisplayEnabled) {
@@ -123,6 +126,7 @@ void OLED_spin() {
  * ======================================================================================================================
  */
 void OLED_update() {  
+  WIRE_LOCK();
   if (DisplayEnabled) {
     if (OLED32) {
       display32.clearDisplay();
@@ -166,6 +170,7 @@ void OLED_update() {
  * ======================================================================================================================
  */
 void OLED_write(const char *str) {
+  WIRE_LOCK();
   int c, len, bottom_line = 3;
   
   if (DisplayEnabled) {
@@ -208,6 +213,7 @@ void OLED_write(const char *str) {
  * ======================================================================================================================
  */
 void OLED_write_noscroll(const char *str) {
+  WIRE_LOCK();
   int c, len, bottom_line = 3;
 
   if (OLED64) {
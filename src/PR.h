@@ -0,0 +1,122 @@
+/*
+ * ======================================================================================================================
+ *  PR.h - Publish Rate limiter
+ * ======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ *  A device can publish about 1 event/sec with bursts of up to 4. Back to back bursts of 4 take 4 seconds
+ *  to recover. Every publish (OBS, relay, INFO and N2S) takes a token from this bucket.
+ *
+ *  The bucket holds PR_BURST tokens and gains one every PR_REFILL_MS, so a queue of observations goes out
+ *  as a burst and then at the cloud rate instead of waiting a second after each one.
+ *  A failed publish empties the bucket and holds all publishing for a backoff that doubles with each
+ *  failure in a row (PR_BACKOFF_MIN to PR_BACKOFF_MAX). A hold longer than PR_Wait() can wait fails the
+ *  publish without waiting, the first one after the hold is over always gets its attempt. A slow ack (PR_SLOW_ACK) empties the bucket so
+ *  we do not burst on to a congested link. Ack latency and counts are reported by INFO.
+ * ======================================================================================================================
+ */
+#define PR_BURST            4           // Tokens in a full bucket
+#define PR_REFILL_MS        1000        // ms to gain a token
+#define PR_BACKOFF_MIN      4000        // ms hold after a failure, the burst recovery period
+#define PR_BACKOFF_MAX      64000       // ms longest hold
+#define PR_SLOW_ACK         2000        // ms, an ack slower than this empties the bucket
+#define PR_WAIT_MAX         8000        // ms PR_Wait() will wait before giving up
+
+// Prototyping functions to aviod compile function unknown issue.
+void SCH_Run(uint32_t ms);
+void SCH_Yield();
+
+uint32_t pr_tokens = PR_BURST * PR_REFILL_MS;   // Tokens * PR_REFILL_MS
+uint64_t pr_refill_ms = 0;                      // System.millis() tokens were last added
+uint64_t pr_hold_ms = 0;                        // No publishing before this System.millis()
+uint32_t pr_backoff = 0;                        // ms of the last backoff, 0 after a success
+bool pr_probe = false;                          // One publish is let through when the hold is over
+uint32_t pr_ok = 0;                             // Publishes acked
+uint32_t pr_err = 0;                            // Publishes failed
+uint32_t pr_ack_avg = 0;                        // ms average ack latency
+uint32_t pr_ack_max = 0;                        // ms longest ack latency
+
+/*
+ *=======================================================================================================================
+ * PR_Refill() - Add the tokens earned since the last call
+ *=======================================================================================================================
+ */
+void PR_Refill() {
+  uint64_t now = System.millis();
+  uint64_t tokens = pr_tokens + (now - pr_refill_ms);
+
+  pr_refill_ms = now;
+  pr_tokens = (tokens > (PR_BURST * PR_REFILL_MS)) ? (PR_BURST * PR_REFILL_MS) : tokens;
+}
+
+/*
+ *=======================================================================================================================
+ * PR_Take() - Take a token if there is one and we are not backing off. Does not wait.
+ *=======================================================================================================================
+ */
+bool PR_Take() {
+  PR_Refill();
+  if (System.millis() < pr_hold_ms) {
+    return (false);
+  }
+  if (pr_probe) {
+    pr_probe = false; // Hold is over, try the link even if the bucket has not refilled
+    pr_tokens = (pr_tokens < PR_REFILL_MS) ? 0 : pr_tokens - PR_REFILL_MS;
+    return (true);
+  }
+  if (pr_tokens < PR_REFILL_MS) {
+    return (false);
+  }
+  pr_tokens -= PR_REFILL_MS;
+  return (true);
+}
+
+/*
+ *=======================================================================================================================
+ * PR_Wait() - Take a token, running the scheduler while we wait. False if not available in PR_WAIT_MAX.
+ *=======================================================================================================================
+ */
+bool PR_Wait() {
+  uint64_t give_up = System.millis() + PR_WAIT_MAX;
+
+  while (!PR_Take()) {
+    if ((System.millis() >= give_up) || (pr_hold_ms > give_up)) {
+      Output ("PR:BACKOFF");
+      return (false);
+    }
+    // Run background tasks until the next token is earned or the backoff is over
+    SCH_Run((System.millis() < pr_hold_ms) ? (pr_hold_ms - System.millis()) : (PR_REFILL_MS - pr_tokens));
+  }
+  return (true);
+}
+
+/*
+ *=======================================================================================================================
+ * PR_Result() - Record how a publish went, ms is how long it took to get the ack
+ *=======================================================================================================================
+ */
+void PR_Result(bool ok, uint32_t ms) {
+  if (ok) {
+    pr_ok++;
+    pr_backoff = 0;
+    pr_ack_avg = (pr_ok == 1) ? ms : ((pr_ack_avg * 7) + ms) / 8;
+    if (ms > pr_ack_max) {
+      pr_ack_max = ms;
+    }
+    if (ms >= PR_SLOW_ACK) {
+      pr_tokens = 0;
+    }
+  }
+  else {
+    pr_err++;
+    pr_backoff = (pr_backoff == 0) ? PR_BACKOFF_MIN : pr_backoff * 2;
+    if (pr_backoff > PR_BACKOFF_MAX) {
+      pr_backoff = PR_BACKOFF_MAX;
+    }
+    pr_tokens = 0;
+    pr_hold_ms = System.millis() + pr_backoff;
+    pr_probe = true;
+  }
+}
@@ -158,6 +158,8 @@ void Output_CellBatteryInfo() {
  * ======================================================================================================================
  */
 void DeviceReset() {
+  N2S_Close(); // Make sure N2S lines are on the SD card
+
   digitalWrite(REBOOT_PIN, HIGH);
   delay(5000);
   // Should not get here if relay / watchdog is connected.
@@ -175,6 +177,8 @@ void DeviceReset() {
  * ======================================================================================================================
  */
 int Function_DoAction(String s) {
+  SD_LOCK(); // Actions add and remove files on the SD card
+
   if (strcmp (s,"REBOOT") == 0) {  // Reboot - We loose untransmitted observations. But they are save to SD.
     Output("DoAction:REBOOT");     // Do a SEND before a REBOOT to address the abive issue.
     EEPROM_SaveUnreportedRain();
@@ -1,6 +1,8 @@
 /*
  * ======================================================================================================================
  *  Quality Control - Min and Max Sensor Values on Surface of the Earth
+ *  
+ *  These are the defaults loaded in to obs_qc[], a station can override them per tag in CONFIG.TXT (see CF.h)
  * ======================================================================================================================
  */
 
@@ -60,3 +62,5 @@
 #define QC_MIN_RG      0         // mm
 #define QC_MAX_RG      30.0      // mm based on the world-record 1-minute rainfall in Maryland in 1956 (31.24 mm or 1.23")
 #define QC_ERR_RG      -999.9    // Rain Gauge Error
+#define QC_MAX_RG_MS(ms) ((((ms) / 60000.0) + 1.0) * QC_MAX_RG) // mm max over ms, plus a minute of slack as the
+                                                                 // gap between observations is not always a minute
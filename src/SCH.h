@@ -0,0 +1,159 @@
+/*
+ * ======================================================================================================================
+ *  SCH.h - Scheduler for background work
+ * ======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ *  Periodic tasks with deadlines. SCH_Run(ms) runs each task as it comes due for ms milliseconds and only
+ *  idles (delay) until the next deadline when nothing is due. BackGroundWork() is SCH_Run(1000).
+ *  Long operations call SCH_Yield() between steps to run anything that is due without waiting.
+ *
+ *  A task's next deadline is its last deadline plus its period, so running late does not drift the
+ *  cadence. If it is a whole period or more late, the missed periods are counted as skips and the
+ *  cadence restarts from now. How late each task ran is recorded and reported by INFO.
+ *
+ *  The 1s wind, distance and air quality samples are not a task here, they have their own thread (WRD.h).
+ * ======================================================================================================================
+ */
+typedef struct {
+  const char      *name;
+  void            (*run)();
+  uint32_t        period;               // ms between runs
+  uint64_t        due;                  // System.millis() deadline of the next run, 0 = not started
+  uint32_t        runs;
+  uint32_t        late_avg;             // ms average lateness
+  uint32_t        late_max;             // ms worst lateness
+  uint32_t        skips;                // Periods missed
+} SCH_TASK_STR;
+
+int sch_hb = 0;                         // Heartbeat phase, pin is high for the first of 4
+
+/*
+ *=======================================================================================================================
+ * SCH_LoRa() - Check for LoRa Messages
+ *=======================================================================================================================
+ */
+void SCH_LoRa() {
+  if (LORA_exists) {
+    lora_msg_check();
+  }
+}
+
+/*
+ *=======================================================================================================================
+ * SCH_HeartBeat() - Refresh the watchdog, heartbeat pin high 250ms of each second
+ *=======================================================================================================================
+ */
+void SCH_HeartBeat() {
+#if (PLATFORM_ID == PLATFORM_MSOM)
+  Watchdog.refresh();
+#else
+  sch_hb = (sch_hb + 1) % 4;
+  digitalWrite(HEARTBEAT_PIN, (sch_hb == 0) ? HIGH : LOW);
+#endif
+}
+
+/*
+ *=======================================================================================================================
+ * SCH_Led() - Turn off the LED the rain gauge interrupt handler turned on
+ *=======================================================================================================================
+ */
+void SCH_Led() {
+  if (TurnLedOff) {
+    digitalWrite(LED_PIN, LOW);
+    TurnLedOff = false;
+  }
+}
+
+SCH_TASK_STR sch_tasks[] = {
+  {"lora", SCH_LoRa,      250,  0, 0, 0, 0, 0},
+  {"hb",   SCH_HeartBeat, 250,  0, 0, 0, 0, 0},
+  {"led",  SCH_Led,       1000, 0, 0, 0, 0, 0},
+};
+#define SCH_TASK_COUNT (sizeof(sch_tasks) / sizeof(SCH_TASK_STR))
+
+/*
+ *=======================================================================================================================
+ * SCH_RunTask() - Run task t, record how late it is and set its next deadline
+ *=======================================================================================================================
+ */
+void SCH_RunTask(SCH_TASK_STR *t, uint64_t now) {
+  uint32_t late = now - t->due;
+
+  t->late_avg = (t->runs == 0) ? late : ((t->late_avg * 7) + late) / 8;
+  if (late > t->late_max) {
+    t->late_max = late;
+  }
+  t->runs++;
+
+  t->run();
+
+  if (late >= t->period) {
+    t->skips += late / t->period;
+    t->due = now + t->period;
+  }
+  else {
+    t->due += t->period;
+  }
+}
+
+/*
+ *=======================================================================================================================
+ * SCH_Run() - Run tasks as they come due for ms milliseconds, idle only when nothing is due
+ *=======================================================================================================================
+ */
+void SCH_Run(uint32_t ms) {
+  uint64_t now = System.millis();
+  uint64_t end = now + ms;
+  uint64_t next;
+
+  while (true) {
+    next = end;
+    for (size_t i=0; i<SCH_TASK_COUNT; i++) {
+      SCH_TASK_STR *t = &sch_tasks[i];
+      if (t->due == 0) {
+        t->due = now;
+      }
+      if (now >= t->due) {
+        SCH_RunTask(t, now);
+        now = System.millis();
+      }
+      if (t->due < next) {
+        next = t->due;
+      }
+    }
+    if (now >= end) {
+      break;
+    }
+    if (next > now) {
+      delay (next - now);
+    }
+    now = System.millis();
+  }
+}
+
+/*
+ *=======================================================================================================================
+ * SCH_Yield() - Run anything that is due now, do not wait
+ *=======================================================================================================================
+ */
+void SCH_Yield() {
+  SCH_Run(0);
+}
+
+/*
+ *=======================================================================================================================
+ * SCH_Stats() - "name:avg/max/skips,..." lateness in ms for INFO
+ *=======================================================================================================================
+ */
+void SCH_Stats(char *buf) {
+  char *p = buf;
+
+  for (size_t i=0; i<SCH_TASK_COUNT; i++) {
+    SCH_TASK_STR *t = &sch_tasks[i];
+    p += sprintf (p, "%s%s:%lu/%lu/%lu", (i) ? "," : "", t->name,
+      (unsigned long) t->late_avg, (unsigned long) t->late_max, (unsigned long) t->skips);
+  }
+}
@@ -11,16 +11,19 @@
   calls to SdFat functions with these SPI commands yourself.
 */
 
+/*
+  SD card access is shared between loop() and the N2S drain thread (N2S.h). Take sd_mutex with
+  SD_LOCK() at the top of any function that touches the card once the drain thread is running.
+  It is recursive so functions holding it can call each other.
+*/
+RecursiveMutex sd_mutex;
+#define SD_LOCK()         std::lock_guard<RecursiveMutex> sd_lock(sd_mutex)
+
 #define CF_NAME           "CONFIG.TXT"
 #define KEY_MAX_LENGTH    30                // Config File Key Length
 #define VALUE_MAX_LENGTH  30                // Config File Value Length
 #define LINE_MAX_LENGTH   VALUE_MAX_LENGTH+KEY_MAX_LENGTH+3   // =, CR, LF 
 
-// Prototyping functions to aviod compile function unknown issue.
-bool Particle_Publish(char *EventName); 
-bool OBS_Full();
-void OBS_Do();
-
 /* 
  *=======================================================================================================================
  * SD_initialize()
@@ -72,6 +75,7 @@ void SD_initialize() {
 void SD_LogObservation(char *observations) {
   char SD_logfile[24];
   File fp;
+  SD_LOCK();
 
   if (!SD_exists) {
     return;
@@ -98,216 +102,6 @@ void SD_LogObservation(char *observations) {
   }
 }
 
-/* 
- *=======================================================================================================================
- * SD_N2S_Delete()
- *=======================================================================================================================
- */
-bool SD_N2S_Delete() {
-  bool result;
-
-  if (SD_exists && SD.exists(SD_n2s_file)) {
-    if (SD.remove (SD_n2s_file)) {
-      SystemStatusBits &= ~SSB_N2S; // Turn Off Bit
-      Output ("N2S->DEL:OK");
-      result = true;
-    }
-    else {
-      Output ("N2S->DEL:ERR");
-      SystemStatusBits |= SSB_SD; // Turn On Bit
-      result = false;
-    }
-  }
-  else {
-    SystemStatusBits &= ~SSB_N2S; // Turn Off Bit
-    Output ("N2S->DEL:NF");
-    result = true;
-  }
-  eeprom.n2sfp = 0;
-  EEPROM_Update();
-  return (result);
-}
-
-/* 
- *=======================================================================================================================
- * SD_NeedToSend_Add()
- *=======================================================================================================================
- */
-void SD_NeedToSend_Add(char *observation) {
-  File fp;
-
-  if (!SD_exists) {
-    return;
-  }
-  
-  fp = SD.open(SD_n2s_file, FILE_WRITE); // Open the file for reading and writing, starting at the end of the file.
-                                         // It will be created if it doesn't already exist.
-  if (fp) {  
-    if (fp.size() > SD_n2s_max_filesz) {
-      fp.close();
-      Output ("N2S:Full");
-      if (SD_N2S_Delete()) {
-        // Only call ourself again if we truely deleted the file. Otherwise infinate loop.
-        SD_NeedToSend_Add(observation); // Now go and log the data
-      }
-    }
-    else {
-      fp.println(observation); //Print data, followed by a carriage return and newline, to the File
-      fp.close();
-      SystemStatusBits &= ~SSB_SD;  // Turn Off Bit
-      SystemStatusBits |= SSB_N2S; // Turn on Bit that says there are entries in the N2S File
-      Output ("N2S:OBS Added");
-    }
-  }
-  else {
-    SystemStatusBits |= SSB_SD;  // Turn On Bit - Note this will be reported on next observation
-    Output ("N2S:Open Error");
-    // At thins point we could set SD_exists to false and/or set a status bit to report it
-    // sd_initialize();  // Reports SD NOT Found. Library bug with SD
-  }
-}
-
-/* 
- *=======================================================================================================================
- * SD_N2S_Publish()
- *=======================================================================================================================
- */
-void SD_N2S_Publish() {
-  File fp;
-  char ch;
-  int i;
-  int sent=0;
-  char *EventType;
-
-  if (SD_exists && SD.exists(SD_n2s_file)) {
-    Output ("N2S:Publish");
-
-    fp = SD.open(SD_n2s_file, FILE_READ); // Open the file for reading, starting at the beginning of the file.
-
-    if (fp) {
-      // Delete Empty File or too small of file to be valid
-      if (fp.size()<=20) {
-        fp.close();
-        Output ("N2S:Empty");
-        SD_N2S_Delete();
-      }
-      else {
-        if (eeprom.n2sfp) {
-          if (fp.size()<=eeprom.n2sfp) {
-            // Something wrong. Can not have a file position that is larger than the file
-            eeprom.n2sfp = 0; 
-          }
-          else {
-            fp.seek(eeprom.n2sfp);  // Seek to where we left off last time. 
-          }
-        }
-
-        // Loop through each line / obs and transmit
-        i = 0;
-        while (fp.available() && (i < MAX_MSGBUF_SIZE )) {
-          ch = fp.read();
-
-          if (ch == 0x0A) {  // newline
-            if (Particle_Publish(EventType)) {
-              sprintf (Buffer32Bytes, "N2S[%d]%s->PUB:OK", sent++, EventType);
-              Output (Buffer32Bytes);
-              Serial_write (msgbuf);
-
-              // setup for next line in file
-              i = 0;
-
-              // file position is at the start of the next observation or at eof
-              eeprom.n2sfp = fp.position();        
-            }
-            else { // Delay then retry
-              sprintf (Buffer32Bytes, "N2S[%d]%s->PUB:RETRY", sent, EventType);
-              Output (Buffer32Bytes);
-              Serial_write (msgbuf);
-
-              // Do some Background work to create a 5 second delay
-              // 4 Seconds is the Particle Burst recovery period
-              for (int d=0; d<5; d++) {
-                BackGroundWork(); 
-              }
-
-              if (Particle_Publish(EventType)) {
-                sprintf (Buffer32Bytes, "N2S[%d]%s->PUB:OK", sent++, EventType);
-                Output (Buffer32Bytes);
-                // setup for next line in file
-                i = 0;
-
-                // file position is at the start of the next observation or at eof
-                eeprom.n2sfp = fp.position();
-              }
-              else {
-                sprintf (Buffer32Bytes, "N2S[%d]%s->PUB:ERR", sent, EventType);
-                Output (Buffer32Bytes);
-                // On transmit failure, stop processing file.
-                break;
-              }
-            } // RETRY
-            
-            // At this point file pointer's position is at the first character of the next line or at eof
-
-            // We could be in this loop for a while. We don't want to miss our observation window.
-            // So make the observation and stay in the loop if we have space in the OBS array.
-            // We need to avoid a full array that would cause all observations to be saved to N2S file 
-            // we currently have open, a bad thing.
-            if ( (System.millis() - lastOBS) > OBSERVATION_INTERVAL) {
-              Output ("N2S:OBS Needed");
-              if (OBS_Full()) {
-                // need to get out of this loop and let the main loop make the needed observation
-                Output ("N2S:OBS FULL");
-                break;
-              }
-              else {
-                I2C_Check_Sensors(); // Make sure Sensors are online
-                OBS_Do();                  
-              }
-            }
-          } // Newline
-          else if (ch == 0x0D) { // CR, LF follows and will trigger the line to be processed       
-            msgbuf[i] = 0; // null terminate then wait for newline to be read to process OBS
-
-            // After the JSON structure is a comma and Particle Event Type ("FS" or "RS")
-            msgbuf[i-3] = 0; // Set the comma to Null so we don't transmit to Particle what follows
-            EventType = &msgbuf[i-2];      
-          }
-          else {
-            msgbuf[i++] = ch;
-          }
-
-          // Check for buffer overrun
-          if (i >= MAX_MSGBUF_SIZE) {
-            sprintf (Buffer32Bytes, "N2S[%d]->BOR:ERR", sent);
-            Output (Buffer32Bytes);
-            fp.close();
-            SD_N2S_Delete(); // Bad data in the file so delete the file           
-            return;
-          }
-        } // end while 
-
-        if (fp.available() <= 20) {
-          // If at EOF or some invalid amount left then delete the file
-          fp.close();
-          SD_N2S_Delete();
-        }
-        else {
-          // At this point we sent 0 or more observations but there was a problem.
-          // eeprom.n2sfp was maintained in the above read loop. So we will close the
-          // file and next time this function is called we will seek to eeprom.n2sfp
-          // and start processing from there forward. 
-          fp.close();
-          EEPROM_Update(); // Update file postion in the eeprom.
-        }
-      }
-    }
-    else {
-        Output ("N2S->OPEN:ERR");
-    }
-  }
-}
-
 /* 
  * =======================================================================================================================
  * Support functions for Config file
@@ -519,4 +313,58 @@ void SD_ReadConfigFile() {
 
   cf_lora_freq   = SD_findInt(F("lora_freq"));
   sprintf(msgbuf, "CF:lora_freq=[%d]", cf_lora_freq); Output (msgbuf);
+
+  cf_obs_overflow = SD_findInt(F("obs_overflow"));
+  sprintf(msgbuf, "CF:obs_overflow=[%d]", cf_obs_overflow); Output (msgbuf);
+
+  cf_obs_batch = SD_findInt(F("obs_batch"));
+  sprintf(msgbuf, "CF:obs_batch=[%d]", cf_obs_batch); Output (msgbuf);
+
+  cf_obs_format = SD_findInt(F("obs_format"));
+  sprintf(msgbuf, "CF:obs_format=[%d]", cf_obs_format); Output (msgbuf);
+
+  cf_obs_interval = SD_findInt(F("obs_interval"));
+  if ((cf_obs_interval < 0) || (cf_obs_interval > 3600) || ((cf_obs_interval > 0) && ((3600 % cf_obs_interval) != 0))) {
+    cf_obs_interval = 0; // Not a boundary we can line up on, use the default
+  }
+  sprintf(msgbuf, "CF:obs_interval=[%d]", cf_obs_interval); Output (msgbuf);
+
+  cf_wind_hz = SD_findInt(F("wind_hz"));
+  if ((cf_wind_hz != 1) && (cf_wind_hz != 2) && (cf_wind_hz != WIND_HZ_MAX)) {
+    cf_wind_hz = 0; // Must divide the second evenly, use the default
+  }
+  sprintf(msgbuf, "CF:wind_hz=[%d]", cf_wind_hz); Output (msgbuf);
+
+  cf_wind_gust_secs = SD_findInt(F("wind_gust_secs"));
+  if ((cf_wind_gust_secs < 0) || ((cf_wind_gust_secs * WIND_HZ_MAX) > GUST_MAX)) {
+    cf_wind_gust_secs = 0; // Longer than the gust tracker holds at the highest rate, use the default
+  }
+  sprintf(msgbuf, "CF:wind_gust_secs=[%d]", cf_wind_gust_secs); Output (msgbuf);
+
+  cf_dg_mad = SD_findInt(F("dg_mad"));
+  if (cf_dg_mad < 0) {
+    cf_dg_mad = 0;
+  }
+  sprintf(msgbuf, "CF:dg_mad=[%d]", cf_dg_mad); Output (msgbuf);
+
+  cf_adc_hz = SD_findInt(F("adc_hz"));
+  if ((cf_adc_hz < 0) || (cf_adc_hz > ADC_HZ_MAX) || ((cf_adc_hz > 0) && ((1000 % cf_adc_hz) != 0))) {
+    cf_adc_hz = 0; // Must divide the second evenly, use the default
+  }
+  sprintf(msgbuf, "CF:adc_hz=[%d]", cf_adc_hz); Output (msgbuf);
+
+  cf_n2s_lifo = SD_findInt(F("n2s_lifo"));
+  sprintf(msgbuf, "CF:n2s_lifo=[%d]", cf_n2s_lifo); Output (msgbuf);
+
+  cf_n2s_max_recs = SD_findInt(F("n2s_max_recs"));
+  sprintf(msgbuf, "CF:n2s_max_recs=[%d]", cf_n2s_max_recs); Output (msgbuf);
+
+  cf_n2s_max_secs = SD_findInt(F("n2s_max_secs"));
+  sprintf(msgbuf, "CF:n2s_max_secs=[%d]", cf_n2s_max_secs); Output (msgbuf);
+
+  cf_n2s_compress = SD_findInt(F("n2s_compress"));
+  sprintf(msgbuf, "CF:n2s_compress=[%d]", cf_n2s_compress); Output (msgbuf);
+
+  cf_n2s_journal = SD_findInt(F("n2s_journal"));
+  sprintf(msgbuf, "CF:n2s_journal=[%d]", cf_n2s_journal); Output (msgbuf);
 }
\ No newline at end of file
@@ -7,6 +7,19 @@
 // Prototyping functions to aviod compile function unknown issue.
 void Output(const char *str);
 
+/*
+ * ======================================================================================================================
+ *  The I2C bus is shared between loop() and the sampler thread (WRD.h). Take the Wire lock with WIRE_LOCK()
+ *  at the top of any function that talks to an I2C device once the sampler is running. The lock is
+ *  recursive and is released when the function returns.
+ * ======================================================================================================================
+ */
+struct WireLock {
+  WireLock()  { Wire.lock(); }
+  ~WireLock() { Wire.unlock(); }
+};
+#define WIRE_LOCK()       WireLock wire_lock
+
 /* 
  *=======================================================================================================================
  * I2C_Device_Exist - does i2c device exist
@@ -16,6 +29,7 @@ void Output(const char *str);
  *=======================================================================================================================
  */
 bool I2C_Device_Exist(byte address) {
+  WIRE_LOCK();
   byte error;
 
   Wire.begin();                     // Connect to I2C as Master (no addess is passed to signal being a slave)
@@ -230,6 +244,160 @@ void hexStringToByteArray(const char *hexString, uint8_t *byteArray, int len) {
     }
 }
 
+/*
+ * =======================================================================================================================
+ * FMT_Int() - Write v as decimal text at p, return pointer to the null at the end. Same output as "%ld"
+ * =======================================================================================================================
+ */
+char *FMT_Int(char *p, long v) {
+  char digits[20];  // Room for a 64 bit long
+  int n = 0;
+  unsigned long u = (v < 0) ? (0UL - (unsigned long) v) : (unsigned long) v;
+
+  if (v < 0) {
+    *p++ = '-';
+  }
+  do {
+    digits[n++] = '0' + (u % 10);
+    u /= 10;
+  } while (u);
+  while (n) {
+    *p++ = digits[--n];
+  }
+  *p = 0;
+  return (p);
+}
+
+/*
+ * =======================================================================================================================
+ * FMT_Fixed() - Write f with dp decimal places at p, return pointer to the null at the end. Same output as "%.*f"
+ * 
+ *  A float times 10^dp (dp <= 4) is exact as a double, rint() rounds ties to even like printf, 
+ *  so the text is done with integer math. Anything else goes to snprintf, p must have room for 48 characters.
+ * =======================================================================================================================
+ */
+char *FMT_Fixed(char *p, float f, int dp) {
+  static const uint32_t pow10[] = {1, 10, 100, 1000, 10000};
+  double d;
+  uint64_t q;
+  uint32_t frac;
+
+  if ((dp < 0) || (dp > 4) || !isfinite(f)) {
+    return (p + snprintf(p, 48, "%.*f", dp, (double) f));
+  }
+  d = (double) f * pow10[dp];
+  if (fabs(d) >= 1e15) {
+    return (p + snprintf(p, 48, "%.*f", dp, (double) f));
+  }
+
+  if (signbit(d)) {
+    *p++ = '-';  // printf keeps the sign of negative values that round to zero
+    d = -d;
+  }
+  q = (uint64_t) rint(d);
+  frac = q % pow10[dp];
+  q /= pow10[dp];
+
+  // Integer part
+  char digits[20];
+  int n = 0;
+  do {
+    digits[n++] = '0' + (q % 10);
+    q /= 10;
+  } while (q);
+  while (n) {
+    *p++ = digits[--n];
+  }
+
+  // Fraction, zero padded
+  if (dp) {
+    *p++ = '.';
+    for (int i=dp-1; i>=0; i--) {
+      p[i] = '0' + (frac % 10);
+      frac /= 10;
+    }
+    p += dp;
+  }
+  *p = 0;
+  return (p);
+}
+
+/*
+ * =======================================================================================================================
+ * FMT_TimeStamp() - Write t as ISO 8601 YYYY-MM-DDTHH:MM:SS at ts
+ * 
+ *  The date part is rendered once a day and cached, the time of day is done with integer math.
+ *  Times are UTC, the station never sets Time.zone().
+ * =======================================================================================================================
+ */
+long fmt_ts_day = -1;            // Day number (t / 86400) of the cached date
+char fmt_ts_date[16];            // "YYYY-MM-DDT" for fmt_ts_day
+
+void FMT_TimeStamp(time32_t t, char *ts) {
+  long day = t / 86400;
+  long sec = t % 86400;
+  int hh, mm, ss;
+
+  if (sec < 0) {  // Before 1970, should never happen
+    sec += 86400;
+    day--;
+  }
+  if (day != fmt_ts_day) {
+    sprintf (fmt_ts_date, "%d-%02d-%02dT", Time.year(t), Time.month(t), Time.day(t));
+    fmt_ts_day = day;
+  }
+
+  hh = sec / 3600;
+  mm = (sec / 60) % 60;
+  ss = sec % 60;
+
+  strcpy (ts, fmt_ts_date);
+  ts += strlen(fmt_ts_date);
+  ts[0] = '0' + hh / 10;
+  ts[1] = '0' + hh % 10;
+  ts[2] = ':';
+  ts[3] = '0' + mm / 10;
+  ts[4] = '0' + mm % 10;
+  ts[5] = ':';
+  ts[6] = '0' + ss / 10;
+  ts[7] = '0' + ss % 10;
+  ts[8] = 0;
+}
+
+/*
+ * =======================================================================================================================
+ * Base64_Encode() - Encode len bytes of in to base64 text in out, return length of text
+ *                   out must have room for 4*((len+2)/3)+1 characters
+ * =======================================================================================================================
+ */
+size_t Base64_Encode(const uint8_t *in, size_t len, char *out) {
+  static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t n = 0;
+
+  while (len >= 3) {
+    out[n++] = b64[in[0] >> 2];
+    out[n++] = b64[((in[0] & 0x03) << 4) | (in[1] >> 4)];
+    out[n++] = b64[((in[1] & 0x0F) << 2) | (in[2] >> 6)];
+    out[n++] = b64[in[2] & 0x3F];
+    in += 3;
+    len -= 3;
+  }
+  if (len) {
+    out[n++] = b64[in[0] >> 2];
+    if (len == 1) {
+      out[n++] = b64[(in[0] & 0x03) << 4];
+      out[n++] = '=';
+    }
+    else {
+      out[n++] = b64[((in[0] & 0x03) << 4) | (in[1] >> 4)];
+      out[n++] = b64[(in[1] & 0x0F) << 2];
+    }
+    out[n++] = '=';
+  }
+  out[n] = 0;
+  return (n);
+}
+
 /*
  * ======================================================================================================================
  * JPO_ClearBits() - Clear System Status Bits related to initialization
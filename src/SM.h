@@ -12,6 +12,7 @@ bool Particle_Publish(); // Prototype this function to aviod compile function un
  * ======================================================================================================================
  */
 void StationMonitor() {
+  WIRE_LOCK();
   static int cycle = 0;
   static int count = 0;
   int r, c, len;
@@ -31,9 +31,7 @@ bool RTC_exists = false;
 void stc_timestamp() {
 
   // ISO_8601 Time Format
-  sprintf (timestamp, "%d-%02d-%02dT%02d:%02d:%02d", 
-    Time.year(), Time.month(), Time.day(),
-    Time.hour(), Time.minute(), Time.second());
+  FMT_TimeStamp(Time.now(), timestamp);
 }
 
 /* 
@@ -9,18 +9,19 @@
  *  Wind Related Setup
  * 
  *  NOTE: With interrupts tied to the anemometer rotation we are essentually sampling all the time.  
- *        We record the interrupt count, ms duration and wind direction every second.
+ *        We record the interrupt timing and wind direction wind_hz times a second.
  *        One revolution of the anemometer results in 2 interrupts. There are 2 magnets on the anemometer.
  * 
  *        Station observations are logged every minute
- *        Wind and Direction are sampled every second producing 60 samples 
- *        The one second wind speed sample are produced from the interrupt count and ms duration.
+ *        Wind and Direction are sampled wind_hz times a second by the sampler thread (see below), averaged
+ *        in to 60 one second buckets. Wind speed samples are produced from the time between interrupts.
  *        Wind Observations a 
  *        Reported Observations
  *          Wind Speed = Average of the 60 samples.
  *          Wind Direction = Average of the 60 vectors from Direction and Speed.
- *          Wind Gust = Highest 3 consecutive samples from the 60 samples. The 3 samples are then averaged.
- *          Wind Gust Direction = Average of the 3 Vectors from the Wind Gust samples.
+ *          Wind Gust = Highest average of gust.n (wind_gust_secs * wind_hz) consecutive sub samples since the
+ *                      last observation.
+ *          Wind Gust Direction = Average of the Vectors from the Wind Gust sub samples.
  * 
  * Distance Sensors
  * The 5-meter sensors (MB7360, MB7369, MB7380, and MB7389) use a scale factor of (Vcc/5120) per 1-mm.
@@ -35,8 +36,11 @@
 #define WIND_READINGS       60       // One minute of 1s Samples
 
 typedef struct {
+  bool valid;                   // False if this second was not sampled
   int direction;
   float speed;
+  int32_t ns;                   // North South vector component, mm/s
+  int32_t ew;                   // East West vector component, mm/s
 } WIND_BUCKETS_STR;
 
 typedef struct {
@@ -44,9 +48,97 @@ typedef struct {
   int bucket_idx;
   float gust;
   int gust_direction;
+  time32_t gust_ts;             // Time of the gust, 0 if none
+  int32_t ns_sum;               // Running sums of the valid buckets, kept up to date as buckets are replaced
+  int32_t ew_sum;
+  int offline;                  // Valid buckets with direction -1
+  int moving;                   // Valid buckets with speed > 0
 } WIND_STR;
 WIND_STR wind;
 
+/*
+ * ======================================================================================================================
+ *  Wind Vector Trig - The AS5600 gives 4096 counts per revolution. A quarter wave sine table of Q15 values
+ *  indexed by the raw count gives sin and cos for any count with no floating point. Each bucket keeps its
+ *  vector in integer mm/s, so the running sums are exact and never drift as buckets are replaced.
+ * ======================================================================================================================
+ */
+#define WIND_COUNTS         4096     // AS5600 raw counts per revolution
+#define WIND_QUARTER        1024     // Counts in 90 degrees
+int16_t wind_sin[WIND_QUARTER+1];   // sin() of 0 to 90 degrees, Q15
+
+/*
+ * ======================================================================================================================
+ *  Wind Sub Samples - At wind_hz above 1 the sampler reads speed and direction wind_hz times a second. The
+ *  sub samples feed the gust tracker, and each second they are averaged (speed) and vector averaged 
+ *  (direction) in to the bucket for that second.
+ * ======================================================================================================================
+ */
+#define WIND_HZ_MAX         4        // Sub samples a second
+int wind_hz = 1;                     // Sub samples a second, CONFIG.TXT wind_hz
+int wind_sub = 0;                    // Sub samples taken towards the current second
+int wind_sub_n = 0;                  // Of those, the ones that were sampled
+float wind_sub_speed = 0.0;          // Sum of their speeds
+int32_t wind_sub_ns = 0;             // Sum of their direction unit vectors, Q15
+int32_t wind_sub_ew = 0;
+int wind_sub_raw = -1;               // Last direction, -1 none yet, -2 once any was offline
+
+/*
+ * ======================================================================================================================
+ *  Wind Gust Tracker - Gust is the highest average speed over gust.n consecutive sub samples, the
+ *  window ending at each sample as it arrives. A rolling sum of the window (integer mm/s, so it is exact) 
+ *  makes each sample O(1). The peak, its direction (vector of the window) and time are held until
+ *  Wind_GustUpdate() takes them at the observation. Only windows that start after the last observation
+ *  count, as with the 60 bucket scan this replaces, so wind_gust_secs=3 at wind_hz=1 reports the same gust.
+ *  tools/test/test_gust replays random seconds through both and checks that.
+ *  The WMO 3 second gust is wind_gust_secs=3, wind_hz=4.
+ * ======================================================================================================================
+ */
+#define GUST_MAX            40       // Sub samples in the longest gust window
+
+typedef struct {
+  bool valid;                        // False if not sampled
+  bool offline;                      // Direction sensor offline
+  int32_t mm;                        // Speed mm/s
+  int32_t ns;                        // Vector components, mm/s
+  int32_t ew;
+} GUST_SAMPLE_STR;
+
+typedef struct {
+  GUST_SAMPLE_STR sample[GUST_MAX];
+  int n;                             // Window length in sub samples, CONFIG.TXT wind_gust_secs * wind_hz
+  int idx;                           // Next sample to replace, the oldest
+  int nvalid;                        // Samples in the window that were sampled
+  int offline;                       // Samples in the window with direction offline
+  int moving;                        // Samples in the window with speed > 0
+  int32_t mm_sum;                    // Rolling sums of the window
+  int32_t ns_sum;
+  int32_t ew_sum;
+  uint32_t since;                    // Samples since the last observation
+  int32_t peak;                      // Highest mm_sum, -1 if none yet
+  int peak_direction;
+  time32_t peak_ts;
+} GUST_STR;
+GUST_STR gust;
+
+/*
+ * ======================================================================================================================
+ *  Sampler - A thread takes the 1s wind, distance and air quality samples on its own deadline, so publishing,
+ *  SD card work and anything else that holds up loop() does not stop sampling. If the sampler runs a whole
+ *  second or more late the seconds it missed are left as invalid buckets and the observation is made from 
+ *  the valid ones. Buckets start invalid, so there is no minute of sampling before the first observation.
+ * 
+ *  wind and dg_buckets are shared with loop(), take SMP_LOCK() to use them. Never hold it while waiting 
+ *  on the I2C bus, see WIRE_LOCK() in SF.h.
+ * ======================================================================================================================
+ */
+#define SMP_PERIOD          1000        // ms between samples
+RecursiveMutex smp_mutex;
+#define SMP_LOCK()          std::lock_guard<RecursiveMutex> smp_lock(smp_mutex)
+Thread *smp_thread = NULL;
+uint32_t smp_samples = 0;               // Seconds sampled
+uint32_t smp_missed = 0;                // Seconds not sampled, left as invalid buckets
+
 /*
  * ======================================================================================================================
  *  Wind Direction - AS5600 Sensor
@@ -65,8 +157,6 @@ const int AS5600_raw_ang_lo = 0x0d;
 float ws_calibration = 2.64;       // From wind tunnel testing
 float ws_radius = 0.079;           // In meters
 
-bool ws_refresh = false;           // Set to true when we have delayed too long sending observations
-
 /*
  * ======================================================================================================================
  *  Pin A4 State Setup
@@ -91,6 +181,36 @@ int A4_State = A4_STATE_NULL;                  // Default is not used
 char SD_A5_RAW_FILE[]  = "A5RAW.TXT";          // File used to set pin A5 as generic analog device connected
 int A5_State = A5_STATE_NULL;                  // Default is not used
 
+/*
+ * ======================================================================================================================
+ *  ADC Sampler - A4 and A5 are read in the background by their own thread so observations do not wait on them.
+ *  
+ *  Each tick (adc_hz a second) takes ADC_BURST back to back readings of each pin in use and keeps their sum,
+ *  oversampling to average out ADC noise. Once a second the ticks are decimated to the median of their sums,
+ *  so a spike from the ultrasonic sensor does not move the value. Readers get the last decimated value
+ *  without blocking. DeviceOS has no timer or DMA driven ADC API common to the platforms, so the thread
+ *  is paced with os_thread_delay_until() like the sampler and reads with analogRead().
+ *  
+ *  adc[].value is shared with the sampler and loop(), take SMP_LOCK() to use it.
+ * ======================================================================================================================
+ */
+#define ADC_A4              0
+#define ADC_A5              1
+#define ADC_CHANNELS        2
+#define ADC_BURST           8           // Readings summed each tick, 8 * 4095 fits in uint16_t
+#define ADC_HZ_MAX          20          // Ticks a second
+#define ADC_STALE_MS        2500        // A value older than this is not used
+typedef struct {
+  int pin;
+  uint16_t ticks[ADC_HZ_MAX];           // Burst sums this second
+  int n;                                // Ticks this second
+  float value;                          // Last decimated value, in ADC counts
+  uint32_t ms;                          // millis() value was set, 0 = never
+} ADC_STR;
+ADC_STR adc[ADC_CHANNELS] = {{A4, {0}, 0, 0.0, 0}, {A5, {0}, 0, 0.0, 0}};
+int adc_hz = 10;                        // Ticks a second, CONFIG.TXT adc_hz
+Thread *adc_thread = NULL;
+
 /*
  * =======================================================================================================================
  *  Distance Gauge - Can be Distance or Stream
@@ -98,10 +218,44 @@ int A5_State = A5_STATE_NULL;                  // Default is not used
  */
 #define DISTANCE_GAUGE_PIN  A4
 #define DG_BUCKETS          60
+#define DG_INVALID          0xFFFFFFFF        // Bucket was not sampled or the reading was rejected
 char SD_5M_DIST_FILE[] = "5MDIST.TXT";        // Multiply by 1.25 for 5m Distance Gauge
-unsigned int dg_bucket = 0;
 float dg_adjustment = 2.5;                    // Default sensor is 10m
-unsigned int dg_buckets[DG_BUCKETS];
+unsigned int dg_buckets[DG_BUCKETS];          // Ring of the last DG_BUCKETS samples, sample n at [n % DG_BUCKETS]
+uint32_t dg_seq = 0;                          // Samples added to dg_buckets
+
+/*
+ * =======================================================================================================================
+ *  Distance Gauge Running Median - The valid buckets are kept in 2 heaps of bucket indexes, dg_lo a max heap of
+ *  the lower half and dg_hi a min heap of the upper half. dg_lo holds the extra one when the count is odd, so
+ *  its top is the median (the lower one when even, as the sorted median was). dg_pos[] is where each bucket
+ *  is in the heaps, so the bucket being replaced can be taken out. Each sample is O(log n).
+ *
+ *  Min and max are the fronts of 2 monotonic queues of sample numbers, O(1) per sample.
+ *
+ *  With dg_mad set, a reading further than dg_mad * MAD (median absolute deviation, scaled to a standard 
+ *  deviation) from the median is rejected as an outlier and left as an invalid bucket. MAD is recomputed each
+ *  time the ring has been filled. Rejected readings are held in dg_held[]. After half a ring of rejections in
+ *  a row the level is taken as having really changed: the window is rebuilt from the held readings of the run,
+ *  the readings from before it are dropped, and MAD is recomputed from the new level.
+ * =======================================================================================================================
+ */
+#define DG_NOWHERE          0x7FFF            // dg_pos[] of a bucket not in a heap
+#define DG_MAD_MIN          10                // Valid buckets before rejection starts
+int dg_lo[DG_BUCKETS];                        // Max heap of the lower half
+int dg_hi[DG_BUCKETS];                        // Min heap of the upper half
+int dg_lo_n = 0;
+int dg_hi_n = 0;
+int dg_pos[DG_BUCKETS];                       // >=0 index in dg_lo, <0 -(index+1) in dg_hi, DG_NOWHERE
+uint32_t dg_minq[DG_BUCKETS];                 // Sample numbers, values increasing from the front
+uint32_t dg_maxq[DG_BUCKETS];                 // Sample numbers, values decreasing from the front
+uint32_t dg_minq_h = 0, dg_minq_t = 0;        // Front and back, index % DG_BUCKETS
+uint32_t dg_maxq_h = 0, dg_maxq_t = 0;
+float dg_mad_scale = 0.0;                     // 1.4826 * MAD, 0 = not known yet
+int dg_reject_run = 0;                        // Rejections in a row
+uint32_t dg_run_start = 0;                    // Sample number of the first rejection in the run
+unsigned int dg_held[DG_BUCKETS];             // Reading rejected for each bucket, DG_INVALID if none
+uint32_t dg_rejects = 0;                      // Readings rejected as outliers
 
 // Interrupts
 // NOTE All A and D pins (including TX, RX, and SPI) on Gen 3 devices can be used for interrupts, 
@@ -112,8 +266,21 @@ unsigned int dg_buckets[DG_BUCKETS];
  *  Optipolar Hall Effect Sensor SS451A - Anemometer
  * ======================================================================================================================
  */
+/*
+ *  The interrupt handler saves the micros() time of each pulse in anemometer_ts[] at the pulse count, then
+ *  bumps the count. It is the only writer, so no lock is needed. The count is never cleared, each sample
+ *  takes the pulses since the count it saw last time, so a pulse between reading and clearing is not lost.
+ *  Speed is from the time between pulses, which resolves light winds that a count per sample can not.
+ */
+#define ANEMOMETER_RING     16          // Pulse times kept, power of 2
+#define ANEMOMETER_CALM_MS  3000        // No pulse for this long is calm
 volatile unsigned int anemometer_interrupt_count;
-uint64_t anemometer_interrupt_stime;
+volatile uint32_t anemometer_ts[ANEMOMETER_RING];   // micros() of pulse n at [n % ANEMOMETER_RING]
+uint64_t anemometer_interrupt_stime;    // System.millis() of the last sample, for the count based fallback
+unsigned int anemometer_taken = 0;      // anemometer_interrupt_count at the last sample
+bool anemometer_timed = false;          // anemometer_last_us holds the time of the last pulse taken
+uint32_t anemometer_last_us = 0;
+uint32_t anemometer_period_us = 0;      // us between pulses at the last sample, 0 = calm
 
 /*
  * ======================================================================================================================
@@ -123,9 +290,54 @@ uint64_t anemometer_interrupt_stime;
 #define ANEMOMETER_IRQ_PIN  A2
 void anemometer_interrupt_handler()
 {
+  anemometer_ts[anemometer_interrupt_count & (ANEMOMETER_RING-1)] = micros();
+  __sync_synchronize(); // Time is stored before the count says it is there
   anemometer_interrupt_count++;
 }
 
+/*
+ * ======================================================================================================================
+ *  Rain Tips - Each tip the interrupt handler counts is also pushed with its millis() time in to the gauge's
+ *  rain_tips[] ring. The handler is the only writer of head, the sampler thread is the only reader, so no 
+ *  lock is needed. Each second the sampler takes the new tips (Rain_TipsTake) and keeps, until the next 
+ *  observation takes them (Rain_TipsObs):
+ *    Rate       mm/h from the time between the last 2 tips. With no tip since, the rate is at most one tip
+ *               over the time since the last tip, and 0 after RAIN_RATE_MAX_MS.
+ *    Intensity  Peak tips in any RAIN_WINDOW_MS (1 minute) window, as mm/h.
+ *    First/Last Time of the first and last tip.
+ *  The daily values are kept with the rain totals in EEPROM (EP.h).
+ * ======================================================================================================================
+ */
+#define RAIN_TIP_MM         0.2         // mm of rain per tip
+#define RAIN_RING           128         // Tips kept, more than RAIN_WINDOW_MS at the 500ms debounce. Power of 2
+#define RAIN_WINDOW_MS      60000       // Intensity window
+#define RAIN_RATE_MAX_MS    3600000     // No tip for this long, rate is 0
+
+typedef struct {
+  volatile uint32_t ms[RAIN_RING];      // millis() of tip n at [n % RAIN_RING]
+  volatile unsigned int head;           // Tips pushed by the interrupt handler
+  unsigned int taken;                   // Tips taken by the sampler
+  unsigned int start;                   // Oldest tip in the intensity window
+  uint32_t last_ms;                     // millis() of the last tip taken
+  uint32_t interval_ms;                 // Between the last 2 tips, 0 = only one tip
+  bool have_last;
+  int peak;                             // Most tips in a window since the observation
+  time32_t first;                       // Time of the first and last tip since the observation, 0 = none
+  time32_t last;
+} RAIN_TIPS_STR;
+RAIN_TIPS_STR rain_tips[2];             // Rain Gauge 1 and 2
+
+/*
+ * ======================================================================================================================
+ *  Rain_TipPush() - Called by the interrupt handler with the time of an accepted tip
+ * ======================================================================================================================
+ */
+void Rain_TipPush(RAIN_TIPS_STR *r, uint32_t ms) {
+  r->ms[r->head & (RAIN_RING-1)] = ms;
+  __sync_synchronize(); // Time is stored before head says it is there
+  r->head++;
+}
+
 /*
  * ======================================================================================================================
  *  Optipolar Hall Effect Sensor SS451A - Rain Gauge
@@ -147,6 +359,7 @@ void raingauge1_interrupt_handler()
   if ((System.millis() - raingauge1_interrupt_ltime) > 500) { // Count tip if a half second has gone by since last interrupt
     raingauge1_interrupt_ltime = System.millis();
     raingauge1_interrupt_count++;
+    Rain_TipPush(&rain_tips[0], (uint32_t) raingauge1_interrupt_ltime);
     digitalWrite(LED_PIN, HIGH);
     TurnLedOff = true;
   }   
@@ -173,11 +386,94 @@ void raingauge2_interrupt_handler()
   if ((System.millis() - raingauge2_interrupt_ltime) > 500) { // Count tip if a half second has gone by since last interrupt
     raingauge2_interrupt_ltime = System.millis();
     raingauge2_interrupt_count++;
+    Rain_TipPush(&rain_tips[1], (uint32_t) raingauge2_interrupt_ltime);
     digitalWrite(LED_PIN, HIGH);
     TurnLedOff = true;
   }   
 }
 
+/*
+ * ======================================================================================================================
+ *  Rain_TipsTake() - Take the tips pushed since the last call. Called by the sampler thread each second and
+ *    by the observation to be up to date.
+ * ======================================================================================================================
+ */
+void Rain_TipsTake(RAIN_TIPS_STR *r) {
+  SMP_LOCK();
+  unsigned int head = r->head;
+  uint32_t now_ms = millis();
+  uint32_t ms;
+
+  __sync_synchronize();
+  if ((head - r->taken) > RAIN_RING) {
+    r->taken = head - RAIN_RING;  // Overwritten before we got to them, they are still in the count
+  }
+
+  for (; r->taken != head; r->taken++) {
+    ms = r->ms[r->taken & (RAIN_RING-1)];
+
+    if (r->have_last) {
+      r->interval_ms = ms - r->last_ms;
+    }
+    r->last_ms = ms;
+    r->have_last = true;
+
+    // Tips in the window ending at this one
+    if ((r->taken - r->start) >= RAIN_RING) {
+      r->start = r->taken - (RAIN_RING-1);
+    }
+    while ((ms - r->ms[r->start & (RAIN_RING-1)]) >= RAIN_WINDOW_MS) {
+      r->start++;
+    }
+    if ((int) (r->taken - r->start + 1) > r->peak) {
+      r->peak = r->taken - r->start + 1;
+    }
+
+    if (Time.isValid()) {
+      r->last = Time.now() - ((now_ms - ms) / 1000);
+      if (r->first == 0) {
+        r->first = r->last;
+      }
+    }
+  }
+}
+
+/*
+ * ======================================================================================================================
+ *  Rain_Rate() - Rain rate in mm/h now
+ * ======================================================================================================================
+ */
+float Rain_Rate(RAIN_TIPS_STR *r) {
+  SMP_LOCK();
+  uint32_t since, ms;
+
+  if (!r->have_last) {
+    return (0.0);
+  }
+  since = millis() - r->last_ms;
+  if (since >= RAIN_RATE_MAX_MS) {
+    return (0.0);
+  }
+  ms = (since > r->interval_ms) ? since : r->interval_ms;
+  return ((ms) ? (RAIN_TIP_MM * 3600000.0 / ms) : 0.0);
+}
+
+/*
+ * ======================================================================================================================
+ *  Rain_TipsObs() - Take the peak intensity (mm/h), first and last tip times since the last observation
+ * ======================================================================================================================
+ */
+void Rain_TipsObs(RAIN_TIPS_STR *r, float *intensity, time32_t *first, time32_t *last) {
+  SMP_LOCK();
+
+  *intensity = r->peak * RAIN_TIP_MM * (3600000.0 / RAIN_WINDOW_MS);
+  *first = r->first;
+  *last = r->last;
+  r->peak = 0;
+  r->first = 0;
+  r->last = 0;
+}
+
 /* 
  *=======================================================================================================================
  * as5600_initialize() - wind direction sensor I2C 0x36
@@ -262,10 +558,81 @@ void A5_Initialize() {
 
 /* 
  *=======================================================================================================================
- * Pin_ReadAvg()
+ * ADC_Value() - Last decimated value of an ADC channel, false if there is not a current one
+ *=======================================================================================================================
+ */
+bool ADC_Value(int ch, float *value) {
+  SMP_LOCK();
+
+  if ((adc[ch].ms == 0) || ((millis() - adc[ch].ms) > ADC_STALE_MS)) {
+    return (false);
+  }
+  *value = adc[ch].value;
+  return (true);
+}
+
+/* 
+ *=======================================================================================================================
+ * ADC_Tick() - Add a burst of readings to the channel's second
+ *=======================================================================================================================
+ */
+void ADC_Tick(int ch) {
+  uint16_t sum = 0;
+
+  for (int i=0; i<ADC_BURST; i++) {
+    sum += analogRead(adc[ch].pin);
+  }
+  if (adc[ch].n < ADC_HZ_MAX) {
+    adc[ch].ticks[adc[ch].n++] = sum;
+  }
+}
+
+/* 
+ *=======================================================================================================================
+ * ADC_Decimate() - Make the median of the second's ticks the channel's value, start the next second
+ *=======================================================================================================================
+ */
+void ADC_Decimate(int ch) {
+  int n = adc[ch].n;
+  uint16_t *t = adc[ch].ticks;
+  uint16_t v;
+  int j;
+
+  if (n == 0) {
+    return; // Nothing read, the value goes stale
+  }
+
+  // Insertion sort, at most ADC_HZ_MAX values once a second
+  for (int i=1; i<n; i++) {
+    v = t[i];
+    for (j=i; (j>0) && (t[j-1] > v); j--) {
+      t[j] = t[j-1];
+    }
+    t[j] = v;
+  }
+  v = ((n % 2) == 1) ? t[n/2] : (t[n/2-1] + t[n/2]) / 2;
+  adc[ch].n = 0;
+
+  SMP_LOCK();
+  adc[ch].value = (float) v / ADC_BURST;
+  adc[ch].ms = millis();
+  if (adc[ch].ms == 0) {
+    adc[ch].ms = 1; // 0 is never set
+  }
+}
+
+/* 
+ *=======================================================================================================================
+ * Pin_ReadAvg() - Background value of A4 or A5, a blocking average of 5 readings until there is one
  *=======================================================================================================================
  */
 float Pin_ReadAvg(int pin) {
+  float value;
+
+  if (ADC_Value((pin == A5) ? ADC_A5 : ADC_A4, &value)) {
+    return (value);
+  }
+
   int numReadings = 5;
   int totalValue = 0;
   for (int i = 0; i < numReadings; i++) {
@@ -275,14 +642,287 @@ float Pin_ReadAvg(int pin) {
   return(totalValue / numReadings);
 }
 
+/*
+ * ======================================================================================================================
+ * DG_Above() - True if bucket a belongs above bucket b in heap dg_lo (lo) or dg_hi
+ * ======================================================================================================================
+ */
+bool DG_Above(bool lo, int a, int b) {
+  return ((lo) ? (dg_buckets[a] > dg_buckets[b]) : (dg_buckets[a] < dg_buckets[b]));
+}
+
+/*
+ * ======================================================================================================================
+ * DG_Set() - Put bucket b at heap index i
+ * ======================================================================================================================
+ */
+void DG_Set(bool lo, int i, int b) {
+  if (lo) {
+    dg_lo[i] = b;
+    dg_pos[b] = i;
+  }
+  else {
+    dg_hi[i] = b;
+    dg_pos[b] = -(i+1);
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * DG_Fix() - Move the bucket at heap index i up or down to where it belongs
+ * ======================================================================================================================
+ */
+void DG_Fix(bool lo, int i) {
+  int *h = (lo) ? dg_lo : dg_hi;
+  int n = (lo) ? dg_lo_n : dg_hi_n;
+  int b = h[i];
+  int c;
+
+  while ((i > 0) && DG_Above(lo, b, h[(i-1)/2])) {
+    DG_Set(lo, i, h[(i-1)/2]);
+    i = (i-1)/2;
+  }
+  while ((c = (2*i)+1) < n) {
+    if (((c+1) < n) && DG_Above(lo, h[c+1], h[c])) {
+      c++;
+    }
+    if (!DG_Above(lo, h[c], b)) {
+      break;
+    }
+    DG_Set(lo, i, h[c]);
+    i = c;
+  }
+  DG_Set(lo, i, b);
+}
+
+/*
+ * ======================================================================================================================
+ * DG_Push() - Add bucket b to a heap
+ * ======================================================================================================================
+ */
+void DG_Push(bool lo, int b) {
+  int i = (lo) ? dg_lo_n++ : dg_hi_n++;
+
+  DG_Set(lo, i, b);
+  DG_Fix(lo, i);
+}
+
+/*
+ * ======================================================================================================================
+ * DG_Erase() - Take the bucket at heap index i out, return it
+ * ======================================================================================================================
+ */
+int DG_Erase(bool lo, int i) {
+  int *h = (lo) ? dg_lo : dg_hi;
+  int n = (lo) ? --dg_lo_n : --dg_hi_n;
+  int b = h[i];
+
+  dg_pos[b] = DG_NOWHERE;
+  if (i < n) {
+    DG_Set(lo, i, h[n]);
+    DG_Fix(lo, i);
+  }
+  return (b);
+}
+
+/*
+ * ======================================================================================================================
+ * DG_Balance() - Keep dg_lo the same size as dg_hi or one bigger
+ * ======================================================================================================================
+ */
+void DG_Balance() {
+  if (dg_lo_n > (dg_hi_n + 1)) {
+    DG_Push(false, DG_Erase(true, 0));
+  }
+  else if (dg_hi_n > dg_lo_n) {
+    DG_Push(true, DG_Erase(false, 0));
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * DG_Add() - Replace the oldest bucket with distance, DG_INVALID if not sampled or rejected
+ * ======================================================================================================================
+ */
+void DG_Add(unsigned int distance) {
+  int b = dg_seq % DG_BUCKETS;
+
+  dg_held[b] = DG_INVALID;
+
+  // Take the oldest out of the heaps
+  if (dg_pos[b] != DG_NOWHERE) {
+    if (dg_pos[b] >= 0) {
+      DG_Erase(true, dg_pos[b]);
+    }
+    else {
+      DG_Erase(false, -dg_pos[b] - 1);
+    }
+    DG_Balance();  // dg_lo is only empty if both are
+  }
+
+  // Drop the oldest from the front of the queues
+  while ((dg_minq_t != dg_minq_h) && ((dg_seq - dg_minq[dg_minq_h % DG_BUCKETS]) >= DG_BUCKETS)) {
+    dg_minq_h++;
+  }
+  while ((dg_maxq_t != dg_maxq_h) && ((dg_seq - dg_maxq[dg_maxq_h % DG_BUCKETS]) >= DG_BUCKETS)) {
+    dg_maxq_h++;
+  }
+
+  dg_buckets[b] = distance;
+  if (distance != DG_INVALID) {
+    if ((dg_lo_n == 0) || (distance <= dg_buckets[dg_lo[0]])) {
+      DG_Push(true, b);
+    }
+    else {
+      DG_Push(false, b);
+    }
+
+    while ((dg_minq_t != dg_minq_h) && (dg_buckets[dg_minq[(dg_minq_t-1) % DG_BUCKETS] % DG_BUCKETS] >= distance)) {
+      dg_minq_t--;
+    }
+    dg_minq[dg_minq_t++ % DG_BUCKETS] = dg_seq;
+    while ((dg_maxq_t != dg_maxq_h) && (dg_buckets[dg_maxq[(dg_maxq_t-1) % DG_BUCKETS] % DG_BUCKETS] <= distance)) {
+      dg_maxq_t--;
+    }
+    dg_maxq[dg_maxq_t++ % DG_BUCKETS] = dg_seq;
+  }
+  DG_Balance();
+  dg_seq++;
+}
+
+/*
+ * ======================================================================================================================
+ * DG_CompareUInt() - qsort() compare
+ * ======================================================================================================================
+ */
+int DG_CompareUInt(const void *a, const void *b) {
+  unsigned int x = *(const unsigned int *) a;
+  unsigned int y = *(const unsigned int *) b;
+
+  return ((x > y) - (x < y));
+}
+
+/*
+ * ======================================================================================================================
+ * DG_MADUpdate() - Recompute dg_mad_scale from the valid buckets
+ * ======================================================================================================================
+ */
+void DG_MADUpdate() {
+  unsigned int dev[DG_BUCKETS];
+  unsigned int median;
+  int n = 0;
+
+  if (dg_lo_n < DG_MAD_MIN) {
+    dg_mad_scale = 0.0;
+    return;
+  }
+  median = dg_buckets[dg_lo[0]];
+  for (int i=0; i<DG_BUCKETS; i++) {
+    if (dg_buckets[i] != DG_INVALID) {
+      dev[n++] = (dg_buckets[i] > median) ? (dg_buckets[i] - median) : (median - dg_buckets[i]);
+    }
+  }
+  qsort (dev, n, sizeof(unsigned int), DG_CompareUInt);
+  dg_mad_scale = 1.4826 * dev[(n+1) / 2 - 1];
+  if (dg_mad_scale < dg_adjustment) {
+    dg_mad_scale = dg_adjustment; // At least one ADC step, so steady readings do not reject everything
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * DG_Clear() - Mark all buckets invalid and empty the heaps and queues, dg_seq is left as it is
+ * ======================================================================================================================
+ */
+void DG_Clear() {
+  for (int i=0; i<DG_BUCKETS; i++) {
+    dg_buckets[i] = DG_INVALID;
+    dg_held[i] = DG_INVALID;
+    dg_pos[i] = DG_NOWHERE;
+  }
+  dg_lo_n = 0;
+  dg_hi_n = 0;
+  dg_minq_h = dg_minq_t = 0;
+  dg_maxq_h = dg_maxq_t = 0;
+}
+
+/*
+ * ======================================================================================================================
+ * DG_Restart() - The level has changed, rebuild the window from the readings held since dg_run_start
+ * ======================================================================================================================
+ */
+void DG_Restart() {
+  unsigned int run[DG_BUCKETS];
+  uint32_t n = dg_seq - dg_run_start;
+
+  if (n > DG_BUCKETS) {
+    n = DG_BUCKETS;
+  }
+  for (uint32_t i=0; i<n; i++) {
+    run[i] = dg_held[(dg_seq - n + i) % DG_BUCKETS];  // DG_INVALID where the sample was missed
+  }
+  DG_Clear();
+  dg_seq -= n;
+  for (uint32_t i=0; i<n; i++) {
+    DG_Add(run[i]);
+  }
+  dg_reject_run = 0;
+  DG_MADUpdate();
+}
+
+/*
+ * ======================================================================================================================
+ * DistanceGauge_Reset() - Mark all buckets invalid and empty the heaps and queues
+ * ======================================================================================================================
+ */
+void DistanceGauge_Reset() {
+  SMP_LOCK();
+
+  DG_Clear();
+  dg_seq = 0;
+  dg_mad_scale = 0.0;
+  dg_reject_run = 0;
+}
+
 /*
  * ======================================================================================================================
  * DistanceGauge_TakeReading() - measure every second             
  * ======================================================================================================================
  */
-void DistanceGauge_TakeReading() {
-  dg_buckets[dg_bucket] = (int) analogRead(DISTANCE_GAUGE_PIN) * dg_adjustment;
-  dg_bucket = (++dg_bucket) % DG_BUCKETS; // Advance bucket index for next reading
+void DistanceGauge_TakeReading(uint32_t missed) {
+  unsigned int distance = DG_INVALID;
+  float value;
+
+  if (ADC_Value(ADC_A4, &value)) {
+    distance = value * dg_adjustment;
+  }
+
+  SMP_LOCK();
+  for (uint32_t i=0; (i<missed) && (i<DG_BUCKETS); i++) {
+    DG_Add(DG_INVALID);
+  }
+
+  // Outlier check
+  if ((distance != DG_INVALID) && cf_dg_mad && (dg_mad_scale > 0) && (dg_lo_n >= DG_MAD_MIN) &&
+      (fabs((float) distance - (float) dg_buckets[dg_lo[0]]) > (cf_dg_mad * dg_mad_scale))) {
+    dg_rejects++;
+    if (dg_reject_run++ == 0) {
+      dg_run_start = dg_seq;
+    }
+    DG_Add(DG_INVALID);
+    dg_held[(dg_seq - 1) % DG_BUCKETS] = distance;
+    if (dg_reject_run >= (DG_BUCKETS/2)) {
+      DG_Restart();
+    }
+  }
+  else {
+    dg_reject_run = 0;
+    DG_Add(distance);
+  }
+
+  if (cf_dg_mad && ((dg_seq % DG_BUCKETS) == 0)) {
+    DG_MADUpdate();
+  }
 }
 
 /* 
@@ -291,61 +931,134 @@ void DistanceGauge_TakeReading() {
  *=======================================================================================================================
  */
 float DistanceGauge_Median() {
-  int i;
-  
-  mysort(dg_buckets, DG_BUCKETS);
-  i = (DG_BUCKETS+1) / 2 - 1; // -1 as array indexing in C starts from 0
-  
-  return (dg_buckets[i]); 
+  SMP_LOCK();
+
+  return ((dg_lo_n) ? dg_buckets[dg_lo[0]] : 0.0);
 }
 
 /* 
  *=======================================================================================================================
- * Wind_SampleSpeed() - Return a wind speed based on interrupts and duration wind
+ * DistanceGauge_Min() - Lowest reading in the window, 0 if none
+ *=======================================================================================================================
+ */
+float DistanceGauge_Min() {
+  SMP_LOCK();
+
+  return ((dg_minq_t != dg_minq_h) ? dg_buckets[dg_minq[dg_minq_h % DG_BUCKETS] % DG_BUCKETS] : 0.0);
+}
+
+/* 
+ *=======================================================================================================================
+ * DistanceGauge_Max() - Highest reading in the window, 0 if none
+ *=======================================================================================================================
+ */
+float DistanceGauge_Max() {
+  SMP_LOCK();
+
+  return ((dg_maxq_t != dg_maxq_h) ? dg_buckets[dg_maxq[dg_maxq_h % DG_BUCKETS] % DG_BUCKETS] : 0.0);
+}
+
+/* 
+ *=======================================================================================================================
+ * DistanceGauge_Spread() - Max - Min
+ *=======================================================================================================================
+ */
+float DistanceGauge_Spread() {
+  SMP_LOCK();
+
+  return (DistanceGauge_Max() - DistanceGauge_Min());
+}
+
+/* 
+ *=======================================================================================================================
+ * Wind_PulseSpeed() - Wind speed of pulses anemometer interrupts in us microseconds
  * 
  * Optipolar Hall Effect Sensor SS451A - Anemometer
  * speed  = (( (signals/2) * (2 * pi * radius) ) / time) * calibration_factor
  * speed in m/s =  (   ( (interrupts/2) * (2 * 3.14156 * 0.079) )  / (time_period in ms / 1000)  )  * 2.64
  *=======================================================================================================================
  */
+float Wind_PulseSpeed(unsigned int pulses, float us) {
+  return (( ( pulses * 3.14156 * ws_radius)  / (us / 1000000) )  * ws_calibration);
+}
+
+/* 
+ *=======================================================================================================================
+ * Wind_SampleSpeed() - Return a wind speed from the anemometer pulses since the last sample
+ * 
+ *   Pulses:     Average period from the last pulse of the previous sample to the last pulse of this one.
+ *   No pulses:  The period is at least the time since the last pulse, so the speed falls off until
+ *               ANEMOMETER_CALM_MS with no pulse, then it is 0.
+ *   Fallback:   Pulses over the time since the last sample, as counted before, when there is no earlier pulse
+ *               to time from (start or after calm) or the pulse times have been overwritten.
+ *=======================================================================================================================
+ */
 float Wind_SampleSpeed() {
-  uint64_t delta_ms;
+  uint64_t now_ms = System.millis();
+  uint32_t now_us = micros();
+  uint64_t delta_ms = now_ms - anemometer_interrupt_stime;
+  unsigned int count = anemometer_interrupt_count;
+  unsigned int n = count - anemometer_taken;   // Pulses since the last sample
+  uint32_t last_us, since_us;
   float wind_speed;
-  
-  delta_ms = System.millis()-anemometer_interrupt_stime;
 
-  if (anemometer_interrupt_count) {
-    // wind_speed = (  ( (anemometer_interrupt_count/2) * (2 * 3.14156 * ws_radius) )  / 
-    //  (float)( (float)delta_ms / 1000)  )  * ws_calibration;
+  anemometer_interrupt_stime = now_ms;
+  anemometer_taken = count;
+
+  if (n == 0) {
+    since_us = now_us - anemometer_last_us;
+    if (!anemometer_timed || (anemometer_period_us == 0) || (since_us >= (ANEMOMETER_CALM_MS * 1000UL))) {
+      anemometer_period_us = 0;
+      anemometer_timed = false;
+      return (0.0);
+    }
+    return (Wind_PulseSpeed(1, (since_us > anemometer_period_us) ? since_us : anemometer_period_us));
+  }
+
+  __sync_synchronize();
+  last_us = anemometer_ts[(count-1) & (ANEMOMETER_RING-1)];
+  __sync_synchronize();
 
-    wind_speed = ( ( anemometer_interrupt_count * 3.14156 * ws_radius)  / 
-        (float)( (float)delta_ms / 1000) )  * ws_calibration;
+  if (anemometer_timed && ((anemometer_interrupt_count - count) < ANEMOMETER_RING)) {
+    anemometer_period_us = (last_us - anemometer_last_us) / n;
+    wind_speed = Wind_PulseSpeed(n, last_us - anemometer_last_us);
   }
   else {
-    wind_speed = 0.0;
+    anemometer_period_us = (delta_ms) ? (delta_ms * 1000) / n : 0;
+    wind_speed = (delta_ms) ? Wind_PulseSpeed(n, (float) delta_ms * 1000) : 0.0;
   }
+  anemometer_last_us = last_us;
+  anemometer_timed = true;
 
-  anemometer_interrupt_count = 0;
-  anemometer_interrupt_stime = System.millis();
-  
   return (wind_speed);
 } 
 
 /* 
  *=======================================================================================================================
- * Wind_SampleDirection() -- Talk i2c to the AS5600 sensor and get direction
+ * Wind_SpeedReset() - Start sampling speed from now
  *=======================================================================================================================
  */
-int Wind_SampleDirection() {
-  int degree;
+void Wind_SpeedReset() {
+  anemometer_taken = anemometer_interrupt_count;
+  anemometer_interrupt_stime = System.millis();
+  anemometer_timed = false;
+  anemometer_period_us = 0;
+}
+
+/* 
+ *=======================================================================================================================
+ * Wind_SampleRaw() -- Talk i2c to the AS5600 sensor and get the raw angle count 0-4095, -1 if offline
+ *=======================================================================================================================
+ */
+int Wind_SampleRaw() {
+  WIRE_LOCK();
   
+  // No Output() here, this runs on the sampler thread. I2C_Check_Sensors() reports the sensor going on/offline.
+
   // Read Raw Angle Low Byte
   Wire.beginTransmission(AS5600_ADR);
   Wire.write(AS5600_raw_ang_lo);
   if (Wire.endTransmission()) {
-    if (AS5600_exists) {
-      Output ("WD Offline_L");
-    }
     AS5600_exists = false;
   }
   else if (Wire.requestFrom(AS5600_ADR, 1)) {
@@ -355,25 +1068,18 @@ int Wind_SampleDirection() {
     Wire.beginTransmission(AS5600_ADR);
     Wire.write(AS5600_raw_ang_hi);
     if (Wire.endTransmission()) {
-      if (AS5600_exists) {
-        Output ("WD Offline_H");
-      }
       AS5600_exists = false;
     }
     else if (Wire.requestFrom(AS5600_ADR, 1)) {
       word AS5600_hi_raw = Wire.read();
 
-      if (!AS5600_exists) {
-        Output ("WD Online");
-      }
       AS5600_exists = true;           // We made it 
       SystemStatusBits &= ~SSB_AS5600; // Turn Off Bit
       
       AS5600_hi_raw = AS5600_hi_raw << 8; //shift raw angle hi 8 left
       AS5600_hi_raw = AS5600_hi_raw | AS5600_lo_raw; //AND high and low raw angle value
-      degree = (int) AS5600_hi_raw * 0.0879;
-      if ((degree >=0) && (degree <= 360)) {
-        return (degree);
+      if (AS5600_hi_raw < WIND_COUNTS) {
+        return (AS5600_hi_raw);
       }
       else {
         return (-1);
@@ -384,53 +1090,140 @@ int Wind_SampleDirection() {
   return (-1); // Not the best value to return 
 }
 
+/* 
+ *=======================================================================================================================
+ * Wind_SampleDirection() -- Direction in degrees from the AS5600, -1 if offline
+ *=======================================================================================================================
+ */
+int Wind_SampleDirection() {
+  int raw = Wind_SampleRaw();
+
+  return ((raw < 0) ? -1 : (int) (raw * 0.0879));
+}
+
+/* 
+ *=======================================================================================================================
+ * Wind_Trig_Initialize() -- Fill the quarter wave sine table
+ *=======================================================================================================================
+ */
+void Wind_Trig_Initialize() {
+  for (int i=0; i<=WIND_QUARTER; i++) {
+    wind_sin[i] = (int16_t) lround(32767.0 * sin((M_PI / 2.0) * i / WIND_QUARTER));
+  }
+}
+
+/* 
+ *=======================================================================================================================
+ * Wind_Sin() -- sin() of an AS5600 raw count, Q15. Wind_Sin(raw + WIND_QUARTER) is cos().
+ *=======================================================================================================================
+ */
+int32_t Wind_Sin(int raw) {
+  int i;
+
+  raw &= (WIND_COUNTS-1);
+  i = raw & (WIND_QUARTER-1);
+  switch (raw / WIND_QUARTER) {
+    case 0 : return (wind_sin[i]);
+    case 1 : return (wind_sin[WIND_QUARTER-i]);
+    case 2 : return (-wind_sin[i]);
+    default: return (-wind_sin[WIND_QUARTER-i]);
+  }
+}
+
+/* 
+ *=======================================================================================================================
+ * Wind_Degrees() -- Direction in degrees 0-359 of a vector
+ *=======================================================================================================================
+ */
+int Wind_Degrees(int32_t ns, int32_t ew) {
+  int rtod = (atan2((double) ew, (double) ns)*4068.0)/71.0;
+
+  if (rtod<0) {
+    rtod = 360 + rtod;
+  }
+  return (rtod);
+}
+
+/* 
+ *=======================================================================================================================
+ * Wind_Vector() -- North South and East West components, mm/s, of speed mm at raw AS5600 count
+ *=======================================================================================================================
+ */
+void Wind_Vector(int raw, int32_t mm, int32_t *ns, int32_t *ew) {
+  *ns = (int32_t) (((int64_t) Wind_Sin(raw + WIND_QUARTER) * mm) >> 15);
+  *ew = (int32_t) (((int64_t) Wind_Sin(raw) * mm) >> 15);
+}
+
+/* 
+ *=======================================================================================================================
+ * Wind_Raw() -- AS5600 raw count of a vector
+ *=======================================================================================================================
+ */
+int Wind_Raw(int32_t ns, int32_t ew) {
+  return (((int) lround(atan2((double) ew, (double) ns) * WIND_COUNTS / (2.0 * M_PI))) & (WIND_COUNTS-1));
+}
+
+/* 
+ *=======================================================================================================================
+ * Wind_BucketSet() -- Replace bucket b, keeping the running sums and counts. raw is -1 if direction is offline.
+ *   Call with SMP_LOCK() held.
+ *=======================================================================================================================
+ */
+void Wind_BucketSet(int b, bool valid, int raw, float speed) {
+  WIND_BUCKETS_STR *w = &wind.bucket[b];
+  int32_t mm;
+
+  // Take the old sample out
+  if (w->valid) {
+    wind.ns_sum -= w->ns;
+    wind.ew_sum -= w->ew;
+    wind.offline -= (w->direction == -1) ? 1 : 0;
+    wind.moving  -= (w->speed > 0) ? 1 : 0;
+  }
+
+  w->valid = valid;
+  w->direction = (raw < 0) ? -1 : (int) (raw * 0.0879);
+  w->speed = speed;
+  w->ns = 0;
+  w->ew = 0;
+
+  // Put the new one in
+  if (valid) {
+    if (raw >= 0) {
+      mm = (int32_t) lround(speed * 1000.0);
+      Wind_Vector(raw, mm, &w->ns, &w->ew);
+    }
+    wind.ns_sum += w->ns;
+    wind.ew_sum += w->ew;
+    wind.offline += (w->direction == -1) ? 1 : 0;
+    wind.moving  += (w->speed > 0) ? 1 : 0;
+  }
+}
+
 /* 
  *=======================================================================================================================
  * Wind_DirectionVector()
  *=======================================================================================================================
  */
 int Wind_DirectionVector() {
-  double NS_vector_sum = 0.0;
-  double EW_vector_sum = 0.0;
-  double r;
-  float s;
-  int d, i, rtod;
-  bool ws_zero = true;
-
-  for (i=0; i<WIND_READINGS; i++) {
-    d = wind.bucket[i].direction;
+  {
+    SMP_LOCK();
 
     // if at any time 1 of the 60 wind direction readings is -1
     // then the sensor was offline and we need to invalidate or data
     // until it is clean with out any -1's
-    if (d == -1) {
+    if (wind.offline) {
       return (-1);
     }
-    
-    s = wind.bucket[i].speed;
 
-    // Flag we have wind speed
-    if (s > 0) {
-      ws_zero = false;  
+    if (wind.moving) {
+      return (Wind_Degrees(wind.ns_sum, wind.ew_sum));
     }
-    r = (d * 71) / 4068.0;
-    
-    // North South Direction 
-    NS_vector_sum += cos(r) * s;
-    EW_vector_sum += sin(r) * s;
-  }
-  rtod = (atan2(EW_vector_sum, NS_vector_sum)*4068.0)/71.0;
-  if (rtod<0) {
-    rtod = 360 + rtod;
   }
 
   // If all the winds speeds are 0 then we return current wind direction or 0 on failure of that.
-  if (ws_zero) {
-    return (Wind_SampleDirection()); // Can return -1
-  }
-  else {
-    return (rtod);
-  }
+  // Read after SMP_LOCK is released, never hold it while waiting on the I2C bus.
+  return (Wind_SampleDirection()); // Can return -1
 }
 
 /* 
@@ -439,12 +1232,17 @@ int Wind_DirectionVector() {
  *=======================================================================================================================
  */
 float Wind_SpeedAverage() {
+  SMP_LOCK();
   float wind_speed = 0.0;
+  int n = 0;
   for (int i=0; i<WIND_READINGS; i++) {
-    // sum wind speeds for later average
-    wind_speed += wind.bucket[i].speed;
+    // sum valid wind speeds for later average
+    if (wind.bucket[i].valid) {
+      wind_speed += wind.bucket[i].speed;
+      n++;
+    }
   }
-  return( wind_speed / (float) WIND_READINGS);
+  return( (n) ? (wind_speed / (float) n) : 0.0);
 }
 
 /* 
@@ -467,140 +1265,266 @@ int Wind_GustDirection() {
 
 /* 
  *=======================================================================================================================
- * Wind_GustUpdate()
- *   Wind Gust = Highest 3 consecutive samples from the 60 samples. The 3 samples are then averaged.
- *   Wind Gust Direction = Average of the 3 Vectors from the Wind Gust samples.
- * 
+ * Wind_GustAdd() - Slide the gust window on to the next sub sample, keep the peak. Call with SMP_LOCK() held.
  *   Note: To handle the case of 2 or more gusts at the same speed but different directions
- *          Sstart with oldest reading and work forward to report most recent.
- * 
- *   Algorithm: 
- *     Start with oldest reading.
- *     Sum this reading with next 2.
- *     If greater than last, update last 
- * 
+ *         the later window replaces the peak to report the most recent.
  *=======================================================================================================================
  */
-void Wind_GustUpdate() {
-  int bucket = wind.bucket_idx; // Start at next bucket to fill (aka oldest reading)
-  float ws_sum = 0.0;
-  int ws_bucket = bucket;
-  float sum;
-
-  for (int i=0; i<(WIND_READINGS-2); i++) {  // subtract 2 because we are looking ahead at the next 2 buckets
-    // sum wind speeds 
-    sum = wind.bucket[bucket].speed +
-          wind.bucket[(bucket+1) % WIND_READINGS].speed +
-          wind.bucket[(bucket+2) % WIND_READINGS].speed;
-    if (sum >= ws_sum) {
-      ws_sum = sum;
-      ws_bucket = bucket;
-    }
-    bucket = (++bucket) % WIND_READINGS;
-  }
-  wind.gust = ws_sum/3;
-  
-  // Determine Gust Direction 
-  double NS_vector_sum = 0.0;
-  double EW_vector_sum = 0.0;
-  double r;
-  float s;
-  int d, i, rtod;
-  bool ws_zero = true;
-
-  bucket = ws_bucket;
-  for (i=0; i<3; i++) {
-    d = wind.bucket[bucket].direction;
-
-    // if at any time any wind direction readings is -1
-    // then the sensor was offline and we need to invalidate or data
-    // until it is clean with out any -1's
-    if (d == -1) {
-      ws_zero = true;
-      break;
-    }
-    
-    s = wind.bucket[bucket].speed;
+void Wind_GustAdd(bool valid, int raw, float speed) {
+  GUST_SAMPLE_STR *g = &gust.sample[gust.idx];
 
-    // Flag we have wind speed
-    if (s > 0) {
-      ws_zero = false;  
-    }
-    r = (d * 71) / 4068.0;
-    
-    // North South Direction 
-    NS_vector_sum += cos(r) * s;
-    EW_vector_sum += sin(r) * s;
+  // Take the oldest sample out of the window
+  if (g->valid) {
+    gust.nvalid--;
+    gust.offline -= (g->offline) ? 1 : 0;
+    gust.moving  -= (g->mm > 0) ? 1 : 0;
+    gust.mm_sum -= g->mm;
+    gust.ns_sum -= g->ns;
+    gust.ew_sum -= g->ew;
+  }
 
-    bucket = (++bucket) % WIND_READINGS;
+  g->valid = valid;
+  g->offline = (raw < 0);
+  g->mm = (valid) ? (int32_t) lround(speed * 1000.0) : 0;
+  g->ns = 0;
+  g->ew = 0;
+  if (valid) {
+    if (raw >= 0) {
+      Wind_Vector(raw, g->mm, &g->ns, &g->ew);
+    }
+    gust.nvalid++;
+    gust.offline += (g->offline) ? 1 : 0;
+    gust.moving  += (g->mm > 0) ? 1 : 0;
+    gust.mm_sum += g->mm;
+    gust.ns_sum += g->ns;
+    gust.ew_sum += g->ew;
   }
+  gust.idx = (gust.idx + 1) % gust.n;
+  gust.since++;
 
-  rtod = (atan2(EW_vector_sum, NS_vector_sum)*4068.0)/71.0;
-  if (rtod<0) {
-    rtod = 360 + rtod;
+  // A window of all sampled readings since the last observation
+  if ((gust.since >= (uint32_t) gust.n) && (gust.nvalid == gust.n) && (gust.mm_sum >= gust.peak)) {
+    gust.peak = gust.mm_sum;
+    // If all the winds speeds are 0 or we have a -1 direction then set -1 for direction.
+    gust.peak_direction = (gust.offline || (gust.moving == 0)) ? -1 : Wind_Degrees(gust.ns_sum, gust.ew_sum);
+    gust.peak_ts = Time.now();
   }
+}
+
+/* 
+ *=======================================================================================================================
+ * Wind_GustUpdate() - Take the peak gust since the last observation in to wind.gust, wind.gust_direction and 
+ *   wind.gust_ts. Called by OBS_Do(), starts the next interval.
+ *=======================================================================================================================
+ */
+void Wind_GustUpdate() {
+  SMP_LOCK();
 
-  // If all the winds speeds are 0 or we have a -1 direction then set -1 for direction.
-  if (ws_zero) {
+  if (gust.peak >= 0) {
+    wind.gust = gust.peak / (1000.0 * gust.n);
+    wind.gust_direction = gust.peak_direction;
+    wind.gust_ts = gust.peak_ts;
+  }
+  else {
+    // No window was sampled all the way through
+    wind.gust = 0.0;
     wind.gust_direction = -1;
+    wind.gust_ts = 0;
+  }
+  gust.peak = -1;
+  gust.since = 0;
+}
+
+/* 
+ *=======================================================================================================================
+ * Wind_SubSample() - Add a sub sample to the gust tracker and the current second, write the bucket when the
+ *   second is complete. Call with SMP_LOCK() held.
+ *=======================================================================================================================
+ */
+void Wind_SubSample(bool valid, int raw, float speed) {
+  Wind_GustAdd(valid, raw, speed);
+
+  if (valid) {
+    wind_sub_n++;
+    wind_sub_speed += speed;
+    if ((raw < 0) || (wind_sub_raw == -2)) {
+      wind_sub_raw = -2; // Offline at some point this second
+    }
+    else {
+      wind_sub_raw = raw;
+      wind_sub_ns += Wind_Sin(raw + WIND_QUARTER);
+      wind_sub_ew += Wind_Sin(raw);
+    }
+  }
+
+  if (++wind_sub < wind_hz) {
+    return;
+  }
+
+  if (wind_sub_n == 0) {
+    Wind_BucketSet(wind.bucket_idx, false, -1, 0.0);
+  }
+  else if (wind_sub_raw < 0) {
+    Wind_BucketSet(wind.bucket_idx, true, -1, wind_sub_speed / wind_sub_n);
   }
   else {
-    wind.gust_direction = rtod;
+    Wind_BucketSet(wind.bucket_idx, true, 
+      (wind_sub_n == 1) ? wind_sub_raw : Wind_Raw(wind_sub_ns, wind_sub_ew), wind_sub_speed / wind_sub_n);
+  }
+  wind.bucket_idx = (wind.bucket_idx+1) % WIND_READINGS; // Advance bucket index for next reading
+
+  wind_sub = 0;
+  wind_sub_n = 0;
+  wind_sub_speed = 0.0;
+  wind_sub_ns = 0;
+  wind_sub_ew = 0;
+  wind_sub_raw = -1;
+}
+
+/*
+ * ======================================================================================================================
+ * Wind_TakeReading() - Wind direction and speed, measure every sub sample. missed sub samples before it are 
+ *   left invalid.
+ * ======================================================================================================================
+ */
+void Wind_TakeReading(uint32_t missed) {
+  int raw = Wind_SampleRaw();
+  float speed = Wind_SampleSpeed();   // Over the missed sub samples too, so no rotations are lost
+
+  SMP_LOCK();
+  // More than a full ring of buckets and gust window missed is all the same
+  if (missed > (uint32_t) ((WIND_READINGS+1) * wind_hz)) {
+    missed = (WIND_READINGS+1) * wind_hz;
+  }
+  for (uint32_t i=0; i<missed; i++) {
+    Wind_SubSample(false, -1, 0.0);
   }
+  Wind_SubSample(true, raw, speed);
 }
 
 /*
  * ======================================================================================================================
- * Wind_TakeReading() - Wind direction and speed, measure every second             
+ * SMP_Thread() - Take the samples every SMP_PERIOD ms
  * ======================================================================================================================
  */
-void Wind_TakeReading() {
-  wind.bucket[wind.bucket_idx].direction = (int) Wind_SampleDirection();
-  wind.bucket[wind.bucket_idx].speed = Wind_SampleSpeed();
-  wind.bucket_idx = (++wind.bucket_idx) % WIND_READINGS; // Advance bucket index for next reading
+void SMP_Thread(void *param) {
+  system_tick_t wake = millis();
+  uint32_t period = SMP_PERIOD / wind_hz;
+  uint32_t missed;
+  int idx;
+
+  (void) param;
+  while (true) {
+    os_thread_delay_until(&wake, period);
+
+    // A whole period or more late, skip ahead and leave those samples invalid rather than sampling back to back
+    missed = (millis() - wake) / period;
+    wake += missed * period;
+    smp_missed += missed;
+    smp_samples++;
+
+    idx = wind.bucket_idx;
+    Wind_TakeReading(missed);
+
+    // Distance and air quality once a second, when a wind bucket is written. Late by a second or more one was
+    // written even if the buckets went all the way round to idx.
+    if ((wind.bucket_idx == idx) && (missed < (uint32_t) wind_hz)) {
+      continue;
+    }
+
+    if (A4_State == A4_STATE_DISTANCE) {
+      DistanceGauge_TakeReading(missed / wind_hz);
+    }
+
+    if (PM25AQI_exists) {
+      WIRE_LOCK();
+      pm25aqi_TakeReading();
+    }
+
+    Rain_TipsTake(&rain_tips[0]);
+    if (A4_State == A4_STATE_RAIN) {
+      Rain_TipsTake(&rain_tips[1]);
+    }
+  }
+}
+
+/* 
+ *=======================================================================================================================
+ * ADC_Thread() - Read the analog pins in use adc_hz times a second, decimate once a second
+ *=======================================================================================================================
+ */
+void ADC_Thread(void *param) {
+  system_tick_t wake = millis();
+  uint32_t period = 1000 / adc_hz;
+  uint32_t missed;
+  int tick = 0;
+
+  (void) param;
+  while (true) {
+    os_thread_delay_until(&wake, period);
+
+    // Late, skip the ticks missed, the second is decimated from those taken
+    missed = (millis() - wake) / period;
+    wake += missed * period;
+    tick += missed;
+
+    if ((A4_State == A4_STATE_DISTANCE) || (A4_State == A4_STATE_RAW)) {
+      ADC_Tick(ADC_A4);
+    }
+    if (A5_State == A5_STATE_RAW) {
+      ADC_Tick(ADC_A5);
+    }
+
+    if (++tick >= adc_hz) {
+      tick = 0;
+      for (int ch=0; ch<ADC_CHANNELS; ch++) {
+        ADC_Decimate(ch);
+      }
+    }
+  }
 }
 
 /* 
  *=======================================================================================================================
- * Wind_Distance_Air_Initialize()
+ * SMP_Start() - Mark all buckets invalid and start the sampler and ADC threads
  *=======================================================================================================================
  */
-void Wind_Distance_Air_Initialize() {
-  Output ("WindDist Init()");
+void SMP_Start() {
+  if (smp_thread != NULL) {
+    return;
+  }
+  Output ("SMP:Start");
 
-  // Clear windspeed counter  
-  anemometer_interrupt_count = 0;
-  anemometer_interrupt_stime = System.millis();
+  // Take windspeed pulses from now
+  Wind_SpeedReset();
   
   // Init default values.
+  wind_hz = (cf_wind_hz) ? cf_wind_hz : 1;
   wind.gust = 0.0;
   wind.gust_direction = -1;
+  wind.gust_ts = 0;
   wind.bucket_idx = 0;
-
-  // Take N 1s samples of wind speed and direction and fill arrays with values.
-  for (int i=0; i< WIND_READINGS; i++) {
-    lora_msg_poll(); // 750ms Second Delay
-    HeartBeat();     // Provides a 250ms delay
-    Wind_TakeReading();
-    if (A4_State == A4_STATE_DISTANCE) {
-      DistanceGauge_TakeReading();
-    }
-    if (PM25AQI_exists) {
-      pm25aqi_TakeReading();
-    }
-    if (SerialConsoleEnabled) Serial.print(".");  // Provide Serial Console some feedback as we loop and wait til next observation
-    OLED_spin();
+  wind.ns_sum = 0;
+  wind.ew_sum = 0;
+  wind.offline = 0;
+  wind.moving = 0;
+  for (int i=0; i<WIND_READINGS; i++) {
+    wind.bucket[i].valid = false;
   }
-
-  // Now we have N readings we can compute other wind related global varibles
-  Wind_TakeReading();
-  if (A4_State == A4_STATE_DISTANCE) {
-    DistanceGauge_TakeReading();
+  memset (&gust, 0, sizeof(gust));
+  gust.n = ((cf_wind_gust_secs) ? cf_wind_gust_secs : 3) * wind_hz;
+  if (gust.n > GUST_MAX) {
+    gust.n = GUST_MAX;
   }
+  gust.peak = -1;
+  Wind_Trig_Initialize();
+  DistanceGauge_Reset();
 
-  if (SerialConsoleEnabled) Serial.println();  // Send a newline out to cleanup after all the periods we have been logging
+  // Above loop() so a busy loop() does not delay the samples
+  smp_thread = new Thread("smp", SMP_Thread, NULL, OS_THREAD_PRIORITY_DEFAULT+1, 2*1024);
 
-  ws_refresh = false; // Set to false since we have just initialized wind speed data.
+  adc_hz = (cf_adc_hz) ? cf_adc_hz : 10;
+  adc_thread = new Thread("adc", ADC_Thread, NULL, OS_THREAD_PRIORITY_DEFAULT+1, 1024);
 }
 
 /*
@@ -609,6 +1533,7 @@ void Wind_Distance_Air_Initialize() {
  * ======================================================================================================================
  */
 void I2C_Check_Sensors() {
+  WIRE_LOCK();
 
   // BMX_1 Barometric Pressure 
   if (I2C_Device_Exist (BMX_ADDRESS_1)) {
@@ -0,0 +1,68 @@
+/*
+ * ======================================================================================================================
+ *  fmt_bench - Time of FMT_Fixed(), FMT_Int() and FMT_TimeStamp() against the printf they replaced
+ *
+ *  Usage: fmt_bench [calls]
+ *    Values are what a station reports, a few decimal places. Timestamps are a minute apart, as observations are.
+ *    The old timestamp is the sprintf() of Time.year() to Time.second() OBS_TimeStamp() did.
+ *    Times are on the host, use them to compare the two not as Argon/Boron times.
+ * ======================================================================================================================
+ */
+#include "FSM.cpp"
+#include <chrono>
+
+#define VALUES 1024
+
+float values[VALUES];
+int dps[VALUES];
+long ints[VALUES];
+
+/*
+ * ======================================================================================================================
+ * Old_TimeStamp() - OBS_TimeStamp() before FMT_TimeStamp()
+ * ======================================================================================================================
+ */
+void Old_TimeStamp(time32_t t, char *ts) {
+  sprintf (ts, "%d-%02d-%02dT%02d:%02d:%02d",
+    Time.year(t), Time.month(t), Time.day(t),
+    Time.hour(t), Time.minute(t), Time.second(t));
+}
+
+/*
+ * ======================================================================================================================
+ * Time_ns() - Average ns of each of n calls of f
+ * ======================================================================================================================
+ */
+template <typename F> double Time_ns(int n, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int k=0; k<n; k++) {
+    f(k);
+  }
+  return (std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n);
+}
+
+int main(int argc, char **argv) {
+  int n = (argc > 1) ? atoi(argv[1]) : 2000000;
+  volatile int sink = 0;
+  char buf[64];
+
+  srand(8);
+  for (int k=0; k<VALUES; k++) {
+    dps[k] = (k % 4) ? 1 : rand() % 5;
+    values[k] = (float) ((rand() % 2000001) - 500000) / 1000.0;
+    ints[k] = (rand() % 3) ? rand() % 360 : rand() % 100000;
+  }
+
+  printf("Format, %d calls, ns each\n", n);
+  double old_fixed = Time_ns(n, [&](int k) {
+    sink += snprintf(buf, sizeof(buf), "%.*f", dps[k % VALUES], values[k % VALUES]); });
+  double new_fixed = Time_ns(n, [&](int k) { sink += FMT_Fixed(buf, values[k % VALUES], dps[k % VALUES]) - buf; });
+  double old_int = Time_ns(n, [&](int k) { sink += snprintf(buf, sizeof(buf), "%ld", ints[k % VALUES]); });
+  double new_int = Time_ns(n, [&](int k) { sink += FMT_Int(buf, ints[k % VALUES]) - buf; });
+  double old_ts = Time_ns(n, [&](int k) { Old_TimeStamp(1752926400 + 60 * k, buf); sink += buf[18]; });
+  double new_ts = Time_ns(n, [&](int k) { FMT_TimeStamp(1752926400 + 60 * k, buf); sink += buf[18]; });
+  printf("  float      snprintf %8.1f  FMT_Fixed     %8.1f\n", old_fixed, new_fixed);
+  printf("  integer    snprintf %8.1f  FMT_Int       %8.1f\n", old_int, new_int);
+  printf("  timestamp  sprintf  %8.1f  FMT_TimeStamp %8.1f\n", old_ts, new_ts);
+  return (0);
+}
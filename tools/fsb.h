@@ -0,0 +1,186 @@
+/*
+ * ======================================================================================================================
+ *  fsb.h - Expand a batched observation event (FSB) back in to the FS observations it was made from
+ *
+ *  {"at":"2025-07-21T12:01:00","hth":16,"obs":[{"to":0,"css":80.1234,"bcs":3,...},{"to":60,"css":80.1234,...}]}
+ *
+ *  Each entry becomes {"at":"<at + to>","css":...,"hth":<entry hth, else header hth>,...} with the rest of its
+ *  members as sent, the same bytes OBS_Encode() makes for the FS event of that observation.
+ * ======================================================================================================================
+ */
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+typedef std::vector<std::pair<std::string, std::string>> FSB_MEMBERS;  // Name and value text as sent
+
+/*
+ * ======================================================================================================================
+ * FSB_Time() - Parse YYYY-MM-DDTHH:MM:SS (UTC) in to t, return false if not a time
+ * ======================================================================================================================
+ */
+bool FSB_Time(const std::string &iso, time_t *t) {
+  struct tm tm;
+
+  memset(&tm, 0, sizeof(tm));
+  if (sscanf(iso.c_str(), "%d-%d-%dT%d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+             &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
+    return (false);
+  }
+  tm.tm_year -= 1900;
+  tm.tm_mon -= 1;
+  *t = timegm(&tm);
+  return (true);
+}
+
+/*
+ * ======================================================================================================================
+ * FSB_Stamp() - Format t as YYYY-MM-DDTHH:MM:SS (UTC)
+ * ======================================================================================================================
+ */
+std::string FSB_Stamp(time_t t) {
+  char ts[32];
+  struct tm tm;
+
+  gmtime_r(&t, &tm);
+  strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", &tm);
+  return (ts);
+}
+
+/*
+ * ======================================================================================================================
+ * FSB_Value() - Return the text of the value at p (string with its quotes, number, or [..]/{..}), move p past it
+ * ======================================================================================================================
+ */
+std::string FSB_Value(const char *&p) {
+  const char *start = p;
+  int depth = 0;
+  bool str = false;
+
+  for (; *p; p++) {
+    if (str) {
+      if (*p == '\\' && p[1]) {
+        p++;
+      }
+      else if (*p == '"') {
+        str = false;
+      }
+    }
+    else if (*p == '"') {
+      str = true;
+    }
+    else if ((*p == '[') || (*p == '{')) {
+      depth++;
+    }
+    else if ((*p == ']') || (*p == '}')) {
+      if (depth == 0) {
+        break;
+      }
+      depth--;
+    }
+    else if ((*p == ',') && (depth == 0)) {
+      break;
+    }
+  }
+  return (std::string(start, p - start));
+}
+
+/*
+ * ======================================================================================================================
+ * FSB_Object() - Split the object at p in to its members, move p past the closing }. Return false if not an object.
+ * ======================================================================================================================
+ */
+bool FSB_Object(const char *&p, FSB_MEMBERS &m) {
+  const char *q;
+
+  m.clear();
+  if (*p++ != '{') {
+    return (false);
+  }
+  while (*p != '}') {
+    if (*p++ != '"' || (q = strchr(p, '"')) == NULL || q[1] != ':') {
+      return (false);
+    }
+    std::string name(p, q - p);
+    p = q + 2;
+    m.push_back(std::make_pair(name, FSB_Value(p)));
+    if (*p == ',') {
+      p++;
+    }
+    else if (*p != '}') {
+      return (false);
+    }
+  }
+  p++;
+  return (true);
+}
+
+/*
+ * ======================================================================================================================
+ * FSB_Expand() - Append the FS observation of each entry in FSB event data fsb to fs, return false if malformed
+ * ======================================================================================================================
+ */
+bool FSB_Expand(const char *fsb, std::vector<std::string> &fs) {
+  FSB_MEMBERS hdr, entry;
+  std::string at, hth, obs;
+  time_t base;
+  const char *p = fsb;
+
+  if (!FSB_Object(p, hdr)) {
+    return (false);
+  }
+  for (auto &m : hdr) {
+    if (m.first == "at") at = m.second;
+    if (m.first == "hth") hth = m.second;
+    if (m.first == "obs") obs = m.second;
+  }
+  if ((at.size() < 2) || !FSB_Time(at.substr(1, at.size()-2), &base) || hth.empty() || obs.empty() || (obs[0] != '[')) {
+    return (false);
+  }
+
+  p = obs.c_str() + 1;
+  while (*p != ']') {
+    if (!FSB_Object(p, entry) || entry.empty() || (entry[0].first != "to")) {
+      return (false);
+    }
+
+    std::string ehth = hth;
+    for (auto &m : entry) {
+      if (m.first == "hth") ehth = m.second;
+    }
+
+    // Members in OBS_Encode() order, at, css, hth then the sensors
+    std::string line = "{\"at\":\"" + FSB_Stamp(base + atol(entry[0].second.c_str())) + "\"";
+    bool health = false;
+    for (size_t i=1; i<entry.size(); i++) {
+      if (entry[i].first == "hth") {
+        continue;
+      }
+      if (!health && (entry[i].first != "css")) {
+        line += ",\"hth\":" + ehth;
+        health = true;
+      }
+      line += ",\"" + entry[i].first + "\":" + entry[i].second;
+      if (!health && (entry[i].first == "css")) {
+        line += ",\"hth\":" + ehth;
+        health = true;
+      }
+    }
+    if (!health) {
+      line += ",\"hth\":" + ehth;
+    }
+    fs.push_back(line + "}");
+
+    if (*p == ',') {
+      p++;
+    }
+    else if (*p != ']') {
+      return (false);
+    }
+  }
+  return (true);
+}
@@ -0,0 +1,64 @@
+/*
+ * ======================================================================================================================
+ *  fsb_expand - Expand FSB event data in to FS observations, one JSON object per line
+ *
+ *  Usage: fsb_expand [file ...]
+ *    Each input line is the data of one FSB event, reads stdin when no files are given.
+ *    Exits 1 if any line does not expand.
+ * ======================================================================================================================
+ */
+#include "fsb.h"
+
+/*
+ * ======================================================================================================================
+ * Expand() - Expand every line of fp, return false if any line is bad
+ * ======================================================================================================================
+ */
+bool Expand(FILE *fp, const char *name) {
+  std::vector<std::string> fs;
+  char *line = NULL;
+  size_t cap = 0;
+  ssize_t n;
+  int lineno = 0;
+  bool ok = true;
+
+  while ((n = getline(&line, &cap, fp)) >= 0) {
+    lineno++;
+    while ((n > 0) && ((line[n-1] == '\n') || (line[n-1] == '\r'))) {
+      line[--n] = 0;
+    }
+    if (n == 0) {
+      continue;
+    }
+    fs.clear();
+    if (!FSB_Expand(line, fs)) {
+      fprintf(stderr, "%s:%d: not a FSB event\n", name, lineno);
+      ok = false;
+      continue;
+    }
+    for (auto &obs : fs) {
+      puts(obs.c_str());
+    }
+  }
+  free(line);
+  return (ok);
+}
+
+int main(int argc, char **argv) {
+  bool ok = true;
+
+  if (argc < 2) {
+    return (Expand(stdin, "stdin") ? 0 : 1);
+  }
+  for (int i=1; i<argc; i++) {
+    FILE *fp = fopen(argv[i], "r");
+    if (fp == NULL) {
+      perror(argv[i]);
+      ok = false;
+      continue;
+    }
+    ok = Expand(fp, argv[i]) && ok;
+    fclose(fp);
+  }
+  return (ok ? 0 : 1);
+}
@@ -0,0 +1,230 @@
+/*
+ * ======================================================================================================================
+ *  fsx.h - Decode binary observation records (FSX) in to the FS JSON of each observation
+ *
+ *  The record layout is in src/OBS.h, Binary observations. A record starts with the OBS_SCHEMA_ID it was made
+ *  with, fsx_schemas[] has the tag, type and decimal places of every schema so old records in a N2S backlog
+ *  still decode after the firmware is updated. When obs_schema[] changes add its table here,
+ *  tools/test/test_fsx checks the table for the current OBS_SCHEMA_ID against obs_schema[].
+ *
+ *  The JSON is what OBS_Encode() writes for the observation with three exceptions
+ *    A F_OBS value that rounds to zero is 0.0, JSON from the station keeps the sign (-0.0)
+ *    A F_OBS value that was NaN or out of range is null
+ *    Every sensor in the record is written, OBS_Encode() drops the ones past the end of its buffer
+ * ======================================================================================================================
+ */
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+typedef struct {
+  std::string   id;                    // Observation tag name
+  char          type;                  // F, I or U, the OBS_TYPE
+  int           dp;                    // Decimal places F values were scaled by
+} FSX_TAG;
+
+typedef struct {
+  int           schema_id;             // OBS_SCHEMA_ID
+  const char    *tags;                 // "tag:<type><dp> ..." in obs_schema[] order
+} FSX_SCHEMA_STR;
+
+const FSX_SCHEMA_STR fsx_schemas[] = {
+  {1,
+    "bcs:I0 bpc:F1 cfr:I0 rg:F1 rgt:F1 rgp:F1 ws:F1 wd:I0 wg:F1 wgd:I0 "
+    "bp1:F1 bt1:F1 bh1:F1 bp2:F1 bt2:F1 bh2:F1 hh1:F1 ht1:F1 st1:F1 sh1:F1 "
+    "st2:F1 sh2:F1 hdt1:F1 hdh1:F1 hdt2:F1 hdh2:F1 lpt1:F1 lpp1:F1 lpt2:F1 lpp2:F1 "
+    "ht2:F1 hh2:F1 sv1:F1 si1:F1 su1:F1 mt1:F1 mt2:F1 gt1:F1 gt2:F1 vlx:F1 "
+    "blx:F1 sg:F1 a4r:F1 rg2:F1 rgt2:F1 rgp2:F1 a5r:F1 pm1s10:I0 pm1s25:I0 pm1s100:I0 "
+    "pm1e10:I0 pm1e25:I0 pm1e100:I0 hi:F1 wbt:F1 wbgt:F1 tlww:F1 tlwt:F1 tsme25:F1 tsmec:F1 "
+    "tsmvwc:F1 tsmt:F1 tmsms1:F1 tmsms2:F1 tmsms3:F1 tmsms4:F1 tmsmt1:F1 tmsmt2:F1 pmts:F1 "
+  },
+  {2,
+    "bcs:I0 bpc:F1 cfr:I0 rg:F1 rgt:F1 rgp:F1 ws:F1 wd:I0 wg:F1 wgd:I0 "
+    "wgt:U0 bp1:F1 bt1:F1 bh1:F1 bp2:F1 bt2:F1 bh2:F1 hh1:F1 ht1:F1 st1:F1 "
+    "sh1:F1 st2:F1 sh2:F1 hdt1:F1 hdh1:F1 hdt2:F1 hdh2:F1 lpt1:F1 lpp1:F1 lpt2:F1 "
+    "lpp2:F1 ht2:F1 hh2:F1 sv1:F1 si1:F1 su1:F1 mt1:F1 mt2:F1 gt1:F1 gt2:F1 "
+    "vlx:F1 blx:F1 sg:F1 a4r:F1 rg2:F1 rgt2:F1 rgp2:F1 a5r:F1 pm1s10:I0 pm1s25:I0 "
+    "pm1s100:I0 pm1e10:I0 pm1e25:I0 pm1e100:I0 hi:F1 wbt:F1 wbgt:F1 tlww:F1 tlwt:F1 tsme25:F1 "
+    "tsmec:F1 tsmvwc:F1 tsmt:F1 tmsms1:F1 tmsms2:F1 tmsms3:F1 tmsms4:F1 tmsmt1:F1 tmsmt2:F1 pmts:F1 "
+  },
+  {3,
+    "bcs:I0 bpc:F1 cfr:I0 rg:F1 rgt:F1 rgp:F1 rgr:F1 rgi:F1 rgf:U0 rgl:U0 "
+    "ws:F1 wd:I0 wg:F1 wgd:I0 wgt:U0 bp1:F1 bt1:F1 bh1:F1 bp2:F1 bt2:F1 "
+    "bh2:F1 hh1:F1 ht1:F1 st1:F1 sh1:F1 st2:F1 sh2:F1 hdt1:F1 hdh1:F1 hdt2:F1 "
+    "hdh2:F1 lpt1:F1 lpp1:F1 lpt2:F1 lpp2:F1 ht2:F1 hh2:F1 sv1:F1 si1:F1 su1:F1 "
+    "mt1:F1 mt2:F1 gt1:F1 gt2:F1 vlx:F1 blx:F1 sg:F1 a4r:F1 rg2:F1 rgt2:F1 "
+    "rgp2:F1 rgr2:F1 rgi2:F1 rgf2:U0 rgl2:U0 a5r:F1 pm1s10:I0 pm1s25:I0 pm1s100:I0 pm1e10:I0 "
+    "pm1e25:I0 pm1e100:I0 hi:F1 wbt:F1 wbgt:F1 tlww:F1 tlwt:F1 tsme25:F1 tsmec:F1 tsmvwc:F1 "
+    "tsmt:F1 tmsms1:F1 tmsms2:F1 tmsms3:F1 tmsms4:F1 tmsmt1:F1 tmsmt2:F1 pmts:F1 "
+  },
+  {4,
+    "bcs:I0 bpc:F1 cfr:I0 rg:F1 rgt:F1 rgp:F1 rgr:F1 rgi:F1 rgf:U0 rgl:U0 "
+    "ws:F1 wd:I0 wg:F1 wgd:I0 wgt:U0 bp1:F1 bt1:F1 bh1:F1 bp2:F1 bt2:F1 "
+    "bh2:F1 hh1:F1 ht1:F1 st1:F1 sh1:F1 st2:F1 sh2:F1 hdt1:F1 hdh1:F1 hdt2:F1 "
+    "hdh2:F1 lpt1:F1 lpp1:F1 lpt2:F1 lpp2:F1 ht2:F1 hh2:F1 sv1:F1 si1:F1 su1:F1 "
+    "mt1:F1 mt2:F1 gt1:F1 gt2:F1 vlx:F1 blx:F1 sg:F1 sgmn:F1 sgmx:F1 a4r:F1 "
+    "rg2:F1 rgt2:F1 rgp2:F1 rgr2:F1 rgi2:F1 rgf2:U0 rgl2:U0 a5r:F1 pm1s10:I0 pm1s25:I0 "
+    "pm1s100:I0 pm1e10:I0 pm1e25:I0 pm1e100:I0 hi:F1 wbt:F1 wbgt:F1 tlww:F1 tlwt:F1 tsme25:F1 "
+    "tsmec:F1 tsmvwc:F1 tsmt:F1 tmsms1:F1 tmsms2:F1 tmsms3:F1 tmsms4:F1 tmsmt1:F1 tmsmt2:F1 pmts:F1 "
+  }
+};
+#define FSX_SCHEMA_CNT (sizeof(fsx_schemas) / sizeof(fsx_schemas[0]))
+
+/*
+ * ======================================================================================================================
+ * FSX_Schema() - Load the tags of schema id in to tags, return false if the schema is not known
+ * ======================================================================================================================
+ */
+bool FSX_Schema(int id, std::vector<FSX_TAG> &tags) {
+  char name[16];
+  char type;
+  int dp, n;
+
+  tags.clear();
+  for (size_t k=0; k<FSX_SCHEMA_CNT; k++) {
+    if (fsx_schemas[k].schema_id != id) {
+      continue;
+    }
+    for (const char *p = fsx_schemas[k].tags; sscanf(p, " %15[^:]:%c%d%n", name, &type, &dp, &n) == 3; p += n) {
+      tags.push_back({name, type, dp});
+    }
+    return (true);
+  }
+  return (false);
+}
+
+/*
+ * ======================================================================================================================
+ * FSX_Base64() - Decode base64 text in to out, stop at the end of the text or a comma. Return false if not base64.
+ * ======================================================================================================================
+ */
+bool FSX_Base64(const char *in, std::vector<uint8_t> &out) {
+  uint32_t bits = 0;
+  int nbits = 0;
+  const char *c;
+  static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  out.clear();
+  for (; *in && (*in != ',') && (*in != '='); in++) {
+    if ((c = strchr(b64, *in)) == NULL) {
+      return (false);
+    }
+    bits = (bits << 6) | (c - b64);
+    nbits += 6;
+    if (nbits >= 8) {
+      nbits -= 8;
+      out.push_back((bits >> nbits) & 0xFF);
+    }
+  }
+  return (true);
+}
+
+/*
+ * ======================================================================================================================
+ * FSX_Varint() - Read a varint at p in to v, return false if it runs past end
+ * ======================================================================================================================
+ */
+bool FSX_Varint(const uint8_t *&p, const uint8_t *end, uint32_t *v) {
+  *v = 0;
+  for (int shift=0; (p < end) && (shift < 35); shift += 7) {
+    *v |= (uint32_t) (*p & 0x7F) << shift;
+    if ((*p++ & 0x80) == 0) {
+      return (true);
+    }
+  }
+  return (false);
+}
+
+/*
+ * ======================================================================================================================
+ * FSX_Unzigzag() - Undo OBS_Bin_Zigzag()
+ * ======================================================================================================================
+ */
+int32_t FSX_Unzigzag(uint32_t v) {
+  return ((int32_t) ((v >> 1) ^ (0U - (v & 1))));
+}
+
+/*
+ * ======================================================================================================================
+ * FSX_Fixed() - A value scaled by 10^dp as text with dp decimal places, null for INT32_MIN
+ * ======================================================================================================================
+ */
+std::string FSX_Fixed(int32_t v, int dp) {
+  char s[24];
+  uint32_t pow10 = 1;
+  uint32_t u = (v < 0) ? (0U - (uint32_t) v) : (uint32_t) v;
+
+  if (v == INT32_MIN) {
+    return ("null");
+  }
+  for (int i=0; i<dp; i++) {
+    pow10 *= 10;
+  }
+  if (dp) {
+    snprintf(s, sizeof(s), "%s%u.%0*u", (v < 0) ? "-" : "", u / pow10, dp, u % pow10);
+  }
+  else {
+    snprintf(s, sizeof(s), "%d", v);
+  }
+  return (s);
+}
+
+/*
+ * ======================================================================================================================
+ * FSX_Decode() - Append the FS JSON of each record in the n bytes at p to fs, return false if malformed
+ * ======================================================================================================================
+ */
+bool FSX_Decode(const uint8_t *p, size_t n, std::vector<std::string> &fs) {
+  const uint8_t *end = p + n;
+  std::vector<FSX_TAG> tags;
+  uint32_t v, hth;
+  time_t ts;
+  char at[32];
+  struct tm tm;
+
+  while (p < end) {
+    if (!FSX_Schema(*p++, tags) || ((end - p) < 4)) {
+      return (false);
+    }
+    ts = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+    p += 4;
+    gmtime_r(&ts, &tm);
+    strftime(at, sizeof(at), "%Y-%m-%dT%H:%M:%S", &tm);
+    std::string line = std::string("{\"at\":\"") + at + "\"";
+
+    if (!FSX_Varint(p, end, &v)) {
+      return (false);
+    }
+    line += ",\"css\":" + FSX_Fixed(FSX_Unzigzag(v), 4);
+    if (!FSX_Varint(p, end, &hth)) {
+      return (false);
+    }
+    line += ",\"hth\":" + std::to_string((int32_t) hth);  // The station writes hth as an int
+
+    const uint8_t *bitmap = p;
+    p += (tags.size() + 7) / 8;
+    if (p > end) {
+      return (false);
+    }
+    for (size_t s=0; s<tags.size(); s++) {
+      if ((bitmap[s>>3] & (1 << (s&7))) == 0) {
+        continue;
+      }
+      if (!FSX_Varint(p, end, &v)) {
+        return (false);
+      }
+      line += ",\"" + tags[s].id + "\":";
+      switch (tags[s].type) {
+        case 'F' : line += FSX_Fixed(FSX_Unzigzag(v), tags[s].dp); break;
+        case 'I' : line += std::to_string(FSX_Unzigzag(v)); break;
+        default  : line += std::to_string((int32_t) v); break;  // U_OBS, the station writes it as an int
+      }
+    }
+    fs.push_back(line + "}");
+  }
+  return (true);
+}
@@ -0,0 +1,65 @@
+/*
+ * ======================================================================================================================
+ *  fsx_decode - Decode FSX event data in to FS observations, one JSON object per line
+ *
+ *  Usage: fsx_decode [file ...]
+ *    Each input line is the base64 data of one FSX event, or a N2S line (base64 then ",FSX"). Reads stdin when
+ *    no files are given. Exits 1 if any line does not decode.
+ * ======================================================================================================================
+ */
+#include "fsx.h"
+
+/*
+ * ======================================================================================================================
+ * Decode() - Decode every line of fp, return false if any line is bad
+ * ======================================================================================================================
+ */
+bool Decode(FILE *fp, const char *name) {
+  std::vector<std::string> fs;
+  std::vector<uint8_t> bin;
+  char *line = NULL;
+  size_t cap = 0;
+  ssize_t n;
+  int lineno = 0;
+  bool ok = true;
+
+  while ((n = getline(&line, &cap, fp)) >= 0) {
+    lineno++;
+    while ((n > 0) && ((line[n-1] == '\n') || (line[n-1] == '\r'))) {
+      line[--n] = 0;
+    }
+    if (n == 0) {
+      continue;
+    }
+    fs.clear();
+    if (!FSX_Base64(line, bin) || !FSX_Decode(bin.data(), bin.size(), fs)) {
+      fprintf(stderr, "%s:%d: not a FSX event\n", name, lineno);
+      ok = false;
+      continue;
+    }
+    for (auto &obs : fs) {
+      puts(obs.c_str());
+    }
+  }
+  free(line);
+  return (ok);
+}
+
+int main(int argc, char **argv) {
+  bool ok = true;
+
+  if (argc < 2) {
+    return (Decode(stdin, "stdin") ? 0 : 1);
+  }
+  for (int i=1; i<argc; i++) {
+    FILE *fp = fopen(argv[i], "r");
+    if (fp == NULL) {
+      perror(argv[i]);
+      ok = false;
+      continue;
+    }
+    ok = Decode(fp, argv[i]) && ok;
+    fclose(fp);
+  }
+  return (ok ? 0 : 1);
+}
@@ -0,0 +1,117 @@
+/*
+ * ======================================================================================================================
+ *  n2s.h - Read the lines of a N2S segment file, text or sealed (n2s_compress=1)
+ *
+ *  The block format is in src/N2S.h, Sealed segments. A sealed segment starts with 0xA5, a text segment is
+ *  lines ending in \r\n. Each line is "<data>,<Particle Event Type>" as SD_NeedToSend_Add() was given it.
+ * ======================================================================================================================
+ */
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define N2S_LZ_MAGIC        0xA5        // First byte of a block
+#define N2S_LZ_HDR_SIZE     4           // Magic, lines, len
+#define N2S_LZ_MIN          4           // Shortest copy
+
+/*
+ * ======================================================================================================================
+ * N2S_Get16() - 2 byte little endian value at p
+ * ======================================================================================================================
+ */
+uint16_t N2S_Get16(const uint8_t *p) {
+  return (p[0] | (p[1] << 8));
+}
+
+/*
+ * ======================================================================================================================
+ * N2S_Block() - Append the lines of the block payload at p to lines, return false if it does not decode
+ * ======================================================================================================================
+ */
+bool N2S_Block(const uint8_t *p, size_t len, int nrec, std::vector<std::string> &lines) {
+  const uint8_t *end = p + len;
+  std::string win;                      // Previous line followed by this line
+  size_t plen = 0;
+
+  for (int rec=0; rec<nrec; rec++) {
+    if ((end - p) < 2) {
+      return (false);
+    }
+    size_t rlen = N2S_Get16(p);
+    p += 2;
+    while (win.size() < (plen + rlen)) {
+      if (p >= end) {
+        return (false);
+      }
+      if (*p & 0x80) {
+        size_t n = (*p & 0x7F) + N2S_LZ_MIN;
+        if ((end - p) < 3) {
+          return (false);
+        }
+        size_t src = N2S_Get16(p+1);
+        p += 3;
+        if ((src >= win.size()) || ((win.size() + n) > (plen + rlen))) {
+          return (false);
+        }
+        while (n--) {
+          win += win[src++];            // Byte at a time, a copy can overlap what it is making
+        }
+      }
+      else {
+        size_t n = *p++ + 1;
+        if ((n > (size_t) (end - p)) || ((win.size() + n) > (plen + rlen))) {
+          return (false);
+        }
+        win.append((const char *) p, n);
+        p += n;
+      }
+    }
+    win.erase(0, plen);                 // This line becomes the previous line
+    plen = rlen;
+    lines.push_back(win);
+  }
+  return (p == end);
+}
+
+/*
+ * ======================================================================================================================
+ * N2S_Decode() - Append the lines of the segment file contents at p to lines, return false if malformed
+ * ======================================================================================================================
+ */
+bool N2S_Decode(const uint8_t *p, size_t n, std::vector<std::string> &lines) {
+  const uint8_t *end = p + n;
+
+  if ((n == 0) || (*p != N2S_LZ_MAGIC)) {
+    // Text
+    while (p < end) {
+      const uint8_t *nl = (const uint8_t *) memchr(p, '\n', end - p);
+      if (nl == NULL) {
+        return (false);                 // Partial line, lost power while writing it
+      }
+      size_t len = nl - p;
+      if ((len > 0) && (p[len-1] == '\r')) {
+        len--;
+      }
+      lines.push_back(std::string((const char *) p, len));
+      p = nl + 1;
+    }
+    return (true);
+  }
+
+  while (p < end) {
+    if (((end - p) < N2S_LZ_HDR_SIZE) || (p[0] != N2S_LZ_MAGIC) || (p[1] == 0)) {
+      return (false);
+    }
+    int nrec = p[1];
+    size_t len = N2S_Get16(p+2);
+    p += N2S_LZ_HDR_SIZE;
+    if (((size_t) (end - p) < len + 2) || (N2S_Get16(p+len) != len) || !N2S_Block(p, len, nrec, lines)) {
+      return (false);
+    }
+    p += len + 2;
+  }
+  return (true);
+}
@@ -0,0 +1,127 @@
+/*
+ * ======================================================================================================================
+ *  n2s_bench - Time to read the lines of a N2S segment, N2S_Reader_Line() against the byte at a time loop before it
+ *
+ *  Usage: n2s_bench [lines]
+ *    The segment is a file of FS JSON lines of a typical station in a temporary directory, read through the
+ *    mock File. It is unbuffered, every read() is a read of the host file the way every SdFat call is a trip
+ *    through the card's block cache, so the calls per line carry over to Argon/Boron and the times do not.
+ * ======================================================================================================================
+ */
+#include "FSM.cpp"
+#include <chrono>
+
+const int station[] = {
+  OBS_BCS, OBS_BPC, OBS_CFR, OBS_RG, OBS_RGT, OBS_RGP, OBS_WS, OBS_WD, OBS_WG, OBS_WGD, OBS_WGT, OBS_BP1,
+  OBS_BT1, OBS_BH1, OBS_HH1, OBS_HT1, OBS_ST1, OBS_SH1, OBS_MT1, OBS_SV1, OBS_SI1, OBS_SU1, OBS_HI, OBS_WBT
+};
+#define STATION_CNT (int) (sizeof(station) / sizeof(station[0]))
+
+char old_msgbuf[MAX_MSGBUF_SIZE];
+int old_calls;
+
+/*
+ * ======================================================================================================================
+ * Segment_Fill() - Write n lines to segment file name, return the bytes written
+ * ======================================================================================================================
+ */
+uint32_t Segment_Fill(const char *name, int n) {
+  File fp = SD.open(name, FILE_WRITE);
+  uint32_t bytes = 0;
+
+  for (int k=0; k<n; k++) {
+    OBS_Init();
+    int i = OBS_Open();
+    obs[i].inuse = true;
+    obs[i].ts = 1752926400 + 60 * k;
+    obs[i].css = 80.1234;
+    obs[i].hth = 16;
+    for (int s=0; s<STATION_CNT; s++) {
+      float v = 10 + ((k + s) % 50) / 10.0;
+      switch (obs_schema[station[s]].type) {
+        case F_OBS : OBS_SetF(i, station[s], v); break;
+        case I_OBS : OBS_SetI(i, station[s], (int) v); break;
+        case U_OBS : OBS_SetU(i, station[s], (unsigned long) v); break;
+      }
+    }
+    OBS_Encode(i);
+    bytes += fp.write(obs_enc.buf, obs_enc.len);
+    bytes += fp.write(",FS\r\n", 5);
+  }
+  fp.close();
+  return (bytes);
+}
+
+/*
+ * ======================================================================================================================
+ * Old_Line() - Next line the way SD_N2S_Publish() read it before N2S_Reader_Line(), NULL at end of file
+ * ======================================================================================================================
+ */
+char *Old_Line(File &fp) {
+  char ch;
+  int i = 0;
+
+  while (fp.available() && (i < MAX_MSGBUF_SIZE)) {
+    ch = fp.read();
+    old_calls += 2;  // available() and read() a byte
+    if (ch == 0x0A) {  // newline
+      return (old_msgbuf);
+    }
+    else if (ch == 0x0D) { // CR, LF follows
+      old_msgbuf[i] = 0;
+    }
+    else {
+      old_msgbuf[i++] = ch;
+    }
+  }
+  return (NULL);
+}
+
+int main(int argc, char **argv) {
+  int n = (argc > 1) ? atoi(argv[1]) : 2000;
+  char dir[] = "/tmp/n2s_bench.XXXXXX";
+  volatile int sink = 0;
+  uint32_t next;
+  char *line;
+  int lines;
+
+  OBS_Alloc();
+  if (mkdtemp(dir) == NULL) {
+    perror("mkdtemp");
+    return (1);
+  }
+  mock_sd_root = dir;
+  uint32_t bytes = Segment_Fill("SEGMENT.LOG", n);
+
+  printf("Read a segment of %d lines, %lu bytes, %d bytes/line\n", n, (unsigned long) bytes, (int) (bytes / n));
+
+  File fp = SD.open("SEGMENT.LOG", FILE_READ);
+  old_calls = 0;
+  lines = 0;
+  auto start = std::chrono::steady_clock::now();
+  while ((line = Old_Line(fp)) != NULL) {
+    sink += line[0];
+    lines++;
+  }
+  double old_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  int old_lines = lines;
+
+  int new_calls = 0;
+  lines = 0;
+  start = std::chrono::steady_clock::now();
+  N2S_Reader_Start(&fp, 0);
+  while ((line = N2S_Reader_Line(&next)) != NULL) {
+    sink += line[0];
+    lines++;
+  }
+  double new_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  new_calls = (bytes + N2S_BLOCK_SIZE - 1) / N2S_BLOCK_SIZE + 1;  // A block a read(), and the one at the end
+  fp.close();
+
+  printf("  byte at a time     %6d lines  %8.1f File calls/line  %9.1f ns/line\n", old_lines,
+    (double) old_calls / old_lines, old_ns / old_lines);
+  printf("  N2S_Reader_Line()  %6d lines  %8.1f File calls/line  %9.1f ns/line\n", lines,
+    (double) new_calls / lines, new_ns / lines);
+  system((std::string("rm -rf ") + dir).c_str());
+  return (((old_lines == n) && (lines == n)) ? 0 : 1);
+}
@@ -0,0 +1,45 @@
+/*
+ * ======================================================================================================================
+ *  n2s_read - Print the lines of N2S segment files from the SD card, text or sealed (n2s_compress=1)
+ *
+ *  Usage: n2s_read file ...
+ *    Each line is "<data>,<Particle Event Type>". Pipe the ",FSX" lines through fsx_decode for JSON.
+ *    Exits 1 if any file does not decode, the lines before the bad block are still printed.
+ * ======================================================================================================================
+ */
+#include "n2s.h"
+
+int main(int argc, char **argv) {
+  bool ok = true;
+
+  if (argc < 2) {
+    fprintf(stderr, "Usage: n2s_read file ...\n");
+    return (1);
+  }
+  for (int i=1; i<argc; i++) {
+    std::vector<std::string> lines;
+    std::vector<uint8_t> seg;
+    uint8_t buf[4096];
+    size_t n;
+
+    FILE *fp = fopen(argv[i], "rb");
+    if (fp == NULL) {
+      perror(argv[i]);
+      ok = false;
+      continue;
+    }
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+      seg.insert(seg.end(), buf, buf + n);
+    }
+    fclose(fp);
+
+    if (!N2S_Decode(seg.data(), seg.size(), lines)) {
+      fprintf(stderr, "%s: bad segment after %d lines\n", argv[i], (int) lines.size());
+      ok = false;
+    }
+    for (auto &line : lines) {
+      puts(line.c_str());
+    }
+  }
+  return (ok ? 0 : 1);
+}
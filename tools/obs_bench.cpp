@@ -0,0 +1,158 @@
+/*
+ * ======================================================================================================================
+ *  obs_bench - RAM and build time of a one minute observation, SENSOR layout before the schema against obs[] now
+ *
+ *  Usage: obs_bench [observations]
+ *    Sizes are for Argon/Boron (32 bit ARM, 64 bit time_t), the old layout is rebuilt here with those type sizes.
+ *    Build time is storing the 24 values of a typical station in to a cleared slot, then that plus the FS JSON.
+ *    The old JSON is printf per member as JSONBufferWriter did it, the new is OBS_Encode().
+ *    Times are on the host, use them to compare the layouts not as Argon/Boron times.
+ * ======================================================================================================================
+ */
+#include "FSM.cpp"
+#include <chrono>
+
+#define OLD_MAX_SENSORS     96
+#define OLD_MAX_OBS         17
+
+typedef struct {
+  char          id[6];
+  int32_t       type;
+  float         f_obs;
+  int32_t       i_obs;
+  uint32_t      u_obs;                  // unsigned long
+  bool          inuse;
+} OLD_SENSOR;
+
+typedef struct {
+  bool          inuse;
+  int64_t       ts;                     // time_t
+  float         css;
+  uint32_t      hth;                    // unsigned long
+  OLD_SENSOR    sensor[OLD_MAX_SENSORS];
+} OLD_OBS;
+
+typedef struct {                        // OBSERVATION_STR with Argon/Boron type sizes
+  bool          inuse;
+  int32_t       ts;
+  float         css;
+  uint32_t      hth;
+  uint32_t      present[OBS_PRESENT_WORDS];
+  OBS_VALUE     value[OBS_SCHEMA_CNT];
+} ARM_OBS;
+
+OLD_OBS old_obs[OLD_MAX_OBS];
+char old_json[MAX_MSGBUF_SIZE];
+
+const int station[] = {
+  OBS_BCS, OBS_BPC, OBS_CFR, OBS_RG, OBS_RGT, OBS_RGP, OBS_WS, OBS_WD, OBS_WG, OBS_WGD, OBS_WGT, OBS_BP1,
+  OBS_BT1, OBS_BH1, OBS_HH1, OBS_HT1, OBS_ST1, OBS_SH1, OBS_MT1, OBS_SV1, OBS_SI1, OBS_SU1, OBS_HI, OBS_WBT
+};
+#define STATION_CNT (int) (sizeof(station) / sizeof(station[0]))
+
+/*
+ * ======================================================================================================================
+ * Old_Build() - Store an observation the way OBS_Do() did before the schema, return the JSON length or 0
+ * ======================================================================================================================
+ */
+int Old_Build(int i, int k, bool json) {
+  OLD_OBS *o = &old_obs[i];
+  int n;
+
+  o->inuse = false;
+  for (int s=0; s<OLD_MAX_SENSORS; s++) {
+    o->sensor[s].inuse = false;
+  }
+  o->inuse = true;
+  o->ts = 1752926400 + 60 * k;
+  o->css = 80.1234;
+  o->hth = 16;
+  for (int s=0; s<STATION_CNT; s++) {
+    OLD_SENSOR *p = &o->sensor[s];
+    strncpy (p->id, obs_schema[station[s]].id, sizeof(p->id));  // strcpy() ran in to the padding with 7 characters
+    p->type = obs_schema[station[s]].type;
+    p->f_obs = p->i_obs = p->u_obs = 10 + ((k + s) % 50) / 10.0;
+    p->inuse = true;
+  }
+  if (!json) {
+    return (0);
+  }
+
+  char ts[32];
+  FMT_TimeStamp(o->ts, ts);
+  n = snprintf(old_json, sizeof(old_json), "{\"at\":\"%s\",\"css\":%.*f,\"hth\":%d", ts, 4, o->css, (int) o->hth);
+  for (int s=0; s<OLD_MAX_SENSORS; s++) {
+    OLD_SENSOR *p = &o->sensor[s];
+    if (p->inuse) {
+      switch (p->type) {
+        case F_OBS : n += snprintf(old_json+n, sizeof(old_json)-n, ",\"%.6s\":%.*f", p->id, 1, p->f_obs); break;
+        case I_OBS : n += snprintf(old_json+n, sizeof(old_json)-n, ",\"%.6s\":%d", p->id, (int) p->i_obs); break;
+        case U_OBS : n += snprintf(old_json+n, sizeof(old_json)-n, ",\"%.6s\":%d", p->id, (int) p->u_obs); break;
+      }
+    }
+  }
+  n += snprintf(old_json+n, sizeof(old_json)-n, "}");
+  return (n);
+}
+
+/*
+ * ======================================================================================================================
+ * New_Build() - Store an observation with OBS_SetF/I/U() in to obs[], return the JSON length or 0
+ * ======================================================================================================================
+ */
+int New_Build(int k, bool json) {
+  int i = OBS_Open();
+  int n;
+
+  obs[i].inuse = true;
+  obs[i].ts = 1752926400 + 60 * k;
+  obs[i].css = 80.1234;
+  obs[i].hth = 16;
+  for (int s=0; s<STATION_CNT; s++) {
+    float v = 10 + ((k + s) % 50) / 10.0;
+    switch (obs_schema[station[s]].type) {
+      case F_OBS : OBS_SetF(i, station[s], v); break;
+      case I_OBS : OBS_SetI(i, station[s], (int) v); break;
+      case U_OBS : OBS_SetU(i, station[s], (unsigned long) v); break;
+    }
+  }
+  n = (json && OBS_Encode(i)) ? obs_enc.len : 0;
+  OBS_Dequeue();  // Keep the queue from spilling to N2S
+  return (n);
+}
+
+/*
+ * ======================================================================================================================
+ * Time_ns() - Average ns of each of n calls of f
+ * ======================================================================================================================
+ */
+template <typename F> double Time_ns(int n, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int k=0; k<n; k++) {
+    f(k);
+  }
+  return (std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n);
+}
+
+int main(int argc, char **argv) {
+  int n = (argc > 1) ? atoi(argv[1]) : 200000;
+  volatile int sink = 0;
+
+  OBS_Alloc();
+
+  printf("RAM (Argon/Boron sizes)\n");
+  printf("  old  %5d bytes/minute  %3d minutes  %6d bytes\n", (int) sizeof(OLD_OBS), OLD_MAX_OBS,
+    (int) sizeof(OLD_OBS) * OLD_MAX_OBS);
+  printf("  new  %5d bytes/minute  %3d minutes  %6d bytes  (%d bytes/minute on this host)\n", (int) sizeof(ARM_OBS),
+    MAX_ONE_MINUTE_OBS, (int) sizeof(ARM_OBS) * MAX_ONE_MINUTE_OBS, (int) sizeof(OBSERVATION_STR));
+  printf("  new  %5d minutes in the RAM the old layout used\n", (int) (sizeof(OLD_OBS) * OLD_MAX_OBS / sizeof(ARM_OBS)));
+
+  printf("Build, %d sensors, %d observations, ns each\n", STATION_CNT, n);
+  double old_store = Time_ns(n, [&](int k) { sink += Old_Build(k % OLD_MAX_OBS, k, false); });
+  double new_store = Time_ns(n, [&](int k) { sink += New_Build(k, false); });
+  double old_json = Time_ns(n, [&](int k) { sink += Old_Build(k % OLD_MAX_OBS, k, true); });
+  double new_json = Time_ns(n, [&](int k) { sink += New_Build(k, true); });
+  printf("  store         old %8.1f  new %8.1f\n", old_store, new_store);
+  printf("  store + JSON  old %8.1f  new %8.1f\n", old_json, new_json);
+  return (0);
+}
@@ -0,0 +1,3 @@
+#pragma once
+#include "Stub.h"
+struct AB1805 : Stub { template<class...A> AB1805(A...) {} };
@@ -0,0 +1,4 @@
+#pragma once
+#include "Stub.h"
+struct AES : Stub { template<class...A> AES(A...) {} };
+#define N_BLOCK 16
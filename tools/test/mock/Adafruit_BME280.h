@@ -0,0 +1,3 @@
+#pragma once
+#include "Stub.h"
+struct Adafruit_BME280 : Stub { template<class...A> Adafruit_BME280(A...) {} };
@@ -0,0 +1,3 @@
+#pragma once
+#include "Stub.h"
+struct Adafruit_BMP280 : Stub { template<class...A> Adafruit_BMP280(A...) {} };
@@ -0,0 +1,3 @@
+#pragma once
+#include "Stub.h"
+struct Adafruit_BMP3XX : Stub { template<class...A> Adafruit_BMP3XX(A...) {} };
@@ -0,0 +1,4 @@
+#pragma once
+#include "Stub.h"
+struct Adafruit_HDC302x : Stub { template<class...A> Adafruit_HDC302x(A...) {} };
+enum { TRIGGERMODE_LP0 };
@@ -0,0 +1,4 @@
+#pragma once
+#include "Stub.h"
+struct Adafruit_HTU21DF : Stub { template<class...A> Adafruit_HTU21DF(A...) {} };
+#define HTU21DF_I2CADDR 0x40
@@ -0,0 +1,3 @@
+#pragma once
+#include "Stub.h"
+struct Adafruit_LPS35HW : Stub { template<class...A> Adafruit_LPS35HW(A...) {} };
@@ -0,0 +1,3 @@
+#pragma once
+#include "Stub.h"
+struct Adafruit_MCP9808 : Stub { template<class...A> Adafruit_MCP9808(A...) {} };
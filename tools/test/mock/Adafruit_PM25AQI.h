@@ -0,0 +1,4 @@
+#pragma once
+#include "Stub.h"
+struct Adafruit_PM25AQI : Stub { template<class...A> Adafruit_PM25AQI(A...) {} };
+typedef struct { uint16_t framelen, pm10_standard, pm25_standard, pm100_standard, pm10_env, pm25_env, pm100_env, particles_03um, particles_05um, particles_10um, particles_25um, particles_50um, particles_100um, unused, checksum; } PM25_AQI_Data;
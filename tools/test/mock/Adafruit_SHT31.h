@@ -0,0 +1,3 @@
+#pragma once
+#include "Stub.h"
+struct Adafruit_SHT31 : Stub { template<class...A> Adafruit_SHT31(A...) {} };
@@ -0,0 +1,4 @@
+#pragma once
+#include "Stub.h"
+struct Adafruit_SI1145 : Stub { template<class...A> Adafruit_SI1145(A...) {} };
+#define SI1145_ADDR 0x60
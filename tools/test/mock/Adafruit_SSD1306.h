@@ -0,0 +1,10 @@
+#pragma once
+#include "Stub.h"
+struct Adafruit_SSD1306 : Stub { template<class...A> Adafruit_SSD1306(A...) {} };
+#define SSD1306_SWITCHCAPVCC 2
+#define SSD1306_WHITE 1
+#define SSD1306_BLACK 0
+#define WHITE 1
+#define BLACK 0
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
@@ -0,0 +1,4 @@
+#pragma once
+#include "Stub.h"
+struct Adafruit_VEML7700 : Stub { template<class...A> Adafruit_VEML7700(A...) {} };
+enum { VEML_LUX_AUTO };
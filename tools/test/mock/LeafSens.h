@@ -0,0 +1,4 @@
+#pragma once
+#include "Stub.h"
+struct LeafSens : Stub { template<class...A> LeafSens(A...) {} };
+struct SVCS3 : Stub { template<class...A> SVCS3(A...) {} };
@@ -0,0 +1,238 @@
+/*
+ * ======================================================================================================================
+ *  Particle.h - Host mock of the Device OS API, enough to build FSM.cpp for the tools/ tests
+ *
+ *  Time, System.millis(), EEPROM and Particle.publish() work, see mock.cpp. Hardware is not there,
+ *  sensors read 0 and I2C finds nothing.
+ * ======================================================================================================================
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <time.h>
+#include <stdarg.h>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+typedef uint8_t byte; typedef bool boolean; typedef int32_t time32_t; typedef uint32_t system_tick_t;
+#define PLATFORM_ARGON 12
+#define PLATFORM_BORON 13
+#define PLATFORM_MSOM 35
+#define PRODUCT_VERSION(x) int __pv = x
+#define SYSTEM_THREAD(x) int __st
+#define SYSTEM_MODE(x) int __sm
+#define STARTUP(x) int __su
+#define F(x) ((const __FlashStringHelper*)(x))
+class __FlashStringHelper;
+typedef const char* PGM_P;
+#define PSTR(x) x
+#define pgm_read_byte(x) (*(const uint8_t*)(x))
+#define strlen_P strlen
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define INPUT_PULLDOWN 3
+#define FALLING 2
+#define RISING 3
+#define CHANGE 4
+enum { D0,D1,D2,D3,D4,D5,D6,D7,D8,D9,D10,D11,D12,D13,D14,D15,D16,D17,D18,D19,D20,D21,D22,D23,D24,D25,D26,D27,PWR,CHG,BATT,A0=100,A1,A2,A3,A4,A5,A6,A7,MISO,MOSI,SCK,RX,TX,SS };
+#define PRIVATE 0
+#define PUBLIC 1
+#define WITH_ACK 2
+#define NO_ACK 4
+#define WLAN_SEC_UNSEC 0
+#define WLAN_SEC_WEP 1
+#define WLAN_SEC_WPA 2
+#define WLAN_SEC_WPA2 3
+#define WLAN_SEC_WPA_ENTERPRISE 4
+#define WLAN_SEC_WPA2_ENTERPRISE 5
+enum { BATTERY_STATE_UNKNOWN, BATTERY_STATE_NOT_CHARGING, BATTERY_STATE_CHARGING, BATTERY_STATE_CHARGED, BATTERY_STATE_DISCHARGING, BATTERY_STATE_FAULT, BATTERY_STATE_DISCONNECTED };
+enum { POWER_SOURCE_UNKNOWN, POWER_SOURCE_VIN, POWER_SOURCE_USB_HOST, POWER_SOURCE_USB_ADAPTER, POWER_SOURCE_USB_OTG, POWER_SOURCE_BATTERY };
+enum { INTERNAL_SIM=1, EXTERNAL_SIM=2 };
+enum { RESP_OK=1 };
+enum { FEATURE_RESET_INFO=1 };
+enum { RESET_REASON_NONE=0 , RESET_REASON_UNKNOWN, RESET_REASON_PIN_RESET, RESET_REASON_POWER_MANAGEMENT, RESET_REASON_POWER_DOWN, RESET_REASON_POWER_BROWNOUT, RESET_REASON_WATCHDOG, RESET_REASON_UPDATE, RESET_REASON_UPDATE_ERROR, RESET_REASON_UPDATE_TIMEOUT, RESET_REASON_FACTORY_RESET, RESET_REASON_SAFE_MODE, RESET_REASON_DFU_MODE, RESET_REASON_PANIC, RESET_REASON_USER, RESET_REASON_CONFIG_UPDATE};
+enum { MSBFIRST, LSBFIRST, SPI_MODE0 };
+struct SPISettings { SPISettings(...) {} SPISettings() {} };
+class String {
+ public:
+  char b[256];
+  String() { b[0]=0; }
+  String(const char *s) { strncpy(b,s?s:"",255); b[255]=0; }
+  String(char c) { b[0]=c; b[1]=0; }
+  String(int v) { snprintf(b,256,"%d",v); }
+  String(unsigned v) { snprintf(b,256,"%u",v); }
+  String(long v) { snprintf(b,256,"%ld",v); }
+  String(unsigned long v) { snprintf(b,256,"%lu",v); }
+  String(double v, int d=2) { snprintf(b,256,"%.*f",d,v); }
+  const char *c_str() const { return b; }
+  operator const char*() const { return b; }
+  void reserve(unsigned) {}
+  unsigned length() const { return strlen(b); }
+  String &operator+=(const String &s) { strncat(b,s.b,255-strlen(b)); return *this; }
+  String operator+(const String &s) const { String r(*this); r+=s; return r; }
+  friend String operator+(const char *a, const String &s) { String r(a); r+=s; return r; }
+  bool operator==(const char *s) const { return strcmp(b,s)==0; }
+  bool operator==(const String &s) const { return strcmp(b,s.b)==0; }
+  bool operator!=(const char *s) const { return strcmp(b,s)!=0; }
+  bool equals(const char *s) const { return strcmp(b,s)==0; }
+  bool equalsIgnoreCase(const char *s) const { return strcasecmp(b,s)==0; }
+  void toUpperCase() {} void toLowerCase() {} void trim() {}
+  int indexOf(const char *) const { return -1; }
+  int indexOf(char) const { return -1; }
+  String substring(int, int=0) const { return *this; }
+  bool startsWith(const char*) const { return false; }
+  long toInt() const { return atol(b); }
+  float toFloat() const { return atof(b); }
+  char charAt(int i) const { return b[i]; }
+  char operator[](int i) const { return b[i]; }
+  static String format(const char *fmt, ...) { return String(fmt); }
+  void getBytes(unsigned char *buf, unsigned len) const { strncpy((char*)buf,b,len); }
+  void toCharArray(char *buf, unsigned len) const { strncpy(buf,b,len); }
+};
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(const uint8_t*, size_t n) { return n; }
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const char *s) { return write((const uint8_t *) s, strlen(s)); }
+  size_t print(const char *s) { return write(s); }
+  size_t print(const String &s) { return write(s.c_str()); }
+  size_t print(char c) { return write((uint8_t) c); }
+  size_t print(int v) { return print((long) v); }
+  size_t print(unsigned v) { return print((unsigned long) v); }
+  size_t print(long v) { char b[24]; snprintf(b, sizeof(b), "%ld", v); return write(b); }
+  size_t print(unsigned long v) { char b[24]; snprintf(b, sizeof(b), "%lu", v); return write(b); }
+  size_t print(double v, int d=2) { char b[48]; snprintf(b, sizeof(b), "%.*f", d, v); return write(b); }
+  template<class T> size_t print(T) { return 0; }
+  template<class T> size_t print(T, int) { return 0; }
+  size_t println() { return write("\r\n"); }
+  template<class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+  template<class T> size_t println(T v, int d) { size_t n = print(v, d); return n + println(); }
+  size_t printf(const char*, ...) { return 0; }
+  void flush() {}
+};
+class Stream : public Print { public: size_t readBytesUntil(char, char*, size_t) { return 0; } size_t readBytes(char*, size_t) { return 0; }  int available() { return 0; } int read() { return -1; } int peek() { return -1; } };
+extern bool mock_serial;             // Echo Serial to stdout
+class USBSerial : public Stream { public: using Print::write; size_t write(const uint8_t *b, size_t n) override { if (mock_serial) fwrite(b, 1, n, stdout); return n; } void begin(int=0) {} bool isConnected() { return true; } operator bool() { return true; } };
+extern USBSerial Serial; extern USBSerial Serial1;
+class IPAddress { public: String toString() const { return String(); } operator bool() const { return true; } uint8_t operator[](int) const { return 0; } };
+class TwoWire : public Stream {
+ public:
+  void begin() {} void end() {} void setSpeed(int) {} void setClock(int) {}
+  void beginTransmission(int) {} uint8_t endTransmission(bool=true) { return 0; }
+  uint8_t requestFrom(int, int, bool=true) { return 0; }
+  size_t write(uint8_t) { return 0; } size_t write(const uint8_t*, size_t) { return 0; }
+  bool lock() { return true; } bool unlock() { return true; } bool isEnabled() { return true; }
+};
+extern TwoWire Wire;
+class SPIClass { public: void begin(int=0) {} void beginTransaction(SPISettings) {} void endTransaction() {} uint8_t transfer(uint8_t) { return 0; } };
+extern SPIClass SPI; extern SPIClass SPI1;
+extern time32_t mock_now;            // Time.now()
+extern uint64_t mock_millis;         // System.millis(), each call moves it on 1 ms
+extern uint32_t mock_free;           // System.freeMemory()
+extern bool mock_publish_ok;         // What Particle.publish() acks
+extern std::vector<std::string> mock_events;  // "event data" of each publish acked
+inline struct tm mock_tm(time32_t t) { time_t tt = t; struct tm r; gmtime_r(&tt, &r); return r; }
+struct TimeClass {
+  time32_t now() { return mock_now; }
+  int year(time32_t t) { return mock_tm(t).tm_year + 1900; } int month(time32_t t) { return mock_tm(t).tm_mon + 1; } int day(time32_t t) { return mock_tm(t).tm_mday; }
+  int hour(time32_t t) { return mock_tm(t).tm_hour; } int minute(time32_t t) { return mock_tm(t).tm_min; } int second(time32_t t) { return mock_tm(t).tm_sec; } int weekday(time32_t t) { return mock_tm(t).tm_wday + 1; }
+  int year() { return year(mock_now); } int month() { return month(mock_now); } int day() { return day(mock_now); }
+  int hour() { return hour(mock_now); } int minute() { return minute(mock_now); } int second() { return second(mock_now); } int weekday() { return weekday(mock_now); }
+  bool isValid() { return true; } void setTime(time32_t) {} void setFormat(int) {} void zone(float) {}
+  String format(time32_t, const char* = 0) { return String(); } String timeStr(time32_t=0) { return String(); }
+  time32_t local() { return 0; }
+};
+extern TimeClass Time;
+#define TIME_FORMAT_ISO8601_FULL 1
+class SystemPowerConfiguration { public: SystemPowerConfiguration &powerSourceMaxCurrent(int) { return *this; } SystemPowerConfiguration &powerSourceMinVoltage(int) { return *this; } SystemPowerConfiguration &batteryChargeCurrent(int) { return *this; } SystemPowerConfiguration &batteryChargeVoltage(int) { return *this; } template<class T> SystemPowerConfiguration &feature(T) { return *this; } SystemPowerConfiguration &interruptPin(int) { return *this; } SystemPowerConfiguration &chargeCurrentHigh(int) { return *this; } SystemPowerConfiguration &socBitPrecision(int) { return *this; } SystemPowerConfiguration &auxiliaryPowerControlPin(int,int=0) { return *this; } bool isFeatureSet(int) const { return false; } SystemPowerConfiguration &clearFeature(int) { return *this; } };
+namespace particle { template<class T> class Future { public: Future(T v=T()) : v(v) {} bool isDone() const { return true; } bool isSucceeded() const { return v; } T result() const { return v; } operator T() const { return v; } bool wait(int=0) { return true; } T v; }; }
+struct SystemClass {
+  uint64_t millis() { return mock_millis++; } unsigned uptime() { return 0; } int batteryState() { return 0; } float batteryCharge() { return 0; } int powerSource() { return 0; }
+  void reset() {} int resetReason() { return 0; } uint32_t resetReasonData() { return 0; } String deviceID() { return String(); } String version() { return String(); }
+  uint32_t freeMemory() { return mock_free; } void enableFeature(int) {} int setPowerConfiguration(SystemPowerConfiguration) { return 0; } SystemPowerConfiguration getPowerConfiguration() { return SystemPowerConfiguration(); }
+  uint32_t ticks() { return 0; } uint32_t ticksPerMicrosecond() { return 1; }
+};
+extern SystemClass System;
+class CloudDisconnectOptions { public: CloudDisconnectOptions &graceful(bool) { return *this; } template<class T> CloudDisconnectOptions &timeout(T) { return *this; } };
+struct ParticleClass {
+  bool connected() { return true; } bool disconnected() { return false; } void connect() {} void disconnect(...) {} void syncTime() {} void process() {}
+  particle::Future<bool> publish(const char *e, const char *d, int=0) { mock_millis += 1000; /* Ack takes a second, earns the next token */ if (mock_publish_ok) mock_events.push_back(std::string(e) + " " + d); return particle::Future<bool>(mock_publish_ok); }
+  particle::Future<bool> publish(const char *e, const String &d, int=0) { return publish(e, d.c_str()); }
+  template<class F> bool function(const char*, F) { return true; }
+  template<class V> bool variable(const char*, V) { return true; }
+  void setDisconnectOptions(CloudDisconnectOptions) {}
+  size_t maxEventDataSize() { return 1024; }
+};
+extern ParticleClass Particle;
+class CellularSignal { public: float getStrength() { return 0; } float getQuality() { return 0; } int getAccessTechnology() { return 0; } };
+class WiFiSignal { public: float getStrength() { return 0; } float getQuality() { return 0; } };
+struct CellularClass { CellularSignal RSSI() { return CellularSignal(); } void on() {} void off() {} bool isOff() { return false; } bool isOn() { return true; } void disconnect() {} bool ready() { return true; } void setActiveSim(int) {} int getActiveSim() { return 0; } void setCredentials(...) {} void clearCredentials() {} template<class...A> int command(A...) { return 0; } };
+extern CellularClass Cellular;
+class WiFiAccessPoint { public: char ssid[33]; int ssidLength; uint8_t bssid[6]; int security; int channel; int cipher; int rssi; };
+struct WiFiClass { WiFiSignal RSSI() { return WiFiSignal(); } void on() {} void off() {} void connect() {} void disconnect() {} bool ready() { return true; } bool setCredentials(...) { return true; } bool clearCredentials() { return true; } int getCredentials(WiFiAccessPoint*, int) { return 0; } uint8_t *macAddress(uint8_t *m) { return m; } uint8_t *BSSID(uint8_t *m) { return m; } const char *SSID() { return ""; } IPAddress localIP() { return IPAddress(); } IPAddress subnetMask() { return IPAddress(); } IPAddress gatewayIP() { return IPAddress(); } IPAddress dnsServerIP() { return IPAddress(); } IPAddress dhcpServerIP() { return IPAddress(); } bool hasCredentials() { return true; } };
+extern WiFiClass WiFi;
+struct EEPROMClass { uint8_t m[4096]; template<class T> void put(int a, const T &v) { memcpy(m+a, &v, sizeof(T)); } template<class T> void get(int a, T &v) { memcpy(&v, m+a, sizeof(T)); } size_t length() { return sizeof(m); } uint8_t read(int a) { return m[a]; } void write(int a, uint8_t v) { m[a] = v; } };
+extern EEPROMClass EEPROM;
+class PMIC { public: PMIC(bool=false) {} uint8_t getFault() { return 0; } bool disableBATFET() { return true; } bool enableBATFET() { return true; } };
+struct WatchdogConfiguration { template<class T> WatchdogConfiguration &timeout(T) { return *this; } WatchdogConfiguration &capabilities(int) { return *this; } };
+struct WatchdogClass { int init(WatchdogConfiguration) { return 0; } int start() { return 0; } int refresh() { return 0; } };
+extern WatchdogClass Watchdog;
+class JSONBufferWriter {
+ public:
+  JSONBufferWriter(char *b, size_t n) : buf(b), n(n), sz(0) {}
+  JSONBufferWriter &beginObject() { return *this; } JSONBufferWriter &endObject() { return *this; }
+  JSONBufferWriter &beginArray() { return *this; } JSONBufferWriter &endArray() { return *this; }
+  JSONBufferWriter &name(const char*) { return *this; }
+  JSONBufferWriter &value(bool) { return *this; } JSONBufferWriter &value(int) { return *this; } JSONBufferWriter &value(unsigned) { return *this; }
+  JSONBufferWriter &value(long) { return *this; } JSONBufferWriter &value(unsigned long) { return *this; }
+  JSONBufferWriter &value(double, int=5) { return *this; } JSONBufferWriter &value(float, int=5) { return *this; }
+  JSONBufferWriter &value(const char*) { return *this; } JSONBufferWriter &value(const String&) { return *this; }
+  JSONBufferWriter &nullValue() { return *this; }
+  char *buffer() const { return buf; } size_t bufferSize() const { return n; } size_t dataSize() const { return sz; }
+  char *buf; size_t n; size_t sz;
+};
+class Thread { public: Thread() {} Thread(const char*, std::function<void()>, int=0, size_t=0) {} Thread(const char*, void (*)(void*), void*, int=0, size_t=0) {} bool isValid() { return true; } };
+#define OS_THREAD_PRIORITY_DEFAULT 2
+class Mutex { public: void lock() {} void unlock() {} bool trylock() { return true; } };
+class RecursiveMutex : public Mutex {};
+template<class L> class LockGuard { public: LockGuard(L&) {} };
+#define WITH_LOCK(x) if (true)
+#define ATOMIC_BLOCK() if (true)
+#define SINGLE_THREADED_BLOCK() if (true)
+class Timer { public: Timer(unsigned, void (*)(), bool=false) {} template<class C> Timer(unsigned, void (C::*)(), C&, bool=false) {} void start() {} void stop() {} void changePeriod(unsigned) {} bool isActive() { return true; } };
+typedef void *os_thread_t;
+inline int os_thread_delay_until(system_tick_t*, system_tick_t) { return 0; }
+inline void os_thread_yield() {}
+class Base64 { public: static bool encode(const uint8_t*, size_t, char*, size_t&) { return true; } static size_t getEncodedSize(size_t n, bool=true) { return n*2; } };
+
+void pinMode(int,int); int digitalRead(int); void digitalWrite(int,int); int analogRead(int); void analogWrite(int,int,int=0);
+void delay(unsigned); void delayMicroseconds(unsigned); unsigned long millis(); unsigned long micros();
+void attachInterrupt(int, void(*)(), int); void detachInterrupt(int); void interrupts(); void noInterrupts();
+template<class T> T constrain(T a, T l, T h) { return a<l?l:a>h?h:a; }
+long random(long); long random(long, long); void randomSeed(unsigned);
+#define bitRead(v,b) (((v)>>(b))&1)
+#define lowByte(w) ((uint8_t)((w)&0xff))
+#define highByte(w) ((uint8_t)((w)>>8))
+#define DEG_TO_RAD 0.017453292519943295
+#define RAD_TO_DEG 57.29577951308232
+#define Serial_ Serial
+typedef uint16_t word;
+typedef uint16_t pin_t;
+typedef int SimType;
+enum { TYPE_UNKNOWN=0, TYPE_OK, TYPE_ERROR, WAIT=-2 };
+#include <chrono>
+using namespace std::chrono_literals;
+#define waitFor(f, t) (f())
+enum class SystemPowerFeature { PMIC_DETECTION, USE_VIN_SETTINGS_WITH_USB_HOST, DISABLE, DISABLE_CHARGING };
+enum { WEP=1, WPA, WPA2, WPA_ENTERPRISE, WPA2_ENTERPRISE };
+#define waitUntil(f) (f())
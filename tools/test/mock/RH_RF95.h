@@ -0,0 +1,6 @@
+#pragma once
+#include "Stub.h"
+struct RH_RF95 : Stub { template<class...A> RH_RF95(A...) {} };
+#define RH_RF95_MAX_MESSAGE_LEN 251
+struct RHHardwareSPI { RHHardwareSPI(...) {} };
+extern RHHardwareSPI hardware_spi;
@@ -0,0 +1,6 @@
+#pragma once
+#include "Stub.h"
+struct DateTime { DateTime(...) {} uint32_t unixtime() const { return 0; } int year() const { return 0; } int month() const { return 0; } int day() const { return 0; } int hour() const { return 0; } int minute() const { return 0; } int second() const { return 0; } };
+struct RTC_PCF8523 : Stub { DateTime now() { return DateTime(); } template<class...A> RTC_PCF8523(A...) {} };
+#define PCF8523_OFF 0
+#define PCF8523_ADDRESS 0x68
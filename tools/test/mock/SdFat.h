@@ -0,0 +1,87 @@
+/*
+ * ======================================================================================================================
+ *  SdFat.h - Host mock of SdFat, files are kept under mock_sd_root on the host
+ * ======================================================================================================================
+ */
+#pragma once
+#include "Particle.h"
+#include <memory>
+#include <unistd.h>
+#include <sys/stat.h>
+#define O_RDONLY 0
+#define O_READ 0
+#define O_WRONLY 1
+#define O_RDWR 2
+#define O_CREAT 0x10
+#define O_APPEND 0x20
+#define O_TRUNC 0x40
+#define O_AT_END 0x80
+#define FILE_READ O_RDONLY
+#define FILE_WRITE (O_RDWR|O_CREAT|O_AT_END)
+#define SD_SCK_MHZ(x) (x)
+#define SHARED_SPI 0
+struct SdSpiConfig { SdSpiConfig(...) {} };
+
+extern std::string mock_sd_root;    // Host directory the card is in
+inline std::string mock_sd_path(const char *p) { return mock_sd_root + ((*p == '/') ? "" : "/") + p; }
+
+class File : public Stream {
+ public:
+  std::shared_ptr<FILE> f;
+  using Print::write;
+  bool open(const char *p, int flags=0) {
+    std::string path = mock_sd_path(p);
+    FILE *fp = NULL;
+    if (flags & O_TRUNC) {
+      fp = fopen(path.c_str(), "w+b");
+    }
+    else if (flags & (O_WRONLY|O_RDWR)) {
+      if (((fp = fopen(path.c_str(), "r+b")) == NULL) && (flags & O_CREAT)) {
+        fp = fopen(path.c_str(), "w+b");
+      }
+    }
+    else {
+      fp = fopen(path.c_str(), "rb");
+    }
+    if (fp == NULL) {
+      return (false);
+    }
+    setvbuf(fp, NULL, _IONBF, 0);   // Several handles can be open on one file
+    f.reset(fp, fclose);
+    if (flags & O_AT_END) {
+      fseek(fp, 0, SEEK_END);
+    }
+    return (true);
+  }
+  bool close() { f.reset(); return true; }
+  operator bool() const { return (bool) f; } bool isOpen() const { return (bool) f; }
+  uint32_t position() { return f ? ftell(f.get()) : 0; }
+  uint32_t size() { struct stat st; return (f && (fstat(fileno(f.get()), &st) == 0)) ? st.st_size : 0; }
+  uint32_t fileSize() { return size(); }
+  int available() { return size() - position(); }
+  int read() { int c = f ? fgetc(f.get()) : -1; return (c == EOF) ? -1 : c; }
+  int read(void *b, size_t n) { return f ? (int) fread(b, 1, n, f.get()) : -1; }
+  int peek() { int c = read(); if (c >= 0) seekCur(-1); return c; }
+  bool seek(uint32_t p) { return f && (fseek(f.get(), p, SEEK_SET) == 0); }
+  bool seekSet(uint32_t p) { return seek(p); }
+  bool seekEnd(int32_t o=0) { return f && (fseek(f.get(), o, SEEK_END) == 0); }
+  bool seekCur(int32_t o) { return f && (fseek(f.get(), o, SEEK_CUR) == 0); }
+  size_t write(const uint8_t *b, size_t n) override { return f ? fwrite(b, 1, n, f.get()) : 0; }
+  size_t write(const void *b, size_t n) { return write((const uint8_t *) b, n); }
+  bool sync() { return (bool) f; } void flush() {}
+  bool truncate(uint64_t n) { return f && (ftruncate(fileno(f.get()), n) == 0) && seek(n); }
+  bool preAllocate(uint64_t) { return true; }
+  bool rename(const char*) { return false; } bool remove() { return false; }
+  bool isDir() { return false; } File openNextFile(int=0) { return File(); } bool getName(char*, size_t) { return false; } bool isContiguous() { return true; } void rewindDirectory() {} bool openNext(File*, int=0) { return false; } bool isHidden() { return false; } bool isFile() { return true; }
+};
+
+class SdFat {
+ public:
+  bool begin(...) { return true; }
+  bool exists(const char *p) { return access(mock_sd_path(p).c_str(), F_OK) == 0; }
+  File open(const char *p, int flags=0) { File fp; fp.open(p, flags); return fp; }
+  bool mkdir(const char *p, bool=true) { return (::mkdir(mock_sd_path(p).c_str(), 0755) == 0) || exists(p); }
+  bool remove(const char *p) { return unlink(mock_sd_path(p).c_str()) == 0; }
+  bool rename(const char *a, const char *b) { return ::rename(mock_sd_path(a).c_str(), mock_sd_path(b).c_str()) == 0; }
+  bool rmdir(const char *p) { return ::rmdir(mock_sd_path(p).c_str()) == 0; }
+};
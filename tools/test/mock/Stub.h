@@ -0,0 +1,14 @@
+#pragma once
+#include "Particle.h"
+#define M(n) template<class...A> float n(A...) { return 0; }
+struct Stub {
+  M(begin) M(init) M(readPressure) M(readTemperature) M(readHumidity) M(readTempC) M(readIR) M(readUV) M(readVisible) M(readLux)
+  M(getTemp) M(getWet) M(getEC) M(getVWC) M(getE25) M(newReading) M(setup) M(resetConfig) M(setRtcFromSystem) M(isRTCSet)
+  M(setFrequency) M(setTxPower) M(setPromiscuous) M(setThisAddress) M(setHeaderFrom) M(setModeRx) M(sleep) M(available) M(recv) M(headerFlags) M(headerFrom) M(headerId) M(headerTo) M(lastRssi)
+  M(adjust) M(clearAlarm) M(disableAlarm) M(writeSqwPinMode) M(getRtcAsTime) M(getRtcAsTm) M(enableBATFET) M(disableBATFET)
+  M(setKey) M(set_key) M(encrypt) M(decrypt) M(do_aes_encrypt) M(do_aes_decrypt) M(cbc_decrypt) M(cbc_encrypt) M(get_size) M(set_IV) M(get_IV) M(clean) M(padPlaintext) M(setWaveform)
+  M(clearDisplay) M(display) M(setTextSize) M(setTextColor) M(setCursor) M(print) M(println) M(write) M(setRotation) M(fillRect) M(drawPixel) M(setTextWrap) M(cp437) M(setup_r)
+  M(setSampling) M(setTemperatureOversampling) M(setPressureOversampling) M(setIIRFilterCoeff) M(setOutputDataRate) M(performReading) M(sensorID) M(setGain) M(setIntegrationTime) M(resetPressure) M(setDataRate)
+  M(heater) M(isHeaterEnabled) M(readTemperatureHumidityOnDemand) M(getData) M(setResolution) M(wake) M(shutdown) M(getHumidity) M(ssd1306_command) M(begin_I2C) M(read) M(iv_inc) M(send) M(waitPacketSent) M(setSpreadingFactor) M(setSignalBandwidth) M(setCodingRate4) M(setPreambleLength) M(getTemperature) M(getPressure)
+};
+#undef M
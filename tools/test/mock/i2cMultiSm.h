@@ -0,0 +1,5 @@
+#pragma once
+#include "Stub.h"
+struct i2cMultiSm : Stub { template<class...A> i2cMultiSm(A...) {} };
+typedef struct { float vwc[4]; float temp[2]; } soil_ret_t;
+struct SVMULTI : Stub { template<class...A> SVMULTI(A...) {} };
@@ -0,0 +1,8 @@
+#pragma once
+#include "Stub.h"
+struct LocationPoint { int fix; double latitude, longitude, altitude; int satsInUse; };
+enum class LocationResults { Fixed, Unavailable, Idle };
+struct LocationConfiguration { template<class...A> LocationConfiguration &enableAntennaPower(A...) { return *this; } };
+struct LocationClass : Stub { template<class...A> LocationResults getLocation(A...) { return LocationResults::Fixed; } };
+extern LocationClass Location;
+#define GNSS_ANT_PWR 0
@@ -0,0 +1,45 @@
+/*
+ * ======================================================================================================================
+ *  mock.cpp - Definitions behind the host mock of Device OS
+ * ======================================================================================================================
+ */
+#include "Particle.h"
+#include "SdFat.h"
+
+time32_t mock_now = 1752926400;      // 2025-07-19T12:00:00
+uint64_t mock_millis = 1000;
+uint32_t mock_free = 80 * 1024;
+bool mock_publish_ok = true;
+bool mock_serial = false;
+std::vector<std::string> mock_events;
+std::string mock_sd_root = ".";
+
+USBSerial Serial;
+USBSerial Serial1;
+TwoWire Wire;
+SPIClass SPI;
+SPIClass SPI1;
+TimeClass Time;
+SystemClass System;
+ParticleClass Particle;
+CellularClass Cellular;
+WiFiClass WiFi;
+EEPROMClass EEPROM;
+WatchdogClass Watchdog;
+
+void pinMode(int, int) {}
+int digitalRead(int) { return 0; }
+void digitalWrite(int, int) {}
+int analogRead(int) { return 0; }
+void analogWrite(int, int, int) {}
+void delay(unsigned ms) { mock_millis += ms; }
+void delayMicroseconds(unsigned) {}
+unsigned long millis() { return (unsigned long) mock_millis++; }
+unsigned long micros() { return (unsigned long) (mock_millis * 1000); }
+void attachInterrupt(int, void (*)(), int) {}
+void detachInterrupt(int) {}
+void interrupts() {}
+void noInterrupts() {}
+long random(long n) { return rand() % n; }
+long random(long a, long b) { return a + (rand() % (b - a)); }
+void randomSeed(unsigned s) { srand(s); }
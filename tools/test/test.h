@@ -0,0 +1,75 @@
+/*
+ * ======================================================================================================================
+ *  test.h - Helpers for the host tests. Include after FSM.cpp.
+ * ======================================================================================================================
+ */
+#include <string>
+#include <vector>
+
+int test_checks = 0;
+int test_fails = 0;
+
+#define CHECK(c, ...) do { test_checks++; if (!(c)) { test_fails++; if (test_fails <= 10) { \
+  printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } } while (0)
+
+/*
+ * ======================================================================================================================
+ * Test_Done() - Print the result, return the exit code
+ * ======================================================================================================================
+ */
+int Test_Done(const char *name) {
+  printf("%s: %d checks, %d failed\n", name, test_checks, test_fails);
+  return ((test_fails) ? 1 : 0);
+}
+
+/*
+ * ======================================================================================================================
+ * Test_Float() - A value as a sensor would give it, dp decimal places or fewer, sometimes the QC error value
+ * ======================================================================================================================
+ */
+float Test_Float(int s) {
+  switch (rand() % 8) {
+    case 0  : return (obs_schema[s].qc_err);
+    case 1  : return (0.0);
+    case 2  : return (-(rand() % 40000) / 100.0);
+    default : return ((rand() % 2000000) / 1000.0);
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * Test_Fill() - Queue n observations a minute apart with a random set of sensors, return the FS JSON of each
+ * ======================================================================================================================
+ */
+std::vector<std::string> Test_Fill(int n) {
+  std::vector<std::string> fs;
+  static time32_t ts = 1752926400;  // 2025-07-19T12:00:00
+  unsigned long hth = 16;
+
+  OBS_Init();
+  for (int k=0; k<n; k++) {
+    int i = OBS_Open();
+    ts += (rand() % 10) ? 60 : 60 * (1 + rand() % 30);  // Sometimes a gap
+    if ((rand() % 5) == 0) {
+      hth ^= 1UL << (rand() % 20);
+    }
+    obs[i].inuse = true;
+    obs[i].ts = ts;
+    obs[i].css = (rand() % 1000000) / 10000.0;
+    obs[i].hth = hth;
+    int every = 1 + rand() % 4;
+    for (int s=0; s<OBS_SCHEMA_CNT; s++) {
+      if ((s % every) != 0) {
+        continue;
+      }
+      switch (obs_schema[s].type) {
+        case F_OBS : OBS_SetF(i, s, Test_Float(s)); break;
+        case I_OBS : OBS_SetI(i, s, (rand() % 2001) - 1000); break;
+        case U_OBS : OBS_SetU(i, s, (unsigned long) rand() * 2); break;
+      }
+    }
+    OBS_Encode(i);
+    fs.push_back(obs_enc.buf);
+  }
+  return (fs);
+}
@@ -0,0 +1,134 @@
+/*
+ * ======================================================================================================================
+ *  test_dg.cpp - Distance gauge running median, min and max against a sort of the window, and outlier rejection
+ * ======================================================================================================================
+ */
+#include "FSM.cpp"
+#include "test.h"
+#include <algorithm>
+#include <deque>
+
+std::deque<unsigned int> window;  // The last DG_BUCKETS samples, newest at the back
+
+/*
+ * ======================================================================================================================
+ * Reference() - Median (the lower one when even), min and max of the valid samples in window, 0 if none
+ * ======================================================================================================================
+ */
+void Reference(float *median, float *min, float *max) {
+  std::vector<unsigned int> v;
+
+  for (unsigned int d : window) {
+    if (d != DG_INVALID) {
+      v.push_back(d);
+    }
+  }
+  std::sort(v.begin(), v.end());
+  *median = (v.size()) ? v[(v.size()+1)/2 - 1] : 0.0;
+  *min = (v.size()) ? v.front() : 0.0;
+  *max = (v.size()) ? v.back() : 0.0;
+}
+
+/*
+ * ======================================================================================================================
+ * Add() - Add a sample to the gauge and the window, check the gauge against the reference
+ * ======================================================================================================================
+ */
+void Add(unsigned int d, const char *what, int k) {
+  float median, min, max;
+
+  DG_Add(d);
+  window.push_back(d);
+  if (window.size() > DG_BUCKETS) {
+    window.pop_front();
+  }
+  Reference(&median, &min, &max);
+  CHECK(DistanceGauge_Median() == median, "%s %d: median %.0f, sorted %.0f", what, k, DistanceGauge_Median(), median);
+  CHECK(DistanceGauge_Min() == min, "%s %d: min %.0f, sorted %.0f", what, k, DistanceGauge_Min(), min);
+  CHECK(DistanceGauge_Max() == max, "%s %d: max %.0f, sorted %.0f", what, k, DistanceGauge_Max(), max);
+}
+
+/*
+ * ======================================================================================================================
+ * Reading() - Give DistanceGauge_TakeReading() distance d through the A4 ADC value
+ * ======================================================================================================================
+ */
+void Reading(float d) {
+  adc[ADC_A4].value = d / dg_adjustment;
+  adc[ADC_A4].ms = millis();
+  DistanceGauge_TakeReading(0);
+}
+
+int main() {
+  srand(8);
+
+  // Random values, invalid samples and steps, with few distinct values so there are ties
+  DistanceGauge_Reset();
+  for (int k=0; k<20000; k++) {
+    static unsigned int level = 1000;
+    static int p_invalid = 10;
+    static int spread = 50;
+    if ((k % 500) == 0) {
+      level = 200 + rand() % 4000;  // Step change
+      p_invalid = rand() % 60;
+      spread = 1 + rand() % 200;
+    }
+    if ((rand() % 100) < p_invalid) {
+      Add(DG_INVALID, "random", k);
+    }
+    else {
+      Add(level + rand() % spread, "random", k);
+    }
+  }
+
+  // A run of missing samples longer than the ring empties it
+  for (int k=0; k<DG_BUCKETS+5; k++) {
+    Add(DG_INVALID, "empty", k);
+  }
+  Add(1234, "empty", DG_BUCKETS+5);
+
+  // Rising and falling, the min and max queues keep the most
+  window.clear();
+  DistanceGauge_Reset();
+  for (int k=0; k<600; k++) {
+    Add((k / DG_BUCKETS) % 2 ? 5000 - k : 1000 + k, "ramp", k);
+  }
+
+  // Outliers are rejected, a step change is taken as the new level after half a ring
+  cf_dg_mad = 3;
+  DistanceGauge_Reset();
+  for (int k=0; k<3*DG_BUCKETS; k++) {
+    Reading(1000 + (rand() % 11) - 5);
+  }
+  CHECK(dg_mad_scale > 0, "no MAD after 3 minutes");
+  uint32_t rejects = dg_rejects;
+  Reading(3000);
+  CHECK(dg_rejects == rejects + 1, "spike not rejected");
+  CHECK(fabs(DistanceGauge_Median() - 1000) <= 5, "spike moved the median to %.0f", DistanceGauge_Median());
+  CHECK(DistanceGauge_Max() <= 1005, "spike is the max %.0f", DistanceGauge_Max());
+  Reading(1000);
+  CHECK(dg_reject_run == 0, "run of %d after an accepted reading", dg_reject_run);
+
+  int k;
+  for (k=0; (k<DG_BUCKETS) && (fabs(DistanceGauge_Median() - 1500) > 5); k++) {
+    Reading(1500 + (rand() % 11) - 5);
+  }
+  CHECK(k == DG_BUCKETS/2, "median at the new level after %d readings, want %d", k, DG_BUCKETS/2);
+  CHECK(DistanceGauge_Min() >= 1495, "old level still in the window, min %.0f", DistanceGauge_Min());
+  CHECK(DistanceGauge_Max() <= 1505, "spike still in the window, max %.0f", DistanceGauge_Max());
+  rejects = dg_rejects;
+  for (k=0; k<2*DG_BUCKETS; k++) {
+    Reading(1500 + (rand() % 11) - 5);
+  }
+  CHECK(dg_rejects == rejects, "%d readings at the new level rejected", (int) (dg_rejects - rejects));
+  CHECK(fabs(DistanceGauge_Median() - 1500) <= 5, "median %.0f", DistanceGauge_Median());
+
+  // Missed seconds inside a run of rejections still count as the run
+  for (k=0; k<DG_BUCKETS/2; k++) {
+    Reading(800);
+    DistanceGauge_TakeReading(1);
+  }
+  CHECK(DistanceGauge_Median() == 800, "after a step with gaps median %.0f", DistanceGauge_Median());
+
+  return (Test_Done("test_dg"));
+}
@@ -0,0 +1,127 @@
+/*
+ * ======================================================================================================================
+ *  test_fmt.cpp - FMT_Fixed() and FMT_Int() against snprintf(), FMT_TimeStamp() against gmtime() and strftime()
+ * ======================================================================================================================
+ */
+#include "FSM.cpp"
+#include "test.h"
+#include <cfloat>
+#include <climits>
+#include <cstring>
+
+/*
+ * ======================================================================================================================
+ * Fixed() - Check FMT_Fixed() of f at dp is the text of "%.*f" and the returned pointer is at its end
+ * ======================================================================================================================
+ */
+void Fixed(float f, int dp) {
+  char got[64], want[64];
+
+  char *end = FMT_Fixed(got, f, dp);
+  snprintf(want, sizeof(want), "%.*f", dp, (double) f);
+  CHECK(strcmp(got, want) == 0, "FMT_Fixed(%.9g, %d) \"%s\", want \"%s\"", (double) f, dp, got, want);
+  CHECK(end == got + strlen(got), "FMT_Fixed(%.9g, %d) end at %d of %d", (double) f, dp, (int) (end - got),
+    (int) strlen(got));
+}
+
+/*
+ * ======================================================================================================================
+ * Int() - Check FMT_Int() of v is the text of "%ld"
+ * ======================================================================================================================
+ */
+void Int(long v) {
+  char got[32], want[32];
+
+  char *end = FMT_Int(got, v);
+  snprintf(want, sizeof(want), "%ld", v);
+  CHECK(strcmp(got, want) == 0, "FMT_Int(%ld) \"%s\"", v, got);
+  CHECK(end == got + strlen(got), "FMT_Int(%ld) end at %d", v, (int) (end - got));
+}
+
+/*
+ * ======================================================================================================================
+ * Stamp() - Check FMT_TimeStamp() of t is strftime() of gmtime()
+ * ======================================================================================================================
+ */
+void Stamp(time32_t t) {
+  char got[32], want[32];
+  time_t tt = t;
+  struct tm tm;
+
+  gmtime_r(&tt, &tm);
+  strftime(want, sizeof(want), "%Y-%m-%dT%H:%M:%S", &tm);
+  FMT_TimeStamp(t, got);
+  CHECK(strcmp(got, want) == 0, "FMT_TimeStamp(%ld) \"%s\", want \"%s\"", (long) t, got, want);
+}
+
+int main() {
+  uint32_t bits;
+  float f;
+
+  srand(8);
+
+  // Edge values at every dp
+  const float edge[] = {
+    0.0f, -0.0f, 1.0f, -1.0f, 0.5f, -0.5f, 1.5f, 2.5f, -2.5f, 0.25f, 0.125f, 0.375f, -0.625f, 0.0625f, 0.03125f,
+    0.00005f, -0.00005f, 0.00004f, -0.00004f, 0.04f, -0.04f, 0.05f, -0.05f, 0.15f, 0.35f, 1.005f, 2.675f, 99.995f,
+    -99.995f, 9.99995f, 999999.5f, 1e9f, -1e9f, 4294967296.0f, 1e11f, 1e15f, -1e15f, 9.99e14f, 1e16f, 3e38f,
+    FLT_MAX, -FLT_MAX, FLT_MIN, -FLT_MIN, FLT_TRUE_MIN, 16777216.0f, 16777217.0f, 8388608.5f, -8388607.5f,
+    (float) INFINITY, (float) -INFINITY, (float) NAN, -(float) NAN, -9999.0f, 80.1234f, 1013.25f
+  };
+  for (float e : edge) {
+    for (int dp=0; dp<=4; dp++) {
+      Fixed(e, dp);
+    }
+    Fixed(e, 6);  // Past FMT_Fixed's integer math, to snprintf
+  }
+
+  // Exact ties at each dp, k + 0.5 in the last place, they round to even
+  for (int dp=0; dp<=4; dp++) {
+    for (int k=0; k<20000; k++) {
+      f = (float) ((k + 0.5) / (1 << (dp * 4)));  // A power of 2 fraction is exact, 16^dp puts the tie past dp
+      Fixed(f, dp);
+      Fixed(-f, dp);
+    }
+  }
+
+  // Sensor like values, a few decimal places
+  for (int k=0; k<1000000; k++) {
+    f = (float) ((rand() % 20000001) - 10000000) / (float) (1 + rand() % 10000);
+    Fixed(f, rand() % 5);
+  }
+
+  // Every float bit pattern in steps, every magnitude
+  for (uint64_t b=0; b<=0xffffffffULL; b+=65521) {
+    bits = (uint32_t) b;
+    memcpy(&f, &bits, sizeof(f));
+    Fixed(f, (int) (b % 5));
+  }
+
+  // FMT_Int
+  const long ints[] = {0, 1, -1, 9, 10, -10, 99, 100, INT_MAX, INT_MIN, (long) INT_MAX + 1, LONG_MAX, LONG_MIN,
+    LONG_MIN + 1};
+  for (long v : ints) {
+    Int(v);
+  }
+  for (int k=0; k<1000000; k++) {
+    Int(((long) rand() - RAND_MAX/2) >> (rand() % 31));
+  }
+
+  // FMT_TimeStamp, a date sweep 1970 to 2038, every second of some days, across midnights and backwards
+  for (time32_t t=0; t<=(INT32_MAX - 86400); t+=86400 - 1 + rand() % 3) {
+    Stamp(t);
+    Stamp(t + rand() % 86400);
+  }
+  for (time32_t t=1752883200 - 3600; t<1752883200 + 90000; t++) {  // 2025-07-19 and either side
+    Stamp(t);
+  }
+  for (time32_t t=951696000 + 86400; t>951696000 - 86400; t-=7) {  // 2000-02-28 to 2000-03-01 backwards
+    Stamp(t);
+  }
+  for (int k=0; k<100000; k++) {
+    Stamp(rand() % INT32_MAX);
+  }
+  Stamp(INT32_MAX);
+
+  return (Test_Done("test_fmt"));
+}
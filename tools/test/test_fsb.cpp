@@ -0,0 +1,47 @@
+/*
+ * ======================================================================================================================
+ *  test_fsb.cpp - FSB events published by OBS_Batch_PublishAll() expand back to the FS JSON of each observation
+ * ======================================================================================================================
+ */
+#include "FSM.cpp"
+#include "test.h"
+#include "../fsb.h"
+
+int main() {
+  int events = 0;
+  int batched = 0;
+
+  OBS_Alloc();
+  srand(4);
+  for (int round=0; round<200; round++) {
+    std::vector<std::string> want = Test_Fill(1 + (rand() % 60));
+    std::vector<std::string> got;
+
+    mock_events.clear();
+    OBS_Batch_PublishAll();
+    CHECK(obs_count == 0, "round %d: %d observations not sent", round, obs_count);
+
+    for (auto &e : mock_events) {
+      events++;
+      if (e.compare(0, 4, "FSB ") == 0) {
+        size_t before = got.size();
+        CHECK(e.size() - 4 <= OBS_BATCH_MAX_SIZE, "round %d: FSB event is %d bytes", round, (int) e.size() - 4);
+        CHECK(FSB_Expand(e.c_str() + 4, got), "round %d: bad FSB %s", round, e.c_str());
+        batched += got.size() - before;
+      }
+      else if (e.compare(0, 3, "FS ") == 0) {
+        got.push_back(e.substr(3));
+      }
+      else {
+        CHECK(false, "round %d: unexpected event %s", round, e.c_str());
+      }
+    }
+
+    CHECK(got.size() == want.size(), "round %d: %d observations, expanded to %d", round, (int) want.size(), (int) got.size());
+    for (size_t k=0; (k<got.size()) && (k<want.size()); k++) {
+      CHECK(got[k] == want[k], "round %d obs %d:\n  want %s\n  got  %s", round, (int) k, want[k].c_str(), got[k].c_str());
+    }
+  }
+  printf("%d observations in %d events\n", batched, events);
+  return (Test_Done("test_fsb"));
+}
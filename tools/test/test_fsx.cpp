@@ -0,0 +1,180 @@
+/*
+ * ======================================================================================================================
+ *  test_fsx.cpp - FSX records decode back to the FS JSON of each observation
+ *
+ *  The decoded JSON is checked against OBS_Encode() and against a printf of the values with the decimal places
+ *  JSONBufferWriter used before FSX (css 4, every F_OBS 1), so a wrong dp in obs_schema[] shows up here too.
+ * ======================================================================================================================
+ */
+#include "FSM.cpp"
+#include "test.h"
+#include "../fsx.h"
+
+/*
+ * ======================================================================================================================
+ * Unsigned_Zero() - FSX has no negative zero, turn "-0.0" values from the station in to "0.0"
+ * ======================================================================================================================
+ */
+std::string Unsigned_Zero(std::string s) {
+  size_t k = 0;
+
+  while ((k = s.find(":-0.", k)) != std::string::npos) {
+    size_t e = s.find_first_not_of('0', k+4);
+    if ((e != std::string::npos) && ((s[e] == ',') || (s[e] == '}'))) {
+      s.erase(k+1, 1);
+    }
+    k++;
+  }
+  return (s);
+}
+
+/*
+ * ======================================================================================================================
+ * Same() - Decoded JSON got is the FS JSON want. OBS_Encode() drops the members that do not fit in obs_enc.buf,
+ *          FSX has them all, so when want was cut short got only has to start with it.
+ * ======================================================================================================================
+ */
+bool Same(const std::string &got, std::string want) {
+  want = Unsigned_Zero(want);
+  if (got == want) {
+    return (true);
+  }
+  want.pop_back();  // }
+  return ((want.size() > sizeof(obs_enc.buf) - OBS_ENC_SUFFIX_SPACE - 2 - OBS_ENC_FIELD_MAX) &&
+          (got.compare(0, want.size(), want) == 0) && (got[want.size()] == ','));
+}
+
+/*
+ * ======================================================================================================================
+ * Reference() - The JSON of observation i with printf, the decimal places are the pre FSX JSONBufferWriter ones
+ * ======================================================================================================================
+ */
+std::string Reference(int i) {
+  char buf[64];
+  std::string json;
+
+  FMT_TimeStamp(obs[i].ts, buf);
+  json = std::string("{\"at\":\"") + buf + "\"";
+  snprintf(buf, sizeof(buf), ",\"css\":%.4f,\"hth\":%d", obs[i].css, (int) obs[i].hth);
+  json += buf;
+  for (int s=0; s<OBS_SCHEMA_CNT; s++) {
+    if (!OBS_Present(i, s)) {
+      continue;
+    }
+    switch (obs_schema[s].type) {
+      case F_OBS : snprintf(buf, sizeof(buf), ",\"%s\":%.1f", obs_schema[s].id, obs[i].value[s].f); break;
+      case I_OBS : snprintf(buf, sizeof(buf), ",\"%s\":%d", obs_schema[s].id, (int) obs[i].value[s].i); break;
+      case U_OBS : snprintf(buf, sizeof(buf), ",\"%s\":%d", obs_schema[s].id, (int) obs[i].value[s].u); break;
+    }
+    json += buf;
+  }
+  return (json + "}");
+}
+
+/*
+ * ======================================================================================================================
+ * Decode() - Decode base64 FSX data, append the JSON to fs
+ * ======================================================================================================================
+ */
+bool Decode(const char *b64, std::vector<std::string> &fs) {
+  std::vector<uint8_t> bin;
+
+  return (FSX_Base64(b64, bin) && FSX_Decode(bin.data(), bin.size(), fs));
+}
+
+int main() {
+  std::vector<FSX_TAG> tags;
+  uint8_t buf[8];
+  int records = 0;
+  int events = 0;
+
+  OBS_Alloc();
+
+  // Decoder table for this firmware is obs_schema[]
+  CHECK(FSX_Schema(OBS_SCHEMA_ID, tags), "no table for OBS_SCHEMA_ID %d in fsx.h", OBS_SCHEMA_ID);
+  CHECK(tags.size() == OBS_SCHEMA_CNT, "fsx.h has %d tags, obs_schema[] %d", (int) tags.size(), OBS_SCHEMA_CNT);
+  for (size_t s=0; (s<tags.size()) && (s<OBS_SCHEMA_CNT); s++) {
+    char type = (obs_schema[s].type == F_OBS) ? 'F' : (obs_schema[s].type == I_OBS) ? 'I' : 'U';
+    CHECK((tags[s].id == obs_schema[s].id) && (tags[s].type == type) && (tags[s].dp == obs_schema[s].dp),
+      "schema %d entry %d: fsx.h %s:%c%d, obs_schema[] %s:%c%d", OBS_SCHEMA_ID, (int) s,
+      tags[s].id.c_str(), tags[s].type, tags[s].dp, obs_schema[s].id, type, obs_schema[s].dp);
+  }
+
+  // Varint and zigzag at the edges
+  const int32_t edges[] = {0, 1, -1, 63, -64, 64, -65, 8191, -8192, 8192, 1000000, -1000000, INT32_MAX, INT32_MIN};
+  for (int32_t v : edges) {
+    uint32_t u;
+    size_t n = OBS_Bin_Varint(buf, OBS_Bin_Zigzag(v));
+    const uint8_t *p = buf;
+    CHECK(FSX_Varint(p, buf+n, &u) && (p == buf+n) && (FSX_Unzigzag(u) == v), "varint %d", v);
+    CHECK(!FSX_Varint(p = buf, buf+n-1, &u), "varint %d short by a byte decoded", v);
+  }
+
+  srand(5);
+  for (int round=0; round<200; round++) {
+    std::vector<std::string> want = Test_Fill(1 + (rand() % 60));
+    std::vector<std::string> got;
+
+    // One record at a time, as OBS_N2S_Add() writes them
+    for (int k=0; k<obs_count; k++) {
+      int i = (obs_head + k) % obs_slots;
+      size_t len = Base64_Encode(obs_bin, OBS_Bin_Encode(i, obs_bin), obs_batch);
+      strcpy (obs_batch+len, ",FSX");
+
+      std::vector<std::string> one;
+      CHECK(Decode(obs_batch, one) && (one.size() == 1), "round %d obs %d: bad FSX %s", round, k, obs_batch);
+      if (one.size() == 1) {
+        CHECK(Same(one[0], want[k]), "round %d obs %d:\n  want %s\n  got  %s",
+          round, k, want[k].c_str(), one[0].c_str());
+        CHECK(one[0] == Unsigned_Zero(Reference(i)), "round %d obs %d:\n  printf %s\n  got    %s",
+          round, k, Reference(i).c_str(), one[0].c_str());
+      }
+    }
+
+    // Batched events
+    cf_obs_format = OBS_FORMAT_BINARY;
+    cf_obs_batch = 1;
+    mock_events.clear();
+    OBS_Bin_PublishAll();
+    CHECK(obs_count == 0, "round %d: %d observations not sent", round, obs_count);
+    for (auto &e : mock_events) {
+      events++;
+      CHECK(e.compare(0, 4, "FSX ") == 0, "round %d: unexpected event %s", round, e.c_str());
+      CHECK(Decode(e.c_str() + 4, got), "round %d: bad FSX %s", round, e.c_str());
+    }
+    CHECK(got.size() == want.size(), "round %d: %d observations, decoded %d", round, (int) want.size(), (int) got.size());
+    for (size_t k=0; (k<got.size()) && (k<want.size()); k++) {
+      CHECK(Same(got[k], want[k]), "round %d obs %d:\n  want %s\n  got  %s",
+        round, (int) k, want[k].c_str(), got[k].c_str());
+    }
+    records += got.size();
+  }
+
+  // Values FSX can not carry decode as null, negative zero loses its sign
+  OBS_Init();
+  int i = OBS_Open();
+  obs[i].inuse = true;
+  obs[i].ts = 1752926400;
+  obs[i].css = 12.3456;
+  obs[i].hth = 16;
+  OBS_SetF(i, OBS_BT1, NAN);
+  OBS_SetF(i, OBS_BP1, 3e8);
+  OBS_SetF(i, OBS_BH1, -0.04);
+  Base64_Encode(obs_bin, OBS_Bin_Encode(i, obs_bin), obs_batch);
+  std::vector<std::string> odd;
+  CHECK(Decode(obs_batch, odd) && (odd.size() == 1), "bad FSX %s", obs_batch);
+  if (odd.size() == 1) {
+    CHECK(odd[0] == "{\"at\":\"2025-07-19T12:00:00\",\"css\":12.3456,\"hth\":16,\"bp1\":null,\"bt1\":null,\"bh1\":0.0}",
+      "NaN, out of range and negative zero: %s", odd[0].c_str());
+  }
+
+  // Truncated and unknown schema records are rejected
+  size_t len = OBS_Bin_Encode(i, obs_bin);
+  std::vector<std::string> bad;
+  CHECK(!FSX_Decode(obs_bin, len-1, bad), "truncated record decoded");
+  obs_bin[0] = 0;
+  CHECK(!FSX_Decode(obs_bin, len, bad), "schema 0 decoded");
+
+  printf("%d observations in %d events\n", records, events);
+  return (Test_Done("test_fsx"));
+}
@@ -0,0 +1,105 @@
+/*
+ * ======================================================================================================================
+ *  test_gust.cpp - The rolling gust tracker reports the same gust as the 60 bucket scan it replaced
+ *
+ *  At wind_hz=1 and wind_gust_secs=3 random speed and direction seconds go through Wind_SubSample(), and at
+ *  each observation Wind_GustUpdate() is checked against Scan_GustUpdate(), the scan from before the tracker.
+ *  Speeds are multiples of 0.25 m/s so the float sums of the scan are exact and ties break the same way.
+ * ======================================================================================================================
+ */
+#include "FSM.cpp"
+#include "test.h"
+
+/*
+ * ======================================================================================================================
+ * Scan_GustUpdate() - Wind_GustUpdate() before the tracker, highest 3 bucket average in the last 60 buckets
+ * ======================================================================================================================
+ */
+void Scan_GustUpdate(float *gust, int *gust_direction) {
+  int bucket = wind.bucket_idx; // Start at next bucket to fill (aka oldest reading)
+  float ws_sum = 0.0;
+  int ws_bucket = bucket;
+  float sum;
+
+  bool found = false;
+
+  for (int i=0; i<(WIND_READINGS-2); i++) {  // subtract 2 because we are looking ahead at the next 2 buckets
+    if (!wind.bucket[bucket].valid || 
+        !wind.bucket[(bucket+1) % WIND_READINGS].valid || 
+        !wind.bucket[(bucket+2) % WIND_READINGS].valid) {
+      bucket = (bucket + 1) % WIND_READINGS;
+      continue;
+    }
+    // sum wind speeds 
+    sum = wind.bucket[bucket].speed +
+          wind.bucket[(bucket+1) % WIND_READINGS].speed +
+          wind.bucket[(bucket+2) % WIND_READINGS].speed;
+    if (sum >= ws_sum) {
+      found = true;
+      ws_sum = sum;
+      ws_bucket = bucket;
+    }
+    bucket = (bucket + 1) % WIND_READINGS;
+  }
+  *gust = ws_sum/3;
+  
+  // Determine Gust Direction from the bucket vectors
+  int32_t NS_vector_sum = 0;
+  int32_t EW_vector_sum = 0;
+  bool ws_zero = true;
+
+  bucket = ws_bucket;
+  for (int i=0; i<3; i++) {
+    if (wind.bucket[bucket].direction == -1) {
+      ws_zero = true;
+      break;
+    }
+    if (wind.bucket[bucket].speed > 0) {
+      ws_zero = false;  
+    }
+    NS_vector_sum += wind.bucket[bucket].ns;
+    EW_vector_sum += wind.bucket[bucket].ew;
+    bucket = (bucket + 1) % WIND_READINGS;
+  }
+
+  // If all the winds speeds are 0, we have a -1 direction or no 3 seconds in a row were sampled then set -1 for direction.
+  *gust_direction = (ws_zero || !found) ? -1 : Wind_Degrees(NS_vector_sum, EW_vector_sum);
+}
+
+int main() {
+  int gusts = 0;
+  int calm = 0;
+
+  cf_wind_hz = 1;
+  cf_wind_gust_secs = 3;
+  SMP_Start();
+  CHECK((wind_hz == 1) && (gust.n == 3), "wind_hz %d gust.n %d", wind_hz, gust.n);
+
+  srand(7);
+  for (int minute=0; minute<5000; minute++) {
+    // Each minute has its own mix, some calm, some with gaps or the direction sensor offline
+    int p_invalid = rand() % 4;
+    int p_offline = ((rand() % 10) == 0) ? 5 : 0;
+    int p_zero = ((rand() % 5) == 0) ? 90 : 20;
+    int max_speed = 1 + rand() % 100;
+
+    for (int s=0; s<WIND_READINGS; s++) {
+      bool valid = (rand() % 100) >= p_invalid;
+      int raw = ((rand() % 100) < p_offline) ? -1 : rand() % WIND_COUNTS;
+      float speed = ((rand() % 100) < p_zero) ? 0.0 : (rand() % max_speed) * 0.25;
+      Wind_SubSample(valid, raw, speed);
+    }
+
+    float want;
+    int want_direction;
+    Scan_GustUpdate(&want, &want_direction);
+    Wind_GustUpdate();
+    CHECK(Wind_Gust() == want, "minute %d: gust %.4f, scan %.4f", minute, Wind_Gust(), want);
+    CHECK(Wind_GustDirection() == want_direction, "minute %d: gust %.2f direction %d, scan %d",
+      minute, want, Wind_GustDirection(), want_direction);
+    gusts += (want > 0) ? 1 : 0;
+    calm += (want_direction == -1) ? 1 : 0;
+  }
+  printf("%d minutes with a gust, %d with no gust direction\n", gusts, calm);
+  return (Test_Done("test_gust"));
+}
@@ -0,0 +1,283 @@
+/*
+ * ======================================================================================================================
+ *  test_n2s.cpp - Sealed N2S segments (n2s_compress=1) read back as the lines that were added
+ *
+ *  Lines go in with SD_NeedToSend_Add() on a mock card in a temporary directory, the segments before the tail
+ *  are sealed a block at a time with N2S_Seal(), then every segment is read with tools/n2s.h and with N2S_LZ_Line().
+ *  Prints the sealed size against the text size for a station with the usual sensors (values change a little
+ *  each minute), for random values in every sensor, and for FSX lines.
+ * ======================================================================================================================
+ */
+#include "FSM.cpp"
+#include "test.h"
+#include "../n2s.h"
+
+/*
+ * ======================================================================================================================
+ * Walk() - Move v a random step of up to step, kept in [lo, hi]
+ * ======================================================================================================================
+ */
+float Walk(float v, float step, float lo, float hi) {
+  v += step * ((rand() % 2001) - 1000) / 1000.0;
+  return ((v < lo) ? lo : (v > hi) ? hi : v);
+}
+
+/*
+ * ======================================================================================================================
+ * Station_Fill() - n minutes of a station with a battery, rain gauge, wind, BMX, HTU, SHT, MCP and SI1145
+ *                  Return each as a N2S line, FS JSON or FSX base64 by cf_obs_format
+ * ======================================================================================================================
+ */
+std::vector<std::string> Station_Fill(int n) {
+  std::vector<std::string> lines;
+  static time32_t ts = 1752926400;
+  float t = 24.0, rh = 60.0, p = 1013.2, bpc = 80.0, ws = 3.0, light = 400.0, css = 80.0;
+  int wd = 180;
+  float rgt = 0.0;
+
+  for (int k=0; k<n; k++) {
+    OBS_Init();
+    int i = OBS_Open();
+    ts += 60;
+    t = Walk(t, 0.1, -40, 60);
+    rh = Walk(rh, 0.3, 0, 100);
+    p = Walk(p, 0.05, 900, 1100);
+    bpc = Walk(bpc, 0.02, 0, 100);
+    ws = Walk(ws, 1.5, 0, 40);
+    wd = (wd + 360 + (rand() % 41) - 20) % 360;
+    light = Walk(light, 5, 0, 2000);
+    css = Walk(css, 0.5, 0, 100);
+    float rg = ((rand() % 20) == 0) ? 0.2 * (1 + rand() % 3) : 0.0;
+    rgt += rg;
+
+    obs[i].inuse = true;
+    obs[i].ts = ts;
+    obs[i].css = css;
+    obs[i].hth = 16;
+    OBS_SetI(i, OBS_BCS, 2);
+    OBS_SetF(i, OBS_BPC, bpc);
+    OBS_SetI(i, OBS_CFR, 0);
+    OBS_SetF(i, OBS_RG, rg);
+    OBS_SetF(i, OBS_RGT, rgt);
+    OBS_SetF(i, OBS_RGP, 3.4);
+    OBS_SetF(i, OBS_WS, ws);
+    OBS_SetI(i, OBS_WD, wd);
+    OBS_SetF(i, OBS_WG, ws + (rand() % 30) / 10.0);
+    OBS_SetI(i, OBS_WGD, (wd + (rand() % 21) - 10 + 360) % 360);
+    OBS_SetU(i, OBS_WGT, rand() % 60);
+    OBS_SetF(i, OBS_BP1, p);
+    OBS_SetF(i, OBS_BT1, t + 0.2);
+    OBS_SetF(i, OBS_BH1, rh - 1.0);
+    OBS_SetF(i, OBS_HH1, rh);
+    OBS_SetF(i, OBS_HT1, t);
+    OBS_SetF(i, OBS_ST1, t - 0.1);
+    OBS_SetF(i, OBS_SH1, rh + 0.5);
+    OBS_SetF(i, OBS_MT1, t + 0.1);
+    OBS_SetF(i, OBS_SV1, light);
+    OBS_SetF(i, OBS_SI1, light / 100.0);
+    OBS_SetF(i, OBS_SU1, light / 1000.0);
+    OBS_SetF(i, OBS_HI, t + 1.0);
+
+    if (cf_obs_format == OBS_FORMAT_BINARY) {
+      size_t len = Base64_Encode(obs_bin, OBS_Bin_Encode(i, obs_bin), obs_batch);
+      strcpy (obs_batch+len, ",FSX");
+      lines.push_back(obs_batch);
+    }
+    else {
+      OBS_Encode(i);
+      lines.push_back(std::string(obs_enc.buf) + ",FS");
+    }
+  }
+  return (lines);
+}
+
+/*
+ * ======================================================================================================================
+ * Between_Blocks() - Use the readers the way the drain thread and loop() can while a seal lets go of the card
+ * ======================================================================================================================
+ */
+void Between_Blocks(uint32_t seg) {
+  uint32_t next;
+
+  File fp = SD.open(N2S_SegmentName(seg), FILE_READ);
+  N2S_Reader_Start(&fp, 0);
+  N2S_Reader_Line(&next);
+  fp.close();
+  if (seg > n2s_head) {
+    fp = SD.open(N2S_SegmentName(seg-1), FILE_READ);
+    N2S_LZ_Start(&fp, 0);
+    N2S_LZ_Line(&next);
+    fp.close();
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * Tool_Read() - Lines of segment seg read off the card with tools/n2s.h
+ * ======================================================================================================================
+ */
+std::vector<std::string> Tool_Read(uint32_t seg) {
+  std::vector<std::string> lines;
+  std::vector<uint8_t> bytes;
+
+  FILE *hf = fopen(mock_sd_path(N2S_SegmentName(seg)).c_str(), "rb");
+  for (int c; (hf != NULL) && ((c = fgetc(hf)) != EOF); ) {
+    bytes.push_back(c);
+  }
+  if (hf != NULL) {
+    fclose(hf);
+  }
+  CHECK(N2S_Decode(bytes.data(), bytes.size(), lines), "segment %lu does not decode", (unsigned long) seg);
+  return (lines);
+}
+
+/*
+ * ======================================================================================================================
+ * Round_Trip() - Add lines to a new N2S store, seal all but the tail, check both decoders give the lines back
+ *                Return sealed bytes over text bytes of the sealed segments
+ * ======================================================================================================================
+ */
+double Round_Trip(const char *name, const std::vector<std::string> &want) {
+  char dir[] = "/tmp/test_n2s.XXXXXX";
+  std::vector<std::string> tool, fw;
+  uint64_t text = 0, sealed = 0;
+
+  CHECK(mkdtemp(dir) != NULL, "%s: mkdtemp", name);
+  mock_sd_root = dir;
+  n2s_head = n2s_tail = 1;
+  eeprom.n2sfp = 0;
+  N2S_Initialize();
+
+  for (auto &line : want) {
+    std::vector<char> l(line.begin(), line.end());
+    l.push_back(0);
+    SD_NeedToSend_Add(l.data());
+  }
+  N2S_Close();
+  CHECK(n2s_tail > n2s_head, "%s: only %lu segment", name, (unsigned long) n2s_tail);
+
+  for (uint32_t seg=n2s_head; seg<=n2s_tail; seg++) {
+    File fp = SD.open(N2S_SegmentName(seg), FILE_READ);
+    uint32_t before = fp.size();
+    fp.close();
+    if (seg < n2s_tail) {
+      int blocks = 1;
+      while (!N2S_Seal(seg)) {
+        blocks++;
+        Between_Blocks(seg);
+      }
+      CHECK(blocks > 1, "%s: segment %lu sealed in one call", name, (unsigned long) seg);
+      fp = SD.open(N2S_SegmentName(seg), FILE_READ);
+      CHECK(N2S_LZ_IsSealed(&fp), "%s: segment %lu not sealed", name, (unsigned long) seg);
+      text += before;
+      sealed += fp.size();
+      fp.close();
+    }
+
+    // Tool
+    for (auto &line : Tool_Read(seg)) {
+      tool.push_back(line);
+    }
+
+    // Firmware, and a restart at each line of the first block
+    if (seg < n2s_tail) {
+      std::vector<uint32_t> pos;
+      uint32_t next = 0;
+      char *line;
+
+      fp = SD.open(N2S_SegmentName(seg), FILE_READ);
+      N2S_LZ_Start(&fp, 0);
+      while ((line = N2S_LZ_Line(&next)) != NULL) {
+        fw.push_back(line);
+        pos.push_back(next);
+      }
+      CHECK(!n2s_lz.bad, "%s: segment %lu bad block", name, (unsigned long) seg);
+      size_t first = fw.size() - pos.size();
+      for (size_t k=0; (k+1<pos.size()) && (k<N2S_LZ_RECS); k++) {
+        N2S_LZ_Start(&fp, pos[k]);
+        line = N2S_LZ_Line(&next);
+        CHECK((line != NULL) && (fw[first+k+1] == line), "%s: segment %lu restart at line %d", name, (unsigned long) seg, (int) k+1);
+      }
+      fp.close();
+    }
+  }
+
+  CHECK(tool == want, "%s: n2s.h read %d of %d lines back", name, (int) tool.size(), (int) want.size());
+  std::vector<std::string> sealed_want(want.begin(), want.begin() + fw.size());
+  CHECK(fw == sealed_want, "%s: N2S_LZ_Line() read %d lines back wrong", name, (int) fw.size());
+
+  printf("%-8s %5d lines, %lu segments sealed, %llu text bytes -> %llu sealed, %.2fx\n", name, (int) want.size(),
+    (unsigned long) (n2s_tail - n2s_head), (unsigned long long) text, (unsigned long long) sealed, (double) text / sealed);
+  system((std::string("rm -rf ") + dir).c_str());
+  return ((double) text / sealed);
+}
+
+int main() {
+  std::vector<std::string> lines;
+
+  OBS_Alloc();
+  SD_exists = true;
+  srand(6);
+
+  cf_obs_format = OBS_FORMAT_JSON;
+  lines = Station_Fill(1000);
+  double station = Round_Trip("station", lines);
+  CHECK(station > 2.0, "station JSON only %.2fx", station);
+
+  lines.clear();
+  while (lines.size() < 1000) {
+    for (auto &fs : Test_Fill(50)) {
+      lines.push_back(fs + ",FS");
+    }
+  }
+  Round_Trip("random", lines);
+
+  cf_obs_format = OBS_FORMAT_BINARY;
+  Round_Trip("fsx", Station_Fill(2000));
+
+  // A segment that changes between blocks is sealed again from the start, one given up on stays text
+  char dir[] = "/tmp/test_n2s.XXXXXX";
+  CHECK(mkdtemp(dir) != NULL, "mkdtemp");
+  mock_sd_root = dir;
+  n2s_head = n2s_tail = 1;
+  eeprom.n2sfp = 0;
+  N2S_Initialize();
+  cf_obs_format = OBS_FORMAT_JSON;
+  lines = Station_Fill(400);
+  for (auto &line : lines) {
+    std::vector<char> l(line.begin(), line.end());
+    l.push_back(0);
+    SD_NeedToSend_Add(l.data());
+  }
+  N2S_Close();
+  std::vector<std::string> want = Tool_Read(n2s_head);
+  CHECK(!N2S_Seal(n2s_head) && (n2s_sealing.seg == n2s_head), "seal of the head done in one block");
+  FILE *hf = fopen(mock_sd_path(N2S_SegmentName(n2s_head)).c_str(), "ab");
+  fputs("{\"at\":\"2025-07-19T12:00:00\"},FS\r\n", hf);
+  fclose(hf);
+  want.push_back("{\"at\":\"2025-07-19T12:00:00\"},FS");
+  while (!N2S_Seal(n2s_head)) {
+  }
+  CHECK(Tool_Read(n2s_head) == want, "segment changed while sealing did not read back");
+
+  char tmp[32];
+  CHECK(!N2S_Seal(n2s_head + 1) && SD.exists(N2S_TmpName(n2s_head + 1, tmp)), "no copy after one block");
+  N2S_Seal_Drop();
+  CHECK(!SD.exists(tmp) && (n2s_sealing.seg == 0), "copy left after the seal was dropped");
+  File fp = SD.open(N2S_SegmentName(n2s_head + 1), FILE_READ);
+  CHECK(fp && !N2S_LZ_IsSealed(&fp), "dropped seal left the segment sealed");
+  fp.close();
+  system((std::string("rm -rf ") + dir).c_str());
+
+  // A corrupt block stops the tool, the lines before it are kept
+  std::vector<std::string> got;
+  std::vector<uint8_t> blk = {N2S_LZ_MAGIC, 2, 9, 0, 3, 0, 2, 'a', 'b', 'c', 1, 0, 0x80, 9, 0};
+  CHECK(!N2S_Decode(blk.data(), blk.size(), got) && (got.size() == 1), "copy past the end of the block decoded");
+  got.clear();
+  blk = {N2S_LZ_MAGIC, 1, 6, 0, 3, 0, 2, 'a', 'b', 'c', 6, 0};
+  CHECK(N2S_Decode(blk.data(), blk.size(), got) && (got.size() == 1) && (got[0] == "abc"), "one line block");
+  blk[10] = 5;
+  CHECK(!N2S_Decode(blk.data(), blk.size(), got), "block with a bad trailer decoded");
+
+  return (Test_Done("test_n2s"));
+}
@@ -0,0 +1,244 @@
+/*
+ * ======================================================================================================================
+ *  test_rain.cpp - Rain tip rate, peak intensity and first/last tip times, and their daily values in EEPROM
+ *
+ *  The clock is mock_millis with Time.now() kept in step with it. Tips go in with Rain_TipPush() as the
+ *  interrupt handler would, Rain_TipsTake() runs each second as the sampler thread does, and each minute the
+ *  observation's Rain_TipsObs() and EEPROM_RainUpdate() are checked against a scan of every tip pushed.
+ * ======================================================================================================================
+ */
+#include "FSM.cpp"
+#include "test.h"
+#include <climits>
+
+#define T0  1752904800                  // 2025-07-19T06:00:00, start of a rain day
+
+RAIN_TIPS_STR *r = &rain_tips[0];
+std::vector<uint32_t> tips;             // millis() of every tip pushed
+size_t obs_from = 0;                    // First tip since the last observation
+
+/*
+ * ======================================================================================================================
+ * At() - Move the clock to ms
+ * ======================================================================================================================
+ */
+void At(uint64_t ms) {
+  mock_millis = ms;
+  mock_now = T0 + (time32_t) (ms / 1000);
+}
+
+/*
+ * ======================================================================================================================
+ * Tip() - A tip now
+ * ======================================================================================================================
+ */
+void Tip() {
+  tips.push_back((uint32_t) mock_millis);
+  Rain_TipPush(r, (uint32_t) mock_millis);
+}
+
+/*
+ * ======================================================================================================================
+ * Start() - Empty the ring, the tip times and the day, the ring counters start at n
+ * ======================================================================================================================
+ */
+void Start(unsigned int n) {
+  memset(r, 0, sizeof(*r));
+  r->head = r->taken = r->start = n;
+  tips.clear();
+  obs_from = 0;
+  EEPROM_RainClear(-1, Time.now());
+}
+
+/*
+ * ======================================================================================================================
+ * Time_Of() - Time of a tip at ms
+ * ======================================================================================================================
+ */
+time32_t Time_Of(uint32_t ms) {
+  return (T0 + (time32_t) (ms / 1000));
+}
+
+/*
+ * ======================================================================================================================
+ * Peak() - Most tips in a RAIN_WINDOW_MS window ending at a tip since the last observation
+ * ======================================================================================================================
+ */
+int Peak() {
+  int peak = 0;
+
+  for (size_t i=obs_from; i<tips.size(); i++) {
+    int n = 0;
+    for (size_t j=0; j<=i; j++) {
+      n += ((tips[i] - tips[j]) < RAIN_WINDOW_MS) ? 1 : 0;
+    }
+    peak = (n > peak) ? n : peak;
+  }
+  return (peak);
+}
+
+/*
+ * ======================================================================================================================
+ * Rate() - mm/h from the last 2 tips and the time since the last
+ * ======================================================================================================================
+ */
+float Rate(uint32_t now_ms) {
+  if (tips.size() == 0) {
+    return (0.0);
+  }
+  uint32_t since = now_ms - tips.back();
+  uint32_t interval = (tips.size() > 1) ? tips.back() - tips[tips.size()-2] : 0;
+  if (since >= RAIN_RATE_MAX_MS) {
+    return (0.0);
+  }
+  uint32_t ms = (since > interval) ? since : interval;
+  return ((ms) ? (RAIN_TIP_MM * 3600000.0 / ms) : 0.0);
+}
+
+/*
+ * ======================================================================================================================
+ * Obs() - Take the observation's tip values, check them against the scan, add them to the day
+ * ======================================================================================================================
+ */
+void Obs(const char *what) {
+  float intensity;
+  time32_t first, last;
+
+  Rain_TipsTake(r);
+  uint32_t now_ms = (uint32_t) mock_millis;
+  float rate = Rain_Rate(r);
+  CHECK(fabs(rate - Rate(now_ms)) <= 0.001 * Rate(now_ms) + 0.01, "%s: rate %.3f, want %.3f", what, rate,
+    Rate(now_ms));
+
+  Rain_TipsObs(r, &intensity, &first, &last);
+  float want = Peak() * RAIN_TIP_MM * (3600000.0 / RAIN_WINDOW_MS);
+  CHECK(fabs(intensity - want) < 0.01, "%s: intensity %.1f, want %.1f", what, intensity, want);
+  if (obs_from == tips.size()) {
+    CHECK((first == 0) && (last == 0), "%s: no tips, first %ld last %ld", what, (long) first, (long) last);
+  }
+  else {
+    CHECK(abs(first - Time_Of(tips[obs_from])) <= 1, "%s: first %ld, want %ld", what, (long) first,
+      (long) Time_Of(tips[obs_from]));
+    CHECK(abs(last - Time_Of(tips.back())) <= 1, "%s: last %ld, want %ld", what, (long) last,
+      (long) Time_Of(tips.back()));
+  }
+  obs_from = tips.size();
+  EEPROM_RainUpdate(0, intensity, first, last);
+}
+
+int main() {
+  uint64_t ms;
+  float intensity;
+  time32_t first, last;
+
+  srand(23);
+  eeprom_valid = true;
+
+  // The rain day starts at 0600 UTC
+  CHECK(EEPROM_RainDay(T0) == T0, "rain day of 0600 is %ld", (long) EEPROM_RainDay(T0));
+  CHECK(EEPROM_RainDay(T0 - 1) == T0 - 86400, "rain day of 0559:59 is %ld", (long) EEPROM_RainDay(T0 - 1));
+  CHECK(EEPROM_RainDay(T0 + 86399) == T0, "rain day of 0559:59 next day is %ld", (long) EEPROM_RainDay(T0 + 86399));
+
+  // No tips
+  At(1000);
+  Start(0);
+  for (int k=0; k<3; k++) {
+    At(mock_millis + 60000);
+    Obs("no tips");
+  }
+  CHECK((eeprom_rain.rgi[0] == 0) && (eeprom_rain.rgf[0] == 0) && (eeprom_rain.rgl[0] == 0),
+    "no tips: day %.1f %ld %ld", eeprom_rain.rgi[0], (long) eeprom_rain.rgf[0], (long) eeprom_rain.rgl[0]);
+
+  // Rate from the interval, then from the time since the last tip, then 0
+  Tip();
+  At(mock_millis + 30000);
+  Tip();
+  At(mock_millis + 10);
+  Obs("rate");
+  CHECK(fabs(Rain_Rate(r) - 24.0) < 0.01, "rate at 30s a tip %.3f", Rain_Rate(r));
+  At(mock_millis + 90000);
+  CHECK(fabs(Rain_Rate(r) - 8.0) < 0.01, "rate 90s after the last tip %.3f", Rain_Rate(r));
+  At(mock_millis + RAIN_RATE_MAX_MS);
+  CHECK(Rain_Rate(r) == 0.0, "rate after an hour %.3f", Rain_Rate(r));
+
+  // Random showers, tips taken each second, the ring counters wrap through 0 on the way
+  At(1000);
+  Start(UINT_MAX - 500);
+  ms = mock_millis;
+  for (int s=1; s<=6*3600; s++) {
+    static int heavy = 0;
+    if ((s % 600) == 0) {
+      heavy = rand() % 4;
+    }
+    At(ms + s * 1000ULL);
+    if ((heavy > 0) && ((rand() % (5 - heavy)) == 0)) {
+      Tip();
+      if ((heavy == 3) && (rand() % 2)) {
+        At(mock_millis + 500 + rand() % 400);  // Two in this second, debounced
+        Tip();
+      }
+    }
+    Rain_TipsTake(r);
+    if ((s % 60) == 0) {
+      Obs("showers");
+    }
+  }
+  CHECK(r->head < 100000, "ring counters did not wrap, head %u", r->head);
+  CHECK(tips.size() > 1000, "only %d tips in the showers", (int) tips.size());
+
+  // More than RAIN_RING tips before a take, the oldest are overwritten
+  At(1000);
+  Start(5);
+  for (int k=0; k<300; k++) {
+    At(mock_millis + 500);
+    Tip();
+  }
+  Rain_TipsTake(r);
+  Rain_TipsObs(r, &intensity, &first, &last);
+  CHECK(r->taken == r->head, "ring not taken %u of %u", r->taken, r->head);
+  CHECK(fabs(intensity - 120 * RAIN_TIP_MM * 60) < 0.01, "full ring intensity %.1f", intensity);
+  CHECK(abs(first - Time_Of(tips[300 - RAIN_RING])) <= 1, "full ring first %ld, want %ld", (long) first,
+    (long) Time_Of(tips[300 - RAIN_RING]));
+  CHECK(abs(last - Time_Of(tips.back())) <= 1, "full ring last %ld, want %ld", (long) last, (long) Time_Of(tips.back()));
+
+  // First and last tip across the 0600 UTC rollover
+  At(86400000ULL - 180000);  // 0557
+  Start(0);
+  Tip();
+  At(mock_millis + 60000);  // 0558
+  Tip();
+  Obs("before 0600");
+  At(mock_millis + 50000);  // 0558:50
+  Tip();
+  Obs("before 0600");
+  time32_t day = eeprom_rain.day;
+  CHECK(day == T0, "day before 0600 %ld, want %ld", (long) day, (long) T0);
+  CHECK(abs(eeprom_rain.rgf[0] - Time_Of(tips[0])) <= 1, "first before 0600 %ld", (long) eeprom_rain.rgf[0]);
+  CHECK(abs(eeprom_rain.rgl[0] - Time_Of(tips[2])) <= 1, "last before 0600 %ld", (long) eeprom_rain.rgl[0]);
+  CHECK(eeprom_rain.rgi[0] > 0, "no intensity before 0600");
+
+  At(86400000ULL + 30000);  // 0600:30, no tips since, the new day starts empty
+  Obs("0600");
+  CHECK(eeprom_rain.day == T0 + 86400, "day after 0600 %ld, want %ld", (long) eeprom_rain.day, (long) T0 + 86400);
+  CHECK((eeprom_rain.rgi[0] == 0) && (eeprom_rain.rgf[0] == 0) && (eeprom_rain.rgl[0] == 0),
+    "after 0600 with no tips: %.1f %ld %ld", eeprom_rain.rgi[0], (long) eeprom_rain.rgf[0], (long) eeprom_rain.rgl[0]);
+
+  At(mock_millis + 40000);  // 0601:10
+  Tip();
+  At(mock_millis + 20000);
+  Tip();
+  Obs("after 0600");
+  CHECK(abs(eeprom_rain.rgf[0] - Time_Of(tips[3])) <= 1, "first after 0600 %ld, want %ld", (long) eeprom_rain.rgf[0],
+    (long) Time_Of(tips[3]));
+  CHECK(abs(eeprom_rain.rgl[0] - Time_Of(tips[4])) <= 1, "last after 0600 %ld, want %ld", (long) eeprom_rain.rgl[0],
+    (long) Time_Of(tips[4]));
+  CHECK(fabs(eeprom_rain.rgi[0] - 2 * RAIN_TIP_MM * 60) < 0.01, "intensity after 0600 %.1f", eeprom_rain.rgi[0]);
+
+  // What is in EEPROM is what is in memory
+  EEPROM_RAIN saved;
+  EEPROM.get(eeprom_rain_address, saved);
+  CHECK((saved.day == eeprom_rain.day) && (saved.rgf[0] == eeprom_rain.rgf[0]) && (saved.rgl[0] == eeprom_rain.rgl[0]) &&
+    (saved.rgi[0] == eeprom_rain.rgi[0]) && (saved.checksum == EEPROM_RainChecksumCompute()), "EEPROM not saved");
+
+  return (Test_Done("test_rain"));
+}
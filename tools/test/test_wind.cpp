@@ -0,0 +1,99 @@
+/*
+ * ======================================================================================================================
+ *  test_wind.cpp - The Q15 wind vector direction against double precision sin(), cos() and atan2()
+ *
+ *  Every AS5600 raw count goes through Wind_Vector() and Wind_Degrees() at random speeds, and 60 sample vector
+ *  averages summed the way the buckets are go through Wind_Degrees(). Each direction must be within 1 degree
+ *  of the whole degrees Wind_Degrees() would give the exact vector. Averages whose vectors nearly cancel are
+ *  not checked, no direction is right for them.
+ * ======================================================================================================================
+ */
+#include "FSM.cpp"
+#include "test.h"
+
+/*
+ * ======================================================================================================================
+ * Degrees() - Direction in whole degrees 0-359 of a double vector, cut down the way Wind_Degrees() does
+ * ======================================================================================================================
+ */
+double Degrees(double ns, double ew) {
+  int d = (int) (atan2(ew, ns) * 180.0 / M_PI);
+
+  return ((d < 0) ? d + 360 : d);
+}
+
+/*
+ * ======================================================================================================================
+ * Off() - Degrees between two directions
+ * ======================================================================================================================
+ */
+double Off(double a, double b) {
+  double d = fabs(a - b);
+
+  return ((d > 180.0) ? 360.0 - d : d);
+}
+
+/*
+ * ======================================================================================================================
+ * Mm() - A random speed in mm/s, 0.1 to 60 m/s, mostly light
+ * ======================================================================================================================
+ */
+int32_t Mm() {
+  return ((rand() % 4) ? 100 + rand() % 10000 : 100 + rand() % 60000);
+}
+
+int main() {
+  int32_t ns, ew;
+  double a;
+
+  srand(20);
+  Wind_Trig_Initialize();
+
+  // Every raw count, several speeds each
+  for (int raw=0; raw<WIND_COUNTS; raw++) {
+    a = 2.0 * M_PI * raw / WIND_COUNTS;
+    CHECK(abs(Wind_Sin(raw) - lround(32767.0 * sin(a))) <= 1, "raw %d: sin %d, want %.1f", raw, (int) Wind_Sin(raw),
+      32767.0 * sin(a));
+    CHECK(abs(Wind_Sin(raw + WIND_QUARTER) - lround(32767.0 * cos(a))) <= 1, "raw %d: cos %d, want %.1f", raw,
+      (int) Wind_Sin(raw + WIND_QUARTER), 32767.0 * cos(a));
+    for (int k=0; k<8; k++) {
+      int32_t mm = Mm();
+      Wind_Vector(raw, mm, &ns, &ew);
+      int d = Wind_Degrees(ns, ew);
+      double want = Degrees(mm * cos(a), mm * sin(a));
+      CHECK(Off(d, want) <= 1.0, "raw %d at %d mm/s: %d degrees, want %.0f", raw, (int) mm, d, want);
+      CHECK((d >= 0) && (d < 360), "raw %d at %d mm/s: %d degrees", raw, (int) mm, d);
+    }
+  }
+
+  // Vector averages of a minute of samples spread about a random direction
+  int skipped = 0;
+  for (int k=0; k<20000; k++) {
+    int mean = rand() % WIND_COUNTS;
+    int spread = 1 + rand() % (WIND_COUNTS / 2);
+    int32_t ns_sum = 0, ew_sum = 0;
+    double ns_exact = 0, ew_exact = 0;
+
+    for (int i=0; i<WIND_READINGS; i++) {
+      int raw = (mean + (rand() % spread) - (spread / 2)) & (WIND_COUNTS-1);
+      int32_t mm = Mm();
+      Wind_Vector(raw, mm, &ns, &ew);
+      ns_sum += ns;
+      ew_sum += ew;
+      a = 2.0 * M_PI * raw / WIND_COUNTS;
+      ns_exact += mm * cos(a);
+      ew_exact += mm * sin(a);
+    }
+    // Each component is off by at most about 2 mm/s a sample, skip when that could turn it a degree
+    if (hypot(ns_exact, ew_exact) < (2.0 * WIND_READINGS) / sin(M_PI / 360.0)) {
+      skipped++;
+      continue;
+    }
+    int d = Wind_Degrees(ns_sum, ew_sum);
+    double want = Degrees(ns_exact, ew_exact);
+    CHECK(Off(d, want) <= 1.0, "average %d about raw %d spread %d: %d degrees, want %.0f", k, mean, spread, d, want);
+  }
+  CHECK(skipped < 1000, "%d of 20000 averages skipped", skipped);
+
+  return (Test_Done("test_wind"));
+}